@@ -0,0 +1,64 @@
+// l + x and l += x append to l in place only when nothing but the stack and
+// the variable being assigned refers to it. Check that other references to
+// it never see the items appended.
+
+// another variable
+var l = [1];
+val m = l;
+l = l + [2];
+print(l, m);
+
+// a dict value
+var v = [1, 2];
+val holder = {"v": v};
+v += [3];
+print(v, holder);
+
+// a tuple
+var t = (1, 2);
+val u = t;
+t += (3,);
+print(t, u);
+
+// a list item
+var s = "ab";
+val strs = [s];
+s += "c";
+print(s, strs);
+
+// the caller's variable
+func extended(x) {
+    x += [9];
+    return x;
+}
+val mine = [7, 8];
+print(extended(mine), mine);
+
+// a closure
+func counter() {
+    var items = [0];
+    func peek() {
+        return items;
+    }
+    val before = peek();
+    items += [1];
+    return (items, before, peek());
+}
+print(counter());
+
+// no other reference: appended in place, in a loop hot enough to be compiled
+func build(n) {
+    var acc = [];
+    var text = "";
+    var kept = [];
+    for (var i = 0; i < n; i += 1) {
+        acc = acc + [i];
+        text += "x";
+        if (i % 250 == 0) {
+            kept.append(acc);
+            kept.append(text);
+        }
+    }
+    return (acc.len(), text.len(), kept[2].len(), kept[3].len(), kept[4].len());
+}
+print(build(1000));
@@ -0,0 +1,29 @@
+// typed arrays keep their items unboxed: a floatarray converts ints, a
+// bytearray only takes ints in [0, 255]. Slices copy the items.
+
+val ints = intarray([3, -1, 4, 1]);
+ints.append(5);
+ints[0] = 9;
+print(ints, ints.len(), ints.get(1), ints.sum());
+
+val floats = floatarray([1, 2, 3]);
+floats.append(4);
+floats.append(0.5);
+floats[0] = 7;
+print(floats, floats.sum());
+val pair = (2, 1.5);
+print(floatarray(pair), floatarray(3), intarray(2));
+
+val bytes = bytearray([0, 127, 128, 255]);
+bytes.append(200);
+print(bytes, bytes.sum(), bytes.min(), bytes.max());
+
+val part = ints[1:-1];
+part[0] = 100;
+print(part, ints);
+val copied = intarray(ints);
+copied.append(6);
+print(copied.len(), ints.len());
+
+// max of an empty array is an error
+print(intarray().max());
@@ -0,0 +1,64 @@
+// the batch methods of arrays run simd kernels over blocks of items and
+// scalar code over the rest. Check them against plain loops at lengths that
+// leave a tail after every block size.
+
+func check(n) {
+    val a = intarray(n);
+    val b = intarray(n);
+    for (var i = 0; i < n; i += 1) {
+        a[i] = (i * 37) % 101 - 50;
+        b[i] = i % 7;
+    }
+
+    var sum = 0, lo = a[0], hi = a[0], dot = 0, above = 0;
+    for (var i = 0; i < n; i += 1) {
+        sum += a[i];
+        dot += a[i] * b[i];
+        if (a[i] < lo) {
+            lo = a[i];
+        }
+        if (a[i] > hi) {
+            hi = a[i];
+        }
+        if (a[i] > 0) {
+            above += 1;
+        }
+    }
+
+    val scaled = a.scale(3), added = a.add(b), sums = a.cumsum(), mask = a.gt(0);
+    var same = true, running = 0;
+    for (var i = 0; i < n; i += 1) {
+        running += a[i];
+        if (scaled[i] != a[i] * 3 | added[i] != a[i] + b[i] | sums[i] != running) {
+            same = false;
+        }
+    }
+    print(n, a.sum() == sum, a.min() == lo, a.max() == hi, a.dot(b) == dot, mask.sum() == above, same);
+}
+
+val lengths = [1, 3, 5, 15, 17, 31, 33, 35, 67];
+for (var i = 0; i < lengths.len(); i += 1) {
+    check(lengths[i]);
+}
+
+// bytes of 128 and up are compared unsigned, and ints out of [0, 255] are
+// above or below all of them.
+val bytes = bytearray(35);
+for (var i = 0; i < 35; i += 1) {
+    bytes[i] = (i * 53) % 256;
+}
+bytes[33] = 128;
+bytes[34] = 255;
+print(bytes);
+val xs = [-1, 0, 127, 128, 200, 255, 256, 1000];
+for (var i = 0; i < xs.len(); i += 1) {
+    val x = xs[i];
+    print(x, bytes.lt(x).sum(), bytes.gt(x).sum(), bytes.eq(x).sum());
+}
+print(bytes.gt(127));
+
+val floats = floatarray([1, 2, 3, 4, 5]);
+print(floats.sum(), floats.min(), floats.max(), floats.scale(2), floats.cumsum(), floats.lt(3));
+
+// min of an empty array is an error
+print(bytearray().min());
@@ -0,0 +1,52 @@
+// dict literals leave their keys and values on the stack for BUILD_DICT to
+// take in pairs. Of pairs with the same key, the first one is kept.
+// list(n), dict(n) and set(n) make empty containers with room for n items.
+
+func record(i) {
+    val name = "item" + str(i);
+    return {"id": i, "name": name, "double": i * 2, "odd": i % 2 == 1, i: name, "id": -i};
+}
+
+func totals(n) {
+    var sum = 0, names = 0;
+    for (var i = 0; i < n; i += 1) {
+        val r = record(i);
+        sum += r["id"] + r["double"];
+        names += r[i].len();
+        if (r["odd"]) {
+            sum += 1;
+        }
+    }
+    return (sum, names);
+}
+
+val r = record(3);
+print(r.len(), r["id"], r["name"], r["double"], r["odd"], r[3]);
+print(totals(1000));
+
+func nested(k) {
+    return {k: {k + 1: [k, k + 2], "x": (k,)}, "empty": {}};
+}
+val n = nested(5);
+print(n[5][6], n[5]["x"], n["empty"].len(), n.len());
+
+// containers with room reserved are empty
+val l = list(100), d = dict(100), s = set(100);
+print(l, l.len(), d, d.len(), s, s.len());
+for (var i = 0; i < 5; i += 1) {
+    l.append(i);
+    d[i] = i * i;
+    s.append(i % 3);
+}
+print(l, d.len(), d[4], s.len());
+print(list(0), dict(0), set(0));
+
+// extend with lists, tuples, sets and the list itself
+val ll = [1, 2];
+ll.extend(ll);
+print(ll);
+val more = (7, 8);
+ll.extend(more);
+ll.extend({9});
+ll.extend([]);
+print(ll, ll.len());
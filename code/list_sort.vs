@@ -0,0 +1,23 @@
+// sort lists with and without key functions. The items are out of the list
+// while it is sorted, so a key function that looks at the list sees it empty.
+
+var words = [];
+for (var i = 0; i < 6; i += 1) {
+    var s = "v";
+    for (var j = 0; j < i * 5 % 6; j += 1) {
+        s += "w";
+    }
+    words.append(s);
+}
+print(words.sorted());
+
+func key(x) {
+    print("key of", x, "with", words.len(), "items in the list");
+    return x.len();
+}
+words.sort(key);
+print(words);
+
+val nums = [5, 3, 1, 4, 2];
+nums.sort();
+print(nums);
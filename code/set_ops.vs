@@ -0,0 +1,52 @@
+// set algebra on sets, frozensets, lists and tuples, and frozensets as keys.
+// Sets are printed as sorted lists, their order is the one of the table.
+
+func items(s) {
+    return list(s).sorted();
+}
+
+val a = {1, 2, 3, 4};
+val b = {3, 4, 5};
+print(items(a.union(b)), items(a.intersection(b)), items(a.difference(b)), items(a.symmetric_difference(b)));
+print(a.issubset(b), {3}.issubset(b), a.issuperset({1, 2}), a.issuperset(b), a.isdisjoint({7}), a.isdisjoint(b));
+
+// lists and tuples are taken as sets of their items
+val pair = (4, 6);
+print(items(a.union([9, 1])), items(a.intersection(pair)), items(a.difference([1, 1, 2])));
+print(items(b.symmetric_difference(pair)), a.issubset([1, 2, 3, 4, 5]), a.issuperset(pair), b.isdisjoint([1, 2]));
+
+// in place
+var c = {1, 2, 3};
+c.update([3, 4]);
+print(items(c));
+c.intersection_update({2, 3, 4, 5});
+print(items(c));
+val two = (2,);
+c.difference_update(two);
+print(items(c));
+c.symmetric_difference_update([4, 6]);
+print(items(c));
+c.symmetric_difference_update(c);
+print(items(c), c.len());
+var d = {1, 2};
+d.update(d);
+d.intersection_update(d);
+print(items(d));
+d.difference_update(d);
+print(items(d), d.len());
+
+// frozensets have the same algebra, give frozensets and hash by their items
+val f = frozenset([1, 2, 3]);
+val g = f.union({4});
+print(items(g), f.issubset(g), items(f.intersection([2, 3, 5])), f.len(), f.has(2));
+val five = (5,);
+print(frozenset(), frozenset(five));
+
+val table = {frozenset([1, 2, 3]): "abc", frozenset(): "empty"};
+val reordered = (2, 3, 1);
+print(table[frozenset([3, 1, 2])], table[frozenset(reordered)], table[frozenset()]);
+table[frozenset({3, 2, 1})] = "again";
+print(table.len(), table[f]);
+val seen = {frozenset([1, 2]), frozenset([2, 1]), frozenset([2])};
+val swapped = (2, 1);
+print(seen.len(), seen.has(frozenset(swapped)));
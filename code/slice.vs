@@ -0,0 +1,47 @@
+// slices a[i:j] with omitted, negative and out of range bounds. Slices of str
+// and tuple share the items of what they are sliced from, slices of list and
+// arrays copy them.
+
+val s = "hello, world";
+print(s[:5], s[7:], s[-5:], s[:-7], s[-5:-1], s[:], s[3:3], s[8:2], s[-100:100]);
+
+// slices of slices
+val t = s[2:10];
+print(t, t[1:-1], t[1:-1][2:], t[1:-1][2:][:-1]);
+
+// a slice keeps its chars after its parent is changed
+var p = "abcdef";
+val q = p[1:4];
+p.set(2, 'X');
+p.append('g');
+print(p, q, q.len());
+
+// a tuple slice outlives the tuple it is sliced from
+func middle(n) {
+    val base = (n, n + 1, n + 2, n + 3, n + 4);
+    return base[1:-1];
+}
+val m = middle(10);
+print(m, m[1:], m[:-1][1], m.len());
+
+// list and array slices are copies
+val l = [1, 2, 3, 4];
+val ls = l[1:3];
+ls[0] = 100;
+print(l, ls);
+val a = intarray([1, 2, 3, 4]);
+val as = a[-2:];
+as[0] = 9;
+print(a, as, floatarray([1, 2, 3])[1:], bytearray([7, 200])[:1]);
+
+// bounds computed at run time, in a loop hot enough to be compiled
+func windows(text, width) {
+    var count = 0, last = "";
+    for (var i = 0; i < 1000; i += 1) {
+        val start = i % text.len();
+        last = text[start:start + width];
+        count += last.len();
+    }
+    return (count, last);
+}
+print(windows(s, 4));
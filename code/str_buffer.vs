@@ -0,0 +1,49 @@
+// s + x appends to the buffer of s in place when s ends at the end of it, so
+// the result and s share the buffer. Each string reads only its own part, so
+// neither sees what is appended or set through the other.
+
+var s = "ab";
+s += "c";
+val a = s + "x";
+val b = s + "y";
+print(s, a, b, s.len(), a.len(), b.len());
+
+// a result appended to again, and the string it came from appended to
+val c = a + "z";
+val d = s + "w";
+print(s, a, b, c, d);
+
+// set() on the prefix, and on a string sharing its buffer
+var e = "pre";
+val f = e + "fix";
+e.set(0, 'P');
+print(e, f);
+var g = e + "!";
+g.set(0, 'Q');
+print(e, f, g);
+
+// append() on the prefix
+var h = "base";
+val i = h + "-1";
+h.append('+');
+val j = h + "-2";
+print(h, i, j);
+
+// keys built on a shared buffer hash and compare by their own chars
+var key = "k";
+val d1 = key + "1";
+val d2 = key + "2";
+val table = {d1: 1, d2: 2};
+key.append('1');
+print(table["k1"], table["k2"], table[key], table.len());
+val seen = {d1, d2, "k1"};
+print(seen.len(), seen.has(key));
+
+// a string grown in a loop shares its buffer with what was taken from it
+var grown = "";
+val parts = [];
+for (var k = 0; k < 5; k += 1) {
+    grown += str(k);
+    parts.append(grown + ".");
+}
+print(grown, parts);
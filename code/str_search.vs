@@ -0,0 +1,58 @@
+// substring search takes memchr for one char, a first and last char filter
+// over 16 chars at a time for needles shorter than 32, and Horspool for the
+// longer ones. Check locate against a plain loop for needles of each kind,
+// found near the end of the text, past the last full block of 16.
+
+func naive_locate(text, needle) {
+    val k = needle.len();
+    for (var i = 0; i + k <= text.len(); i += 1) {
+        if (text[i:i + k] == needle) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// n chars of a to d, from a linear congruential generator seeded with seed.
+func random_text(n, seed) {
+    var text = "", x = seed;
+    for (var i = 0; i < n; i += 1) {
+        x = (x * 1103515245 + 12345) % 2147483648;
+        text += str(char(97 + x / 65536 % 4));
+    }
+    return text;
+}
+
+// needles start with the only e of the text, found in the middle, where the
+// 16 char blocks cover them, and at the end or 5 chars before it, in the
+// chars left after the last block.
+val lengths = [1, 2, 3, 15, 16, 17, 31, 32, 33, 40];
+for (var i = 0; i < lengths.len(); i += 1) {
+    val k = lengths[i];
+    val needle = "e" + random_text(k - 1, k);
+    val absent = needle[:-1] + "z";
+    val middle = random_text(100 + k, 1) + needle + random_text(100, 2);
+    val at_end = random_text(200 + k, 3) + needle;
+    val near_end = random_text(200 + k, 4) + needle + "abcda";
+    print(k, middle.locate(needle), at_end.locate(needle), near_end.locate(needle), at_end.locate(absent),
+          at_end.locate(needle) == naive_locate(at_end, needle), middle.locate(needle[1:]) == naive_locate(middle, needle[1:]));
+}
+val text = random_text(203, 5);
+print(text.locate('d'), text.locate('e'), text.has('c'), text.has('e'), text.locate("dd") == naive_locate(text, "dd"));
+
+// split with separators at the ends, next to each other and overlapping
+print(",a,,b,".split(","));
+print("aaaa".split("aa"), "aaaaa".split("aa"), "abab".split("abab"));
+val long_sep = "<0123456789012345678901234567890123>";
+print(("x" + long_sep + "y" + long_sep + long_sep + "z" + long_sep).split(long_sep));
+
+// remove takes out every occurrence in one pass, runs of it included
+var word = "aabcaaadaa";
+word.remove('a');
+print(word, word.len());
+var none_removed = "bcd";
+none_removed.remove('a');
+print(none_removed);
+
+// an empty separator is an error
+print("abc".split(""));
@@ -0,0 +1,27 @@
+// test tail calls, recursion of depth 10^6 runs in a constant stack
+
+func count(n, acc) {
+    if (n == 0) {
+        return acc;
+    }
+    return count(n - 1, acc + 1);
+}
+
+var is_odd = none;
+
+func is_even(n) {
+    if (n == 0) {
+        return true;
+    }
+    return is_odd(n - 1);
+}
+
+is_odd = lambda(n) {
+    if (n == 0) {
+        return false;
+    }
+    return is_even(n - 1);
+};
+
+print(count(1000000, 0));
+print(is_even(1000000));
\ No newline at end of file
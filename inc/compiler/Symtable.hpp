@@ -1,7 +1,9 @@
 #ifndef VS_SYMTABLE_H
 #define VS_SYMTABLE_H
 
-#include "objects/VSDictObject.hpp"
+#include <vector>
+
+#include "compiler/VSASTNode.hpp"
 #include "objects/VSObject.hpp"
 
 typedef enum {
@@ -15,21 +17,38 @@ typedef enum {
 
 #define IS_LOCAL(tp) (tp == SYM_VAR || tp == SYM_VAL || tp == SYM_ARG)
 
+// id of an interned name. Names are interned per thread, and symtables are
+// only used by the thread that creates them.
+typedef vs_size_t sym_id_t;
+
+sym_id_t vs_intern(VSObject *name);
+
 class SymtableEntry : public VSObject {
 public:
     SYM_TYPE sym_type;
     VSObject *symbol;
+    sym_id_t id;
     bool is_cell;
     int index, cell_index;
+    // function bound to this name that can be inlined at call sites.
+    FuncDeclNode *inline_func;
+    // constant value of a val binding, NULL if not known at compile time.
+    VSObject *const_value;
+    // type of the value bound by a val, T_OBJECT if not known at compile time.
+    TYPE val_type;
 
     SymtableEntry(SYM_TYPE sym_type, VSObject *symbol, int index, int cell_index);
     ~SymtableEntry();
 };
 
+// scope of names, an open addressed table of entries by interned name id.
 class Symtable : public VSObject {
 private:
     Symtable *parent;
-    VSDictObject *table;
+    std::vector<SymtableEntry *> slots;
+    vs_size_t nentries;
+
+    SymtableEntry **find(sym_id_t id);
 
 public:
     Symtable(Symtable *parent);
@@ -37,11 +56,14 @@ public:
 
     bool has_parent();
     Symtable *get_parent();
-    void put(VSObject *name, SymtableEntry *entry);
+    // put entry under its symbol, replacing the entry of the same name.
+    void put(SymtableEntry *entry);
+    // entry of name in this scope, NULL if not found.
     SymtableEntry *get(VSObject *name);
+    // entry of name in this scope or the nearest enclosing one, NULL if not found.
     SymtableEntry *get_recur(VSObject *name);
     bool contains(VSObject *name);
     bool contains_recur(VSObject *name);
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -3,6 +3,7 @@
 
 #include <vector>
 
+#include "compiler/VSArena.hpp"
 #include "compiler/VSTokenizer.hpp"
 #include "objects/VSObject.hpp"
 
@@ -15,6 +16,7 @@ typedef enum {
     AST_SET_DECL,
     AST_LAMBDA_DECL,
     AST_IDX_EXPR,
+    AST_SLICE_EXPR,
     AST_DOT_EXPR,
     AST_FUNC_CALL,
     AST_B_OP_EXPR,
@@ -38,9 +40,12 @@ typedef enum {
     AST_PROGRAM
 } AST_NODE_TYPE;
 
+// nodes live in the arena of the compilation that parses them.
 class VSASTNode : public VSObject {
 public:
     AST_NODE_TYPE node_type;
+
+    ARENA_ALLOCATED
 };
 
 class IdentNode : public VSASTNode {
@@ -72,10 +77,10 @@ public:
 
 class ContainerNode : public VSASTNode {
 public:
-    std::vector<VSASTNode *> values;
+    arena_vector<VSASTNode *> values;
 
     ContainerNode() {
-        this->values = std::vector<VSASTNode *>();
+        this->values = arena_vector<VSASTNode *>();
     }
 
     ~ContainerNode() {
@@ -138,6 +143,26 @@ public:
     }
 };
 
+// obj[start:end], start and end are NULL if left out.
+class SliceExprNode : public VSASTNode {
+public:
+    VSASTNode *obj;
+    VSASTNode *start;
+    VSASTNode *end;
+
+    SliceExprNode(VSASTNode *obj, VSASTNode *start, VSASTNode *end) : obj(obj), start(start), end(end) {
+        this->node_type = AST_SLICE_EXPR;
+        INCREF(obj);
+        INCREF(start);
+        INCREF(end);
+    }
+    ~SliceExprNode() {
+        DECREF_EX(this->obj);
+        DECREF_EX(this->start);
+        DECREF_EX(this->end);
+    }
+};
+
 class DotExprNode : public VSASTNode {
 public:
     VSASTNode *obj;
@@ -261,12 +286,12 @@ public:
 class InitDeclListNode : public VSASTNode {
 public:
     TOKEN_TYPE specifier;
-    std::vector<InitDeclNode *> decls;
+    arena_vector<InitDeclNode *> decls;
 
     InitDeclListNode(TOKEN_TYPE specifier) {
         this->node_type = AST_INIT_DECL_LIST;
         this->specifier = specifier;
-        this->decls = std::vector<InitDeclNode *>();
+        this->decls = arena_vector<InitDeclNode *>();
     }
     ~InitDeclListNode() {
         for (auto decl : this->decls) {
@@ -284,13 +309,17 @@ class FuncDeclNode : public VSASTNode {
 public:
     bool va_args;
     IdentNode *name;
-    std::vector<VSASTNode *> args;
+    arena_vector<VSASTNode *> args;
     VSASTNode *body;
+    // source span of the declaration, [span_start, span_end) in bytes.
+    size_t span_start, span_end;
 
     FuncDeclNode(IdentNode *name) : name(name) {
         this->va_args = false;
+        this->span_start = 0;
+        this->span_end = 0;
         this->node_type = name != NULL ? AST_FUNC_DECL : AST_LAMBDA_DECL;
-        this->args = std::vector<VSASTNode *>();
+        this->args = arena_vector<VSASTNode *>();
         this->body = NULL;
         INCREF(name);
     }
@@ -335,12 +364,12 @@ public:
 
 class ElifListNode : public VSASTNode {
 public:
-    std::vector<IfStmtNode *> elifs;
+    arena_vector<IfStmtNode *> elifs;
     VSASTNode *elsestmt;
 
     ElifListNode() {
         this->node_type = AST_ELIF_LIST;
-        this->elifs = std::vector<IfStmtNode *>();
+        this->elifs = arena_vector<IfStmtNode *>();
         this->elsestmt = NULL;
     }
 
@@ -0,0 +1,48 @@
+#ifndef VS_ANALYSIS_H
+#define VS_ANALYSIS_H
+
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "compiler/VSASTNode.hpp"
+#include "objects/VSCodeObject.hpp"
+#include "vs.hpp"
+
+// max number of ast nodes in a function body that can be inlined
+#define VS_INLINE_BUDGET 32
+
+// immutable types whose operators are native and have no side effects, so they
+// can be evaluated at compile time.
+#define IS_FOLDABLE(obj) \
+    (IS_TYPE(obj, T_BOOL) || IS_TYPE(obj, T_INT) || IS_TYPE(obj, T_FLOAT))
+
+// evaluate an operator on constants at compile time, return a new reference,
+// or NULL if the operator can not be folded.
+VSObject *fold_u_op(OPCODE op, VSObject *operand);
+VSObject *fold_b_op(OPCODE op, VSObject *l_val, VSObject *r_val);
+
+// collect direct children of an ast node, bodies of nested functions are included.
+void ast_children(VSASTNode *node, std::vector<VSASTNode *> &children);
+// count ast nodes in a subtree.
+vs_size_t ast_size(VSASTNode *node);
+// check if name is used as an identifier in the subtree.
+bool ast_uses_name(VSASTNode *node, std::string &name);
+// check if name is assigned anywhere in the subtree.
+bool ast_assigns_name(VSASTNode *node, std::string &name);
+// collect names assigned anywhere in the subtree.
+void ast_collect_assigned(VSASTNode *node, std::unordered_set<std::string> &names);
+// collect attribute loads (not assignment targets) outside nested functions.
+void ast_collect_attr_loads(VSASTNode *node, std::vector<DotExprNode *> &loads);
+// collect multiplications outside nested functions.
+void ast_collect_muls(VSASTNode *node, std::vector<BOPNode *> &muls);
+// collect function and lambda declarations outside nested functions.
+void ast_collect_funcs(VSASTNode *node, std::vector<FuncDeclNode *> &funcs);
+// check if a function can be spliced into its call sites: small, no var args,
+// no nested functions, and only args, its own locals and builtins are referenced.
+bool ast_inlinable(FuncDeclNode *func, name_addr_map *builtins);
+// resolve the free vars of a function the way the code generator does, without
+// generating it. Return false if generating it would fail.
+bool ast_free_vars(FuncDeclNode *func, name_addr_map *builtins, std::vector<std::string> &freevars);
+
+#endif
@@ -0,0 +1,85 @@
+#ifndef VS_ARENA_H
+#define VS_ARENA_H
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "objects/VSObject.hpp"
+
+// bump allocator for the objects of one compilation, all freed at once with it.
+// It is refcounted, so objects allocated from it can outlive the compilation.
+class VSArena : public VSObject {
+private:
+    std::vector<char *> chunks;
+    char *pos;
+    char *end;
+
+public:
+    // arena that ast nodes, tokens and their vectors are allocated from,
+    // NULL if they are allocated on the heap. Each thread has its own.
+    static thread_local VSArena *current;
+
+    VSArena();
+    ~VSArena();
+
+    void *alloc(size_t size);
+};
+
+// makes a new arena current for the lifetime of the scope, then releases it.
+class VSArenaScope {
+private:
+    VSArena *arena;
+    VSArena *prev;
+
+public:
+    VSArenaScope();
+    ~VSArenaScope();
+};
+
+// allocate from the current arena, or from the heap if there is none. Memory
+// from an arena is not freed by vs_arena_free(), but with the arena.
+void *vs_arena_alloc(size_t size);
+void vs_arena_free(void *ptr);
+
+template <typename T>
+class VSArenaAllocator {
+public:
+    typedef T value_type;
+
+    VSArenaAllocator() = default;
+    template <typename U>
+    VSArenaAllocator(const VSArenaAllocator<U> &) {}
+
+    T *allocate(size_t n) {
+        return (T *)vs_arena_alloc(n * sizeof(T));
+    }
+
+    void deallocate(T *ptr, size_t) {
+        vs_arena_free(ptr);
+    }
+
+    template <typename U>
+    bool operator==(const VSArenaAllocator<U> &) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const VSArenaAllocator<U> &) const {
+        return false;
+    }
+};
+
+template <typename T>
+using arena_vector = std::vector<T, VSArenaAllocator<T>>;
+
+// class level operator new and delete of objects allocated from the current arena.
+#define ARENA_ALLOCATED                          \
+    static void *operator new(size_t size) {     \
+        return vs_arena_alloc(size);             \
+    }                                            \
+    static void operator delete(void *ptr) {     \
+        vs_arena_free(ptr);                      \
+    }
+
+#endif
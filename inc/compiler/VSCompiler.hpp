@@ -1,31 +1,105 @@
 #ifndef VS_COMPILER_H
 #define VS_COMPILER_H
 
+#include <map>
 #include <stack>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "compiler/Symtable.hpp"
+#include "compiler/VSAnalysis.hpp"
 #include "compiler/VSASTNode.hpp"
+#include "compiler/VSIR.hpp"
 #include "compiler/VSParser.hpp"
 #include "compiler/VSTokenizer.hpp"
 #include "objects/VSCodeObject.hpp"
 #include "objects/VSObject.hpp"
 
+// optimization levels: 0 for none, 1 for inlining, folding and loop
+// optimizations on the ast, 2 for ssa passes on top of them.
+#define VS_OPT_NONE 0
+#define VS_OPT_AST 1
+#define VS_OPT_SSA 2
+
+// min number of sibling functions worth compiling on worker threads.
+#define VS_PARALLEL_MIN_FUNCS 16
+
+// ast of a compilation kept alive for the bodies generated lazily, with the
+// arena it is allocated from.
+class VSLazyAST : public VSObject {
+public:
+    VSArena *arena;
+    VSASTNode *astree;
+
+    VSLazyAST(VSArena *arena, VSASTNode *astree);
+    ~VSLazyAST();
+};
+
+// function body generated on the first call of the function.
+class VSLazyFunc : public VSLazyBody {
+public:
+    FuncDeclNode *func;
+    name_addr_map *builtins;
+    int opt_level;
+    VSLazyAST *ast;
+
+    VSLazyFunc(FuncDeclNode *func, name_addr_map *builtins, int opt_level, VSLazyAST *ast);
+    ~VSLazyFunc();
+
+    void gen(VSCodeObject *code) override;
+};
+
 class VSCompiler : public VSObject {
+    friend class VSLazyFunc;
+
 private:
     name_addr_map *builtins;
+    int opt_level;
+    // file to dump the optimized ssa form to, NULL if not dumped.
+    FILE *ir_dump;
+    // max number of threads compiling function bodies.
+    int nthreads;
+    // defer the bodies of functions outside other functions to their first call.
+    bool lazy;
     std::stack<Symtable *> symtables;
     std::stack<VSCodeObject *> codeobjects;
     std::stack<name_addr_map *> namestack;
     std::stack<name_addr_map *> conststack;
     std::stack<std::vector<vs_addr_t> *> breakposes;
     std::stack<std::vector<vs_addr_t> *> continueposes;
+    // positions of "return" jumps in the function bodies being inlined.
+    std::stack<std::vector<vs_addr_t> *> inlineposes;
+    // names assigned in the function being compiled, functions bound to them
+    // can not be inlined.
+    std::unordered_set<std::string> assigned;
+    // loop invariant attribute loads hoisted into locals: (binding, attr) -> local.
+    std::map<std::pair<SymtableEntry *, std::string>, vs_addr_t> hoisted;
+    // strength reduced products of induction vars: (induction var, factor) -> local.
+    std::map<std::pair<SymtableEntry *, cint_t>, vs_addr_t> reduced;
+    // function bodies compiled ahead, or reused, taken by gen_func_decl().
+    std::unordered_map<FuncDeclNode *, VSCodeObject *> compiled;
+    // code of the functions outside other functions in the last compilation, by
+    // their source text.
+    std::unordered_map<std::string, VSCodeObject *> cache;
+    // code taken from the cache by the current compilation.
+    std::unordered_set<VSCodeObject *> reused;
 
     void do_store(OPCODE opcode, VSASTNode *lval);
     void fill_back_break_continue(vs_addr_t loop_start);
     void set_up_cellvars();
+    void move_to_head(vs_addr_t pos);
     void gen_build_func(VSCodeObject *code, bool anonymous);
+    void mark_inlinable(SymtableEntry *entry, FuncDeclNode *func);
+    void gen_inline_call(FuncDeclNode *func, VSASTNode *args);
+    VSObject *fold_const(VSASTNode *node);
+    void hoist_attr_loads(std::vector<VSASTNode *> parts, std::vector<std::pair<SymtableEntry *, std::string>> &keys);
+    bool match_iv_product(BOPNode *bop_expr, SymtableEntry *&iv, cint_t &factor);
+    SymtableEntry *get_induction_var(ForStmtNode *for_stmt, cint_t &init, cint_t &step);
+    void optimize(VSCodeObject *code);
+    void compile_funcs(VSASTNode *node, VSTokenizer *tokenizer);
+    VSCodeObject *compile(VSTokenizer *tokenizer);
+    void gen_const_value(VSObject *value);
     void gen_const(VSASTNode *node);
     void gen_ident(VSASTNode *node);
     void gen_tuple_decl(VSASTNode *node);
@@ -35,6 +109,7 @@ private:
     void gen_b_expr(VSASTNode *node);
     void gen_u_expr(VSASTNode *node);
     void gen_idx_expr(VSASTNode *node);
+    void gen_slice_expr(VSASTNode *node);
     void gen_dot_expr(VSASTNode *node);
     void gen_func_call(VSASTNode *node);
     void gen_return(VSASTNode *node);
@@ -47,6 +122,7 @@ private:
     void gen_cpd_stmt(VSASTNode *node);
     void gen_for_stmt(VSASTNode *node);
     void gen_func_decl(VSASTNode *node);
+    VSCodeObject *gen_func_body(FuncDeclNode *func, VSCodeObject *stub);
     void gen_elif_list(VSASTNode *node);
     void gen_if_stmt(VSASTNode *node);
     void gen_while_stmt(VSASTNode *node);
@@ -55,10 +131,19 @@ private:
     static std::string get_key(VSObject *value);
 
 public:
-    VSCompiler(name_addr_map *builtins);
+    // functions outside other functions whose code the last compilation took
+    // from the cache, and those it compiled or deferred anew.
+    vs_size_t nreused;
+    vs_size_t nrecompiled;
+
+    VSCompiler(name_addr_map *builtins, int opt_level, FILE *ir_dump, int nthreads, bool lazy);
     ~VSCompiler();
 
+    // functions whose text is unchanged since the last call reuse their code,
+    // so a host reloading an edited script only compiles what was edited.
     VSCodeObject *compile(std::string filename);
+    // compile source in memory
+    VSCodeObject *compile_source(std::string source);
 };
 
 #endif
\ No newline at end of file
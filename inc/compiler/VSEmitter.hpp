@@ -0,0 +1,12 @@
+#ifndef VS_EMITTER_H
+#define VS_EMITTER_H
+
+#include <stdio.h>
+
+#include "objects/VSCodeObject.hpp"
+
+// translate a compiled program to a c++ source, which builds the same code
+// objects with native bodies and runs them when linked with the runtime.
+void emit_native(FILE *file, VSCodeObject *program);
+
+#endif
@@ -0,0 +1,166 @@
+#ifndef VS_IR_H
+#define VS_IR_H
+
+#include <stdio.h>
+
+#include <unordered_map>
+#include <vector>
+
+#include "objects/VSCodeObject.hpp"
+#include "objects/VSObject.hpp"
+
+typedef enum {
+    // a bytecode instruction
+    IR_INST,
+    // merge of a local or a stack slot at block entry
+    IR_PHI,
+    // value of a local at function entry
+    IR_INIT
+} IR_KIND;
+
+// lattice of sparse conditional constant propagation, from top to bottom.
+typedef enum {
+    // not evaluated yet
+    LAT_TOP,
+    // known constant
+    LAT_CONST,
+    // known native type
+    LAT_TYPE,
+    // unknown
+    LAT_BOTTOM
+} IR_LATTICE;
+
+class IRBlock;
+
+class IRValue {
+public:
+    int id;
+    IR_KIND kind;
+    OPCODE opcode;
+    vs_addr_t operand;
+    IRBlock *block;
+    // stack operands in pop order, or phi operands in pred order.
+    std::vector<IRValue *> args;
+    // reaching definition of the local read by a LOAD_LOCAL of a promoted local.
+    IRValue *def;
+    // def-use chain, every value whose args or def refer to this one.
+    std::vector<IRValue *> users;
+    // local defined by STORE_LOCAL, phi and init, stack phis use -(slot + 1).
+    long var;
+    // phi being forwarded to the value it was simplified to.
+    IRValue *forward;
+
+    IR_LATTICE lattice;
+    // constant value if lattice is LAT_CONST, owned reference.
+    VSObject *const_value;
+    // native type if lattice is LAT_CONST or LAT_TYPE.
+    TYPE value_type;
+
+    // value has to be kept on the stack exactly where the bytecode leaves it.
+    bool pinned;
+    bool live;
+    // equivalent dominating value found by value numbering.
+    IRValue *replacement;
+    // local that keeps a copy of the value for its replaced equivalents, -1 if none.
+    long spill;
+
+    IRValue(int id, IR_KIND kind, OPCODE opcode, vs_addr_t operand, IRBlock *block);
+    ~IRValue();
+
+    bool is_stack_phi();
+    void set_const(VSObject *value);
+};
+
+class IRBlock {
+public:
+    int id;
+    // instructions in [start, end) of the original bytecode.
+    vs_addr_t start, end;
+    std::vector<IRBlock *> preds;
+    std::vector<IRBlock *> succs;
+    // successor reached by jump, and the one reached by falling through.
+    IRBlock *target;
+    IRBlock *fallthrough;
+    std::vector<IRValue *> phis;
+    std::vector<IRValue *> insts;
+    // number of values on the stack at block entry, -1 if not reachable.
+    long depth;
+
+    // ssa construction states
+    bool filled;
+    bool sealed;
+    std::unordered_map<long, IRValue *> defs;
+    std::vector<IRValue *> incomplete_phis;
+
+    // sccp states
+    bool executable;
+    std::vector<bool> pred_executable;
+
+    IRBlock *idom;
+    int rpo_index;
+    vs_addr_t new_start;
+
+    IRBlock(int id, vs_addr_t start, vs_addr_t end);
+    ~IRBlock() = default;
+};
+
+class IRFunction : public VSObject {
+private:
+    std::vector<IRValue *> values;
+    std::unordered_map<long, IRValue *> inits;
+    // locals that are never loaded as cells, so they can be renamed into ssa values.
+    std::vector<bool> promoted;
+
+    IRValue *new_value(IR_KIND kind, OPCODE opcode, vs_addr_t operand, IRBlock *block);
+    void add_use(IRValue *value, IRValue *user);
+    bool build_cfg();
+    void compute_rpo();
+    void fill_block(IRBlock *block);
+    void seal_block(IRBlock *block);
+    void write_var(long var, IRBlock *block, IRValue *value);
+    IRValue *read_var(long var, IRBlock *block);
+    IRValue *read_var_recursive(long var, IRBlock *block);
+    IRValue *add_phi_operands(IRValue *phi);
+    IRValue *try_remove_trivial_phi(IRValue *phi);
+    IRValue *get_init(long var);
+    void mark_pinned();
+
+    bool visit(IRValue *value);
+    void visit_branch(IRBlock *block, std::vector<std::pair<IRBlock *, IRBlock *>> &edges);
+    void compute_dominators();
+    bool dominates(IRValue *a, IRValue *b);
+    long value_number(IRValue *value, std::unordered_map<IRValue *, long> &numbers);
+    void mark_live(IRValue *value);
+    vs_addr_t get_const_index(VSObject *value);
+
+public:
+    // borrowed, the ir is rebuilt from and written back to it.
+    VSCodeObject *code;
+    // false if the bytecode has a shape the ir does not model, it is left as is.
+    bool valid;
+    std::vector<IRBlock *> blocks;
+    // executable blocks in reverse post order
+    std::vector<IRBlock *> rpo;
+
+    IRFunction(VSCodeObject *code);
+    ~IRFunction();
+
+    // sparse conditional constant propagation
+    void sccp();
+    // global value numbering
+    void gvn();
+    // dead code elimination
+    void dce();
+    // write optimized bytecode back to the code object
+    void emit();
+    void dump(FILE *file);
+};
+
+// check if an instruction can be removed when its value is not used.
+bool ir_is_pure(IRValue *value);
+// check if two foldable constants are the same value.
+bool ir_same_const(VSObject *a, VSObject *b);
+// number of stack values an instruction pops and pushes, ret pops the whole stack.
+void ir_stack_effect(VSInst &inst, int &npops, int &npushes);
+
+#endif
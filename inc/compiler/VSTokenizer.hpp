@@ -3,6 +3,7 @@
 
 #include <string>
 
+#include "compiler/VSArena.hpp"
 #include "objects/VSObject.hpp"
 #include "vs.hpp"
 
@@ -157,22 +158,39 @@ public:
     VSObject *tk_value;
     VSObject *literal;
     long long ln, col;
+    // source span of the token, [pos, end) in bytes.
+    size_t pos, end;
 
     VSToken(TOKEN_TYPE tk_type, VSObject *tk_value, VSObject *literal, long long ln, long long col);
     ~VSToken();
+
+    ARENA_ALLOCATED
 };
 
 class VSTokenizer : public VSObject {
 private:
-    FILE *file;
+    // source bytes in [start, end), cur is the next char to read.
+    const char *start, *end, *cur;
+    // length of the file mapping, 0 if the source is held in the string below.
+    size_t mapped_len;
+    std::string source;
+    // set once a read hits the end of source, like feof() of a stream.
+    bool at_end;
+    // end of the last token taken by gettoken().
+    size_t taken_end;
     VSToken *peek;
     long long ln, col;
 
     // char level operation
+    bool eof();
     char getchar();
     int ungetchar();
     char peekchar();
     int seek(int steps);
+    // move to stop, counting the lines and columns passed
+    void advance(const char *stop);
+    // append chars up to stop, a run with no newline in it only moves the column.
+    int append_run(std::string &str, const char *stop, bool multiline);
     static char escape(char c);
 
     // string level operation
@@ -189,12 +207,19 @@ private:
     VSToken *reco_kwd(std::string &literal);
 
 public:
+    // the file is mapped or read at once, then closed.
     VSTokenizer(FILE *file);
+    // tokenize source in memory
+    VSTokenizer(std::string source);
     ~VSTokenizer();
 
     bool hastoken();
     VSToken *gettoken();
     VSToken *peektoken();
+    // offset right after the last token taken.
+    size_t tell();
+    // source text in [from, to)
+    std::string text(size_t from, size_t to);
 };
 
 inline bool is_arith(TOKEN_TYPE opcode) {
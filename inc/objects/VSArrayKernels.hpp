@@ -0,0 +1,106 @@
+#ifndef VS_ARRAY_KERNELS_H
+#define VS_ARRAY_KERNELS_H
+
+#include "vs.hpp"
+
+// instruction sets the kernels are vectorized with.
+enum {
+    VS_SIMD_NONE,
+    VS_SIMD_SSE2,
+    VS_SIMD_AVX2
+};
+
+// comparisons of items against a scalar, into a mask of 0 and 1 bytes.
+enum {
+    VS_CMP_LT,
+    VS_CMP_GT,
+    VS_CMP_EQ
+};
+
+// kernels over the raw items of int and byte arrays, picked for the cpu at
+// startup. Reductions take at least one item.
+class VSArrayKernels {
+public:
+    int level;
+
+    cint_t (*sum_int)(const cint_t *items, vs_size_t n);
+    cint_t (*min_int)(const cint_t *items, vs_size_t n);
+    cint_t (*max_int)(const cint_t *items, vs_size_t n);
+    void (*scale_int)(cint_t *dst, const cint_t *src, vs_size_t n, cint_t k);
+    void (*add_int)(cint_t *dst, const cint_t *a, const cint_t *b, vs_size_t n);
+    void (*cmp_int)(cbyte_t *dst, const cint_t *src, vs_size_t n, cint_t x, int cmp);
+    void (*cumsum_int)(cint_t *dst, const cint_t *src, vs_size_t n);
+
+    cint_t (*sum_byte)(const cbyte_t *items, vs_size_t n);
+    cbyte_t (*min_byte)(const cbyte_t *items, vs_size_t n);
+    cbyte_t (*max_byte)(const cbyte_t *items, vs_size_t n);
+    void (*cmp_byte)(cbyte_t *dst, const cbyte_t *src, vs_size_t n, cbyte_t x, int cmp);
+};
+
+extern VSArrayKernels vs_array_kernels;
+
+// best level the cpu supports.
+int vs_simd_level();
+
+// use the kernels of level, or of the best level below it the cpu supports.
+void vs_array_kernels_select(int level);
+
+// scalar kernels, also for the items no level vectorizes.
+template <typename T, typename S>
+inline S vs_kernel_sum(const T *items, vs_size_t n) {
+    S sum = 0;
+    for (vs_size_t i = 0; i < n; i++) {
+        sum += items[i];
+    }
+    return sum;
+}
+
+template <typename T>
+inline T vs_kernel_min(const T *items, vs_size_t n) {
+    T res = items[0];
+    for (vs_size_t i = 1; i < n; i++) {
+        res = items[i] < res ? items[i] : res;
+    }
+    return res;
+}
+
+template <typename T>
+inline T vs_kernel_max(const T *items, vs_size_t n) {
+    T res = items[0];
+    for (vs_size_t i = 1; i < n; i++) {
+        res = items[i] > res ? items[i] : res;
+    }
+    return res;
+}
+
+template <typename T>
+inline void vs_kernel_scale(T *dst, const T *src, vs_size_t n, T k) {
+    for (vs_size_t i = 0; i < n; i++) {
+        dst[i] = src[i] * k;
+    }
+}
+
+template <typename T>
+inline void vs_kernel_add(T *dst, const T *a, const T *b, vs_size_t n) {
+    for (vs_size_t i = 0; i < n; i++) {
+        dst[i] = a[i] + b[i];
+    }
+}
+
+template <typename T>
+inline void vs_kernel_cmp(cbyte_t *dst, const T *src, vs_size_t n, T x, int cmp) {
+    for (vs_size_t i = 0; i < n; i++) {
+        dst[i] = cmp == VS_CMP_LT ? src[i] < x : cmp == VS_CMP_GT ? src[i] > x : src[i] == x;
+    }
+}
+
+template <typename T>
+inline void vs_kernel_cumsum(T *dst, const T *src, vs_size_t n) {
+    T sum = 0;
+    for (vs_size_t i = 0; i < n; i++) {
+        sum += src[i];
+        dst[i] = sum;
+    }
+}
+
+#endif
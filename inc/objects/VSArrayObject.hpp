@@ -0,0 +1,36 @@
+#ifndef VS_ARRAY_H
+#define VS_ARRAY_H
+
+#include <vector>
+
+#include "VSObject.hpp"
+
+extern VSObject *vs_intarray(VSObject *, VSObject *const *args, vs_size_t nargs);
+extern VSObject *vs_floatarray(VSObject *, VSObject *const *args, vs_size_t nargs);
+extern VSObject *vs_bytearray(VSObject *, VSObject *const *args, vs_size_t nargs);
+
+// array of raw ints, floats or bytes. The items are stored contiguously
+// instead of as pointers to boxed objects as in a list, and boxed only when
+// they are taken out one by one.
+template <typename T>
+class VSArrayObject : public VSObject {
+public:
+    std::vector<T> items;
+
+    VSArrayObject(vs_size_t nitems);
+    ~VSArrayObject();
+
+    bool hasattr(std::string &attrname) override;
+    VSObject *getattr(std::string &attrname) override;
+    void setattr(std::string &attrname, VSObject *attrvalue) override;
+};
+
+typedef VSArrayObject<cint_t> VSIntArrayObject;
+typedef VSArrayObject<cfloat_t> VSFloatArrayObject;
+typedef VSArrayObject<cbyte_t> VSByteArrayObject;
+
+#define AS_ARRAY(T, obj) ((VSArrayObject<T> *)obj)
+#define ARRAY_LEN(T, obj) (AS_ARRAY(T, obj)->items.size())
+#define ARRAY_GET(T, obj, idx) (AS_ARRAY(T, obj)->items[idx])
+
+#endif
@@ -17,7 +17,7 @@ public:
     static inline VSObject *TRUE() {
         if (_VS_TRUE == NULL) {
             _VS_TRUE = new VSBoolObject(1);
-            INCREF(_VS_TRUE);
+            _VS_TRUE->refcnt = VS_IMMORTAL_REFCNT;
         }
         return _VS_TRUE;
     }
@@ -25,7 +25,7 @@ public:
     static inline VSObject *FALSE() {
         if (_VS_FALSE == NULL) {
             _VS_FALSE = new VSBoolObject(0);
-            INCREF(_VS_FALSE);
+            _VS_FALSE->refcnt = VS_IMMORTAL_REFCNT;
         }
         return _VS_FALSE;
     }
@@ -1,6 +1,7 @@
 #ifndef VS_CODE_OBJECT_H
 #define VS_CODE_OBJECT_H
 
+#include <stack>
 #include <vector>
 
 #include "VSObject.hpp"
@@ -22,6 +23,29 @@ public:
 
 #define VS_FUNC_VARARGS 0x1
 
+class VSCodeObject;
+class VSTupleObject;
+
+class VSJitCode;
+class VSTraceCache;
+
+// body of a code object translated to c++ by "vs --emit-c" or to machine code
+// by the jit. It runs like VSInterpreter::exec from pc and leaves pc at the RET
+// or TAIL_CALL it stopped at. Returns false if it bailed out, then pc is the
+// instruction the interpreter goes on with.
+typedef bool (*vs_native_code)(
+    std::stack<VSObject *> &stack, vs_addr_t &pc, VSCodeObject *code,
+    VSTupleObject *locals, VSTupleObject *freevars, VSTupleObject *cellvars);
+
+// generator of a function body that is deferred until the first call.
+class VSLazyBody : public VSObject {
+public:
+    virtual ~VSLazyBody() = default;
+
+    // generate the body into code, which has only its name, flags and free vars.
+    virtual void gen(VSCodeObject *code) = 0;
+};
+
 class VSCodeObject : public VSObject {
 private:
     static const str_func_map vs_code_methods;
@@ -43,6 +67,16 @@ public:
     VSListObject *cellvars;
     VSListObject *freevars;
     std::vector<VSInst> code;
+    // deferred body, NULL if the body is generated.
+    VSLazyBody *lazy;
+    // native body, NULL if the code is interpreted.
+    vs_native_code native;
+    // calls and loop back edges counted to find hot code for the jit.
+    vs_size_t hotness;
+    // machine code the jit compiled the code to, NULL if it is not compiled.
+    VSJitCode *jit;
+    // counters and traces of the loops, NULL if none is counted yet.
+    VSTraceCache *traces;
 
     VSCodeObject(VSStringObject *name);
     ~VSCodeObject();
@@ -58,6 +92,8 @@ public:
     void add_name(VSObject *name);
     void add_cellvar(VSObject *name);
     void add_freevar(VSObject *name);
+    // generate the deferred body, if any.
+    void load();
 };
 
 #define AS_CODE(obj) ((VSCodeObject *)(obj))
@@ -8,6 +8,8 @@
 #include "objects/VSBoolObject.hpp"
 #include "objects/VSFunctionObject.hpp"
 #include "objects/VSIntObject.hpp"
+#include "objects/VSSetObject.hpp"
+#include "objects/VSStringObject.hpp"
 #include "objects/VSTupleObject.hpp"
 
 extern VSObject *vs_dict(VSObject *, VSObject *const *, vs_size_t nargs);
@@ -18,6 +20,16 @@ private:
 
     struct __dict_hash__ {
         std::size_t operator()(const VSObject *o) const {
+            // ints are their own hash, strs and frozensets keep theirs, skip
+            // the call to __hash__
+            if (IS_TYPE(o, T_INT)) {
+                return (std::size_t)INT_TO_C_INT(o);
+            } else if (IS_TYPE(o, T_STR)) {
+                return AS_STRING(o)->hash();
+            } else if (IS_TYPE(o, T_FROZENSET)) {
+                return AS_SET(o)->hash();
+            }
+
             NEW_IDENTIFIER(__hash__);
             VSObject *res = CALL_ATTR(const_cast<VSObject *>(o), ID___hash__, EMPTY_TUPLE());
             if (!IS_TYPE(res, T_INT)) {
@@ -36,6 +48,13 @@ private:
             if (a->type != b->type) {
                 return false;
             }
+            if (IS_TYPE(a, T_INT)) {
+                return INT_TO_C_INT(a) == INT_TO_C_INT(b);
+            } else if (IS_TYPE(a, T_STR)) {
+                return AS_STRING(a)->equals(AS_STRING(b));
+            } else if (IS_TYPE(a, T_FROZENSET)) {
+                return AS_SET(a)->equals(AS_SET(b));
+            }
 
             NEW_IDENTIFIER(__eq__);
             VSObject *resobj = CALL_ATTR(
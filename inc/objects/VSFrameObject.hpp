@@ -32,6 +32,9 @@ public:
         VSFrameObject *prev);
     ~VSFrameObject();
 
+    // rebind the frame to another call, locals are reused where possible.
+    void reset(VSCodeObject *code, VSTupleObject *args, VSTupleObject *cellvars, VSTupleObject *freevars);
+
     bool hasattr(std::string &attrname) override;
     VSObject *getattr(std::string &attrname) override;
     void setattr(std::string &attrname, VSObject *attrvalue) override;
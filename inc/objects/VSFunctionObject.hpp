@@ -53,6 +53,10 @@ public:
     VSObject *getattr(std::string &attrname) override;
     void setattr(std::string &attrname, VSObject *attrvalue) override;
 
+    // generate the body if it is deferred, and create the cell vars.
+    void load();
+    // check the number of args passed to the function
+    void check_args(VSTupleObject *args);
     VSObject *call(VSTupleObject *args) override;
 };
 
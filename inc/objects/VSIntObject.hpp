@@ -23,7 +23,7 @@ public:
     static inline VSObject *ZERO() {
         if (_VS_ZERO == NULL) {
             _VS_ZERO = new VSIntObject(0);
-            INCREF(_VS_ZERO);
+            _VS_ZERO->refcnt = VS_IMMORTAL_REFCNT;
         }
         return _VS_ZERO;
     }
@@ -31,7 +31,7 @@ public:
     static inline VSObject *ONE() {
         if (_VS_ONE == NULL) {
             _VS_ONE = new VSIntObject(1);
-            INCREF(_VS_ONE);
+            _VS_ONE->refcnt = VS_IMMORTAL_REFCNT;
         }
         return _VS_ONE;
     }
@@ -14,7 +14,7 @@ public:
     static inline VSObject *NONE() {
         if (_VS_NONE == NULL) {
             _VS_NONE = new VSNoneObject();
-            INCREF(_VS_NONE);
+            _VS_NONE->refcnt = VS_IMMORTAL_REFCNT;
         }
         return _VS_NONE;
     }
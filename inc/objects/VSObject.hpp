@@ -22,7 +22,11 @@ typedef enum {
     T_CELL,
     T_CODE,
     T_FRAME,
-    T_FILE
+    T_FILE,
+    T_INTARRAY,
+    T_FLOATARRAY,
+    T_BYTEARRAY,
+    T_FROZENSET
 } TYPE;
 
 static char *TYPE_STR[] = {
@@ -42,7 +46,16 @@ static char *TYPE_STR[] = {
     "cell",
     "code",
     "frame",
-    "file"};
+    "file",
+    "intarray",
+    "floatarray",
+    "bytearray",
+    "frozenset"};
+
+// refcnt of singletons. INCREF and DECREF leave it as it is, so they are never
+// freed, and threads sharing them only ever read it.
+#define VS_IMMORTAL_REFCNT ((vs_size_t)1 << 62)
+#define IS_IMMORTAL(obj) (AS_OBJECT(obj)->refcnt >= VS_IMMORTAL_REFCNT)
 
 // static string management
 #define NEW_IDENTIFIER(str) static std::string ID_##str = #str;
@@ -66,7 +79,7 @@ typedef VSObject *(*vs_native_func)(VSObject *, VSObject *const *, vs_size_t);
 typedef std::unordered_map<std::string, vs_native_func> str_func_map;
 
 inline VSObject *_NEW_REF(VSObject *obj) {
-    if (obj != NULL) {
+    if (obj != NULL && obj->refcnt < VS_IMMORTAL_REFCNT) {
         obj->refcnt++;
     }
     return obj;
@@ -75,6 +88,15 @@ inline VSObject *_NEW_REF(VSObject *obj) {
 VSObject *vs_default_hash(VSObject *self, VSObject *const *args, vs_size_t nargs);
 VSObject *vs_default_eq(VSObject *self, VSObject *const *args, vs_size_t nargs);
 
+// items [start, end) of a sequence of len items sliced by startobj and endobj,
+// each none for the bounds of the sequence or an int, counted from the end if
+// negative, and clamped to the items.
+void vs_slice_bounds(VSObject *startobj, VSObject *endobj, vs_size_t len, vs_size_t &start, vs_size_t &end);
+
+// number of items a container made by func() should have room for, given as
+// a non-negative int.
+vs_size_t vs_capacity(VSObject *capacityobj, const char *func);
+
 #define AS_OBJECT(obj) ((VSObject *)obj)
 
 #define IS_TYPE(obj, ttype) (AS_OBJECT(obj)->type == ttype)
@@ -85,11 +107,11 @@ VSObject *vs_default_eq(VSObject *self, VSObject *const *args, vs_size_t nargs);
         terminate(TERM_ERROR);                                                \
     }
 
-#define INCREF(obj)                   \
-    do {                              \
-        if (obj != NULL) {            \
-            AS_OBJECT(obj)->refcnt++; \
-        }                             \
+#define INCREF(obj)                             \
+    do {                                        \
+        if (obj != NULL && !IS_IMMORTAL(obj)) { \
+            AS_OBJECT(obj)->refcnt++;           \
+        }                                       \
     } while (0);
 
 #define INCREF_RET(obj)  \
@@ -103,50 +125,50 @@ VSObject *vs_default_eq(VSObject *self, VSObject *const *args, vs_size_t nargs);
 
 #ifdef VS_NO_GC
 
-#define DECREF(obj)                             \
+#define DECREF(obj)                               \
+    do {                                          \
+        auto _obj = obj;                          \
+        if (_obj != NULL && !IS_IMMORTAL(_obj)) { \
+            AS_OBJECT(_obj)->refcnt--;            \
+            if (AS_OBJECT(_obj)->refcnt == 0) {   \
+            }                                     \
+        }                                         \
+    } while (0);
+
+#define DECREF_EX(obj)                          \
     do {                                        \
-        auto _obj = obj;                        \
-        if (_obj != NULL) {                     \
-            AS_OBJECT(_obj)->refcnt--;          \
-            if (AS_OBJECT(_obj)->refcnt == 0) { \
+        if (obj != NULL && !IS_IMMORTAL(obj)) { \
+            AS_OBJECT(obj)->refcnt--;           \
+            if (AS_OBJECT(obj)->refcnt == 0) {  \
+                obj = NULL;                     \
             }                                   \
         }                                       \
     } while (0);
 
-#define DECREF_EX(obj)                         \
-    do {                                       \
-        if (obj != NULL) {                     \
-            AS_OBJECT(obj)->refcnt--;          \
-            if (AS_OBJECT(obj)->refcnt == 0) { \
-                obj = NULL;                    \
-            }                                  \
-        }                                      \
-    } while (0);
-
 #else
 
-#define DECREF(obj)                             \
+#define DECREF(obj)                               \
+    do {                                          \
+        auto _obj = obj;                          \
+        if (_obj != NULL && !IS_IMMORTAL(_obj)) { \
+            AS_OBJECT(_obj)->refcnt--;            \
+            if (AS_OBJECT(_obj)->refcnt == 0) {   \
+                delete _obj;                      \
+            }                                     \
+        }                                         \
+    } while (0);
+
+#define DECREF_EX(obj)                          \
     do {                                        \
-        auto _obj = obj;                        \
-        if (_obj != NULL) {                     \
-            AS_OBJECT(_obj)->refcnt--;          \
-            if (AS_OBJECT(_obj)->refcnt == 0) { \
-                delete _obj;                    \
+        if (obj != NULL && !IS_IMMORTAL(obj)) { \
+            AS_OBJECT(obj)->refcnt--;           \
+            if (AS_OBJECT(obj)->refcnt == 0) {  \
+                delete obj;                     \
+                obj = NULL;                     \
             }                                   \
         }                                       \
     } while (0);
 
-#define DECREF_EX(obj)                         \
-    do {                                       \
-        if (obj != NULL) {                     \
-            AS_OBJECT(obj)->refcnt--;          \
-            if (AS_OBJECT(obj)->refcnt == 0) { \
-                delete obj;                    \
-                obj = NULL;                    \
-            }                                  \
-        }                                      \
-    } while (0);
-
 #endif
 
 #define ERR_NO_ATTR(obj, attrname) \
@@ -8,16 +8,34 @@
 #include "objects/VSBoolObject.hpp"
 #include "objects/VSFunctionObject.hpp"
 #include "objects/VSIntObject.hpp"
+#include "objects/VSStringObject.hpp"
 #include "objects/VSTupleObject.hpp"
 
 extern VSObject *vs_set(VSObject *, VSObject *const *args, vs_size_t nargs);
+extern VSObject *vs_frozenset(VSObject *, VSObject *const *args, vs_size_t nargs);
 
 class VSSetObject : public VSObject {
 private:
     static const str_func_map vs_set_methods;
+    static const str_func_map vs_frozenset_methods;
+
+    // hash of the items of a frozenset, valid if hashed. Frozensets never
+    // change, so it is computed once.
+    std::size_t _hash;
+    bool hashed;
 
     struct __set_hash__ {
         std::size_t operator()(const VSObject *o) const {
+            // ints are their own hash, strs and frozensets keep theirs, skip
+            // the call to __hash__
+            if (IS_TYPE(o, T_INT)) {
+                return (std::size_t)INT_TO_C_INT(o);
+            } else if (IS_TYPE(o, T_STR)) {
+                return AS_STRING(o)->hash();
+            } else if (IS_TYPE(o, T_FROZENSET)) {
+                return ((VSSetObject *)o)->hash();
+            }
+
             NEW_IDENTIFIER(__hash__);
             VSObject *res = CALL_ATTR(const_cast<VSObject *>(o), ID___hash__, EMPTY_TUPLE());
             if (!IS_TYPE(res, T_INT)) {
@@ -36,6 +54,13 @@ private:
             if (a->type != b->type) {
                 return false;
             }
+            if (IS_TYPE(a, T_INT)) {
+                return INT_TO_C_INT(a) == INT_TO_C_INT(b);
+            } else if (IS_TYPE(a, T_STR)) {
+                return AS_STRING(a)->equals(AS_STRING(b));
+            } else if (IS_TYPE(a, T_FROZENSET)) {
+                return ((VSSetObject *)a)->equals((VSSetObject *)b);
+            }
 
             NEW_IDENTIFIER(__eq__);
             VSObject *resobj = CALL_ATTR(
@@ -54,9 +79,17 @@ private:
 public:
     std::unordered_set<VSObject *, __set_hash__, __set_equal_to__> _set;
 
-    VSSetObject();
+    // a frozenset if frozen, which has no methods changing it and hashes
+    // and compares by its items, so it can be a dict key.
+    VSSetObject(bool frozen = false);
     ~VSSetObject();
 
+    // hash of the items, independent of their order.
+    std::size_t hash();
+    // true if both have the same items. Sets of different sizes or different
+    // hashes, if both are known, differ without a look at the items.
+    bool equals(VSSetObject *that);
+
     bool hasattr(std::string &attrname) override;
     VSObject *getattr(std::string &attrname) override;
     void setattr(std::string &attrname, VSObject *attrvalue) override;
@@ -64,6 +97,7 @@ public:
 
 // convinient macros for set operations
 #define AS_SET(obj) ((VSSetObject *)obj)
+#define IS_SET(obj) (IS_TYPE(obj, T_SET) || IS_TYPE(obj, T_FROZENSET))
 #define SET_LEN(obj) (AS_SET(obj)->_set.size())
 #define SET_HAS(obj, item) (AS_SET(obj)->_set.find(item) != AS_SET(obj)->_set.end())
 
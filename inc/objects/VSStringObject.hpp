@@ -1,7 +1,9 @@
 #ifndef VS_STRING_H
 #define VS_STRING_H
 
+#include <memory>
 #include <string>
+#include <string_view>
 
 #include "VSObject.hpp"
 
@@ -11,12 +13,45 @@ class VSStringObject : public VSObject {
 private:
     static const str_func_map vs_str_methods;
 
-public:
     std::string _value;
+    // chars of a slice, shared with the slices it is taken from or gives.
+    // Chars are only ever appended to it, so slices never see it change.
+    // NULL once the chars are copied to _value.
+    std::shared_ptr<std::string> buffer;
+    vs_size_t start, length;
+    // hash of the chars, valid if hashed. Anything that may change the chars
+    // goes through value() or extend(), which drop it.
+    std::size_t _hash;
+    bool hashed;
 
+public:
     VSStringObject(std::string value);
+    // slice of length chars at start of buffer, without copying them.
+    VSStringObject(std::shared_ptr<std::string> buffer, vs_size_t start, vs_size_t length);
     ~VSStringObject();
 
+    // the chars, as a string to read or change, copied out of the buffer of
+    // a slice on first use.
+    std::string &value();
+    // the chars, to read without copying.
+    std::string_view view();
+    // string of the chars in [start, end), sharing the chars with this one
+    // if it is a slice.
+    VSStringObject *slice(vs_size_t start, vs_size_t end);
+    // string of the chars of this one followed by those of that, extending
+    // the buffer of this one in place if it ends there, so that building a
+    // string by repeated concatenation takes linear time.
+    VSStringObject *concat(VSStringObject *that);
+    // append the chars of that to this string, for when nobody else can
+    // see this string change.
+    void extend(VSStringObject *that);
+
+    // hash of the chars, computed once until the string is changed.
+    std::size_t hash();
+    // true if the chars are those of that. Strings of different lengths or
+    // different hashes, if both are known, differ without a look at the chars.
+    bool equals(VSStringObject *that);
+
     bool hasattr(std::string &attrname) override;
     VSObject *getattr(std::string &attrname) override;
     void setattr(std::string &attrname, VSObject *attrvalue) override;
@@ -24,12 +59,13 @@ public:
 
 #define AS_STRING(obj) ((VSStringObject *)obj)
 #define C_STRING_TO_STRING(str) (new VSStringObject(str))
-#define STRING_TO_C_STRING(obj) (AS_STRING(obj)->_value)
+#define STRING_TO_C_STRING(obj) (AS_STRING(obj)->value())
+#define STRING_VIEW(obj) (AS_STRING(obj)->view())
 
 // convinient macros for string operations
-#define STRING_LEN(obj) (AS_STRING(obj)->_value.length())
-#define STRING_GET(obj, idx) (AS_STRING(obj)->_value[idx])
-#define STRING_SET(obj, idx, val) (AS_STRING(obj)->_value[idx] = val)
-#define STRING_APPEND(obj, val) (AS_STRING(obj)->_value.push_back(val))
+#define STRING_LEN(obj) (AS_STRING(obj)->view().length())
+#define STRING_GET(obj, idx) (AS_STRING(obj)->view()[idx])
+#define STRING_SET(obj, idx, val) (AS_STRING(obj)->value()[idx] = val)
+#define STRING_APPEND(obj, val) (AS_STRING(obj)->value().push_back(val))
 
 #endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef VS_STRING_SEARCH_H
+#define VS_STRING_SEARCH_H
+
+#include <string_view>
+
+#include "vs.hpp"
+
+// needles at least this long are searched for with horspool, shorter ones
+// with the simd filter on their first and last chars.
+#define VS_SEARCH_LONG_NEEDLE 32
+
+// position of the first needle in haystack at or after from, npos if none.
+std::size_t vs_str_find(std::string_view haystack, std::string_view needle, std::size_t from = 0);
+
+// the searches vs_str_find picks from, for needles of at least 2 chars no
+// longer than haystack. The simd filter is the scalar one off x86.
+std::size_t vs_str_find_filter(const char *haystack, std::size_t n, const char *needle, std::size_t k);
+std::size_t vs_str_find_horspool(const char *haystack, std::size_t n, const char *needle, std::size_t k);
+
+#endif
@@ -14,8 +14,12 @@ private:
 public:
     vs_size_t nitems;
     VSObject **items;
+    // tuple a slice shares its items with, NULL if it owns them.
+    VSTupleObject *base;
 
     VSTupleObject(vs_size_t nitems);
+    // slice of nitems items at start of base, without copying them.
+    VSTupleObject(VSTupleObject *base, vs_size_t start, vs_size_t nitems);
     ~VSTupleObject();
 
     bool hasattr(std::string &attrname) override;
@@ -25,7 +29,7 @@ public:
     static inline VSTupleObject *EMPTY_TUPLE() {
         if (_EMPTY_TUPLE == NULL) {
             _EMPTY_TUPLE = new VSTupleObject(0);
-            INCREF(_EMPTY_TUPLE);
+            _EMPTY_TUPLE->refcnt = VS_IMMORTAL_REFCNT;
         }
         INCREF_RET(_EMPTY_TUPLE);
     }
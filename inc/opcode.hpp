@@ -44,6 +44,14 @@ typedef enum
      */
     OP_INDEX_STORE,
 
+    /* |  obj  |
+     * | start |
+     * |  end  |
+     * no arg, load the items of object (stack top) from start to end,
+     * either of which may be none
+     */
+    OP_SLICE,
+
     // 1 arg, load the local object indicated by the arg
     OP_LOAD_LOCAL,
 
@@ -96,6 +104,10 @@ typedef enum
     // no arg, call stack top
     OP_CALL_FUNC,
 
+    // no arg, call stack top in tail position, always followed by OP_RET.
+    // Calls to dynamic functions reuse the current frame.
+    OP_TAIL_CALL,
+
     // no arg, return
     OP_RET,
 
@@ -127,6 +139,7 @@ static char *OPCODE_STR[] =
         "BUILD_SET",
         "INDEX_LOAD",
         "INDEX_STORE",
+        "SLICE",
         "LOAD_LOCAL",
         "LOAD_FREE",
         "LOAD_CELL",
@@ -143,6 +156,7 @@ static char *OPCODE_STR[] =
         "JIF",
         "BUILD_FUNC",
         "CALL_FUNC",
+        "TAIL_CALL",
         "RET",
         "NOP"
     };
\ No newline at end of file
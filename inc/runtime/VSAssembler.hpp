@@ -0,0 +1,200 @@
+#ifndef VS_ASSEMBLER_H
+#define VS_ASSEMBLER_H
+
+#include <stdint.h>
+
+#include <initializer_list>
+#include <utility>
+#include <vector>
+
+#include "vs.hpp"
+
+// x86-64 registers, by their encoding.
+enum {
+    X86_RAX = 0,
+    X86_RCX = 1,
+    X86_RDX = 2,
+    X86_RBX = 3,
+    X86_RSP = 4,
+    X86_RBP = 5,
+    X86_RSI = 6,
+    X86_RDI = 7,
+    X86_R12 = 12,
+    X86_R13 = 13,
+    X86_R14 = 14,
+    X86_R15 = 15
+};
+
+// condition codes of jcc and setcc.
+enum {
+    X86_CC_E = 0x4,
+    X86_CC_NE = 0x5,
+    X86_CC_L = 0xc,
+    X86_CC_GE = 0xd,
+    X86_CC_LE = 0xe,
+    X86_CC_G = 0xf
+};
+
+// machine code buffer of the jits, with the few instructions they use.
+class VSAssembler {
+public:
+    std::vector<uint8_t> buf;
+    // rel32 fields, and the labels they jump to.
+    std::vector<std::pair<vs_size_t, vs_size_t>> fixups;
+    // offsets of the labels.
+    std::vector<vs_size_t> labels;
+
+    vs_size_t size() {
+        return buf.size();
+    }
+
+    void byte(uint8_t b) {
+        buf.push_back(b);
+    }
+
+    void bytes(std::initializer_list<uint8_t> bs) {
+        buf.insert(buf.end(), bs);
+    }
+
+    void imm32(uint32_t v) {
+        for (int i = 0; i < 4; i++) {
+            byte((v >> (i * 8)) & 0xff);
+        }
+    }
+
+    void imm64(uint64_t v) {
+        for (int i = 0; i < 8; i++) {
+            byte((v >> (i * 8)) & 0xff);
+        }
+    }
+
+    void patch(vs_size_t pos, uint32_t v) {
+        for (int i = 0; i < 4; i++) {
+            buf[pos + i] = (v >> (i * 8)) & 0xff;
+        }
+    }
+
+    // new label, bound to an offset later.
+    vs_size_t label() {
+        labels.push_back(0);
+        return labels.size() - 1;
+    }
+
+    void bind(vs_size_t label) {
+        labels[label] = buf.size();
+    }
+
+    // jmp to label, or jcc if cc is not negative.
+    void jump(int cc, vs_size_t label) {
+        if (cc >= 0) {
+            bytes({0x0f, (uint8_t)(0x80 | cc)});
+        } else {
+            byte(0xe9);
+        }
+        fixups.push_back({buf.size(), label});
+        imm32(0);
+    }
+
+    // patch the jumps with the offsets of their labels.
+    void link() {
+        for (auto &fixup : fixups) {
+            patch(fixup.first, labels[fixup.second] - (fixup.first + 4));
+        }
+    }
+
+    void push(int reg) {
+        if (reg >= 8) {
+            byte(0x41);
+        }
+        byte(0x50 | (reg & 7));
+    }
+
+    void pop(int reg) {
+        if (reg >= 8) {
+            byte(0x41);
+        }
+        byte(0x58 | (reg & 7));
+    }
+
+    void ret() {
+        byte(0xc3);
+    }
+
+    // mov dst, src
+    void mov(int dst, int src) {
+        byte(0x48 | (src >= 8 ? 4 : 0) | (dst >= 8 ? 1 : 0));
+        byte(0x89);
+        byte(0xc0 | (src & 7) << 3 | (dst & 7));
+    }
+
+    // mov reg, imm64
+    void mov_imm(int reg, uint64_t imm) {
+        byte(0x48 | (reg >= 8 ? 1 : 0));
+        byte(0xb8 | (reg & 7));
+        imm64(imm);
+    }
+
+    // mov reg, [base + disp] or mov [base + disp], reg, base is not rsp or r12.
+    void load(int reg, int base, int32_t disp) {
+        mem_op(0x8b, reg, base, disp);
+    }
+
+    void store(int base, int32_t disp, int reg) {
+        mem_op(0x89, reg, base, disp);
+    }
+
+    // lea reg, [base + disp]
+    void lea(int reg, int base, int32_t disp) {
+        mem_op(0x8d, reg, base, disp);
+    }
+
+    // mov qword [base + disp], imm32, sign extended
+    void store_imm(int base, int32_t disp, int32_t imm) {
+        byte(0x48 | (base >= 8 ? 1 : 0));
+        byte(0xc7);
+        byte(0x80 | (base & 7));
+        imm32(disp);
+        imm32(imm);
+    }
+
+    // op dst, src for add (0x01), sub (0x29), cmp (0x39) and test (0x85).
+    void alu(uint8_t op, int dst, int src) {
+        byte(0x48 | (src >= 8 ? 4 : 0) | (dst >= 8 ? 1 : 0));
+        byte(op);
+        byte(0xc0 | (src & 7) << 3 | (dst & 7));
+    }
+
+    // test al, al, for the bools helpers return.
+    void test_al() {
+        bytes({0x84, 0xc0});
+    }
+
+    // imul dst, src
+    void imul(int dst, int src) {
+        byte(0x48 | (dst >= 8 ? 4 : 0) | (src >= 8 ? 1 : 0));
+        bytes({0x0f, 0xaf});
+        byte(0xc0 | (dst & 7) << 3 | (src & 7));
+    }
+
+    // setcc al; movzx eax, al
+    void setcc(int cc) {
+        bytes({0x0f, (uint8_t)(0x90 | cc), 0xc0});
+        bytes({0x0f, 0xb6, 0xc0});
+    }
+
+    // call func, through rax
+    void call(void *func) {
+        mov_imm(X86_RAX, (uint64_t)func);
+        bytes({0xff, 0xd0});
+    }
+
+private:
+    void mem_op(uint8_t op, int reg, int base, int32_t disp) {
+        byte(0x48 | (reg >= 8 ? 4 : 0) | (base >= 8 ? 1 : 0));
+        byte(op);
+        byte(0x80 | (reg & 7) << 3 | (base & 7));
+        imm32(disp);
+    }
+};
+
+#endif
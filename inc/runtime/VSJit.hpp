@@ -0,0 +1,51 @@
+#ifndef VS_JIT_H
+#define VS_JIT_H
+
+#include "objects/VSCodeObject.hpp"
+
+// calls and back edges after which a code object is compiled to machine code.
+#ifndef VS_JIT_THRESHOLD
+#define VS_JIT_THRESHOLD 1000
+#endif
+
+// baseline jit for x86-64. The machine code of a code object is stitched from
+// a template per opcode, which calls the same ops as the interpreter does, so
+// only the dispatch between instructions is compiled away.
+class VSJitCode {
+public:
+    // mmapped machine code, the jump table of the instructions follows it.
+    char *mem;
+    vs_size_t size;
+    // entry, called with the frame and the pc to start at.
+    void *entry;
+};
+
+// false to force interpretation, for debugging.
+extern bool vs_jit_enabled;
+
+// write /tmp/perf-<pid>.map for profilers to symbolize the machine code.
+void vs_jit_perf_map(bool enabled);
+
+// compile code to machine code and set it as the native code of it. Returns
+// false if it can not be compiled on this platform.
+bool vs_jit_compile(VSCodeObject *code);
+void vs_jit_free(VSJitCode *jit);
+
+// writable memory for machine code, and making it executable once written.
+// name is the symbol of its first code_size bytes for profilers.
+char *vs_jit_alloc(vs_size_t size);
+void vs_jit_seal(char *mem, vs_size_t size, vs_size_t code_size, std::string name);
+
+// count a call or back edge of code and compile it once it is hot. Returns
+// true if the code has native code to run.
+inline bool vs_jit_tick(VSCodeObject *code) {
+    if (code->native != NULL) {
+        return true;
+    }
+    if (!vs_jit_enabled || ++code->hotness != VS_JIT_THRESHOLD) {
+        return false;
+    }
+    return vs_jit_compile(code);
+}
+
+#endif
@@ -0,0 +1,428 @@
+#ifndef VS_OPS_H
+#define VS_OPS_H
+
+#include "objects/VSCellObject.hpp"
+#include "objects/VSDictObject.hpp"
+#include "objects/VSFunctionObject.hpp"
+#include "objects/VSListObject.hpp"
+#include "objects/VSSetObject.hpp"
+#include "objects/VSStringObject.hpp"
+#include "objects/VSTupleObject.hpp"
+#include "runtime/VSInterpreter.hpp"
+#include "runtime/builtins.hpp"
+
+// semantics of the opcodes, shared by the interpreter and the c++ translated
+// from bytecode by "vs --emit-c". Each takes its operands from the compute stack
+// and pushes its result there.
+
+NEW_IDENTIFIER(__hash__);
+NEW_IDENTIFIER(__lt__);
+NEW_IDENTIFIER(__gt__);
+NEW_IDENTIFIER(__le__);
+NEW_IDENTIFIER(__ge__);
+NEW_IDENTIFIER(__eq__);
+NEW_IDENTIFIER(__str__);
+NEW_IDENTIFIER(__bytes__);
+NEW_IDENTIFIER(__call__);
+NEW_IDENTIFIER(__neg__);
+NEW_IDENTIFIER(__add__);
+NEW_IDENTIFIER(__sub__);
+NEW_IDENTIFIER(__mul__);
+NEW_IDENTIFIER(__div__);
+NEW_IDENTIFIER(__mod__);
+NEW_IDENTIFIER(__not__);
+NEW_IDENTIFIER(__and__);
+NEW_IDENTIFIER(__or__);
+NEW_IDENTIFIER(__xor__);
+NEW_IDENTIFIER(__bool__);
+NEW_IDENTIFIER(__char__);
+NEW_IDENTIFIER(__int__);
+NEW_IDENTIFIER(__float__);
+NEW_IDENTIFIER(get);
+NEW_IDENTIFIER(set);
+NEW_IDENTIFIER(slice);
+
+inline VSObject *_stack_pop(cpt_stack_t &stack) {
+    if (stack.empty()) {
+        err("Internal error: unexpected empty compute stack");
+        terminate(TERM_ERROR);
+    }
+
+    VSObject *value = stack.top(); stack.pop();
+    return value;
+}
+
+inline void _stack_push(cpt_stack_t &stack, VSObject *value) {
+    if (value == NULL) {
+        err("Internal error: pushing NULL into compute stack");
+        terminate(TERM_ERROR);
+    }
+
+    stack.push(value);
+    return;
+}
+
+#define STACK_TOP(stack) (stack.top())
+#define STACK_POP(stack) _stack_pop(stack)
+#define STACK_PUSH(stack, value) _stack_push(stack, value)
+#define STACK_PUSH_INCREF(stack, value) \
+    do {                                \
+        auto __value = (value);         \
+        _stack_push(stack, __value);    \
+        INCREF(__value);                \
+    } while (0);
+
+inline void vs_op_pop(cpt_stack_t &stack) {
+    VSObject *top = STACK_POP(stack);
+    DECREF_EX(top);
+}
+
+// binary operators call the method of the left operand with the right one.
+inline void vs_op_binary(cpt_stack_t &stack, std::string &method) {
+    VSObject *l_val = STACK_POP(stack);
+    VSObject *r_val = STACK_POP(stack);
+    VSObject *res = CALL_ATTR(l_val, method, vs_tuple_pack(1, r_val));
+    STACK_PUSH(stack, res);
+    DECREF(l_val);
+    DECREF(r_val);
+}
+
+// 1 + the local the result of the add at pc is stored to right after it,
+// 0 if it is not stored to a local.
+inline vs_addr_t vs_add_dest(VSCodeObject *code, vs_addr_t pc) {
+    if (pc + 1 < code->ninsts && code->code[pc + 1].opcode == OP_STORE_LOCAL) {
+        return code->code[pc + 1].operand + 1;
+    }
+    return 0;
+}
+
+// append r_val to l_val, a str, list or tuple, true if done.
+inline bool vs_add_in_place(VSObject *l_val, VSObject *r_val) {
+    if (l_val->type != r_val->type) {
+        return false;
+    }
+
+    switch (l_val->type) {
+        case T_STR:
+            AS_STRING(l_val)->extend(AS_STRING(r_val));
+            return true;
+        case T_LIST: {
+            auto &items = AS_LIST(l_val)->items;
+            vs_size_t nitems = items.size();
+            items.insert(items.end(), AS_LIST(r_val)->items.begin(), AS_LIST(r_val)->items.end());
+            for (vs_size_t i = nitems; i < items.size(); i++) {
+                INCREF(items[i]);
+            }
+            return true;
+        }
+        case T_TUPLE: {
+            VSTupleObject *tuple = AS_TUPLE(l_val);
+            VSTupleObject *that = AS_TUPLE(r_val);
+            if (that->nitems == 0) {
+                return true;
+            }
+            // slices do not own their items
+            if (tuple->base != NULL) {
+                return false;
+            }
+
+            size_t size = sizeof(VSObject *) * (tuple->nitems + that->nitems);
+            VSObject **items = (VSObject **)realloc(tuple->items, size);
+            if (items == NULL) {
+                err("unable to realloc memory of size: %lu\n", size);
+                terminate(TERM_ERROR);
+            }
+            for (vs_size_t i = 0; i < that->nitems; i++) {
+                items[tuple->nitems + i] = that->items[i];
+                INCREF(that->items[i]);
+            }
+            tuple->items = items;
+            tuple->nitems += that->nitems;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// l_val + r_val. If nobody but the compute stack holds l_val, or else only
+// the local at dest - 1 the sum is stored to next, nobody can see l_val change,
+// so r_val is appended to it in place instead of copying l_val.
+inline void vs_op_add(cpt_stack_t &stack, VSTupleObject *locals, vs_size_t nlocals, vs_addr_t dest) {
+    VSObject *l_val = stack.empty() ? NULL : stack.top();
+    vs_size_t nowners = 1;
+    if (dest != 0 && dest <= nlocals) {
+        VSCellObject *cell = AS_CELL(TUPLE_GET(locals, dest - 1));
+        nowners += cell->mut && cell->item == l_val;
+    }
+    if (l_val == NULL || l_val->refcnt > nowners) {
+        vs_op_binary(stack, ID___add__);
+        return;
+    }
+
+    STACK_POP(stack);
+    VSObject *r_val = STACK_POP(stack);
+    if (vs_add_in_place(l_val, r_val)) {
+        STACK_PUSH(stack, l_val);
+    } else {
+        STACK_PUSH(stack, CALL_ATTR(l_val, ID___add__, vs_tuple_pack(1, r_val)));
+        DECREF(l_val);
+    }
+    DECREF(r_val);
+}
+
+inline void vs_op_neq(cpt_stack_t &stack) {
+    VSObject *l_val = STACK_POP(stack);
+    VSObject *r_val = STACK_POP(stack);
+    VSObject *temp = CALL_ATTR(l_val, ID___eq__, vs_tuple_pack(1, r_val));
+    VSObject *res = CALL_ATTR(temp, ID___not__, EMPTY_TUPLE());
+    STACK_PUSH(stack, res);
+    DECREF(l_val);
+    DECREF(r_val);
+    DECREF(temp);
+}
+
+inline void vs_op_unary(cpt_stack_t &stack, std::string &method) {
+    VSObject *val = STACK_POP(stack);
+    VSObject *res = CALL_ATTR(val, method, EMPTY_TUPLE());
+    STACK_PUSH(stack, res);
+    DECREF(val);
+}
+
+inline void vs_op_build_tuple(cpt_stack_t &stack, vs_size_t nitems) {
+    VSTupleObject *tuple = new VSTupleObject(nitems);
+    for (vs_size_t i = 0; i < nitems; i++) {
+        VSObject *item = STACK_POP(stack);
+        tuple->items[i] = item;
+    }
+    STACK_PUSH_INCREF(stack, tuple);
+}
+
+inline void vs_op_build_list(cpt_stack_t &stack, vs_size_t nitems) {
+    VSListObject *list = new VSListObject(nitems);
+    for (vs_size_t i = 0; i < nitems; i++) {
+        VSObject *item = STACK_POP(stack);
+        list->items[i] = item;
+    }
+    STACK_PUSH_INCREF(stack, list);
+}
+
+// the refs of the keys and values on the stack move into the dict
+inline void vs_op_build_dict(cpt_stack_t &stack, vs_size_t npairs) {
+    VSDictObject *dict = new VSDictObject();
+    dict->_dict.reserve(npairs);
+    for (vs_size_t i = 0; i < npairs; i++) {
+        VSObject *key = STACK_POP(stack);
+        VSObject *value = STACK_POP(stack);
+        auto res = dict->_dict.emplace(key, value);
+        if (!res.second) {
+            DECREF(res.first->second);
+            res.first->second = value;
+            DECREF(key);
+        }
+    }
+    STACK_PUSH_INCREF(stack, dict);
+}
+
+inline void vs_op_build_set(cpt_stack_t &stack, vs_size_t nitems) {
+    VSSetObject *set = new VSSetObject();
+    set->_set.reserve(nitems);
+    for (vs_size_t i = 0; i < nitems; i++) {
+        VSObject *item = STACK_POP(stack);
+        auto res = set->_set.insert(item);
+        if (!res.second) {
+            DECREF(item);
+        }
+    }
+    STACK_PUSH_INCREF(stack, set);
+}
+
+inline void vs_op_index_load(cpt_stack_t &stack) {
+    VSObject *obj = STACK_POP(stack);
+    VSObject *idx = STACK_POP(stack);
+    VSObject *val = CALL_ATTR(obj, ID_get, vs_tuple_pack(1, idx));
+    STACK_PUSH(stack, val);
+    DECREF(obj);
+}
+
+inline void vs_op_index_store(cpt_stack_t &stack) {
+    VSObject *obj = STACK_POP(stack);
+    VSObject *idx = STACK_POP(stack);
+    VSObject *val = STACK_POP(stack);
+    CALL_ATTR(obj, ID_set, vs_tuple_pack(2, idx, val));
+    DECREF(obj);
+    DECREF(idx);
+    DECREF(val);
+}
+
+inline void vs_op_slice(cpt_stack_t &stack) {
+    VSObject *obj = STACK_POP(stack);
+    VSObject *start = STACK_POP(stack);
+    VSObject *end = STACK_POP(stack);
+    VSObject *val = CALL_ATTR(obj, ID_slice, vs_tuple_pack(2, start, end));
+    STACK_PUSH(stack, val);
+    DECREF(obj);
+    DECREF(start);
+    DECREF(end);
+}
+
+// locals and free vars are cells, load the values in them.
+inline void vs_op_load_var(cpt_stack_t &stack, VSTupleObject *vars, vs_size_t nvars, vs_addr_t idx, const char *what) {
+    if (idx >= nvars) {
+        err("Internal error: invalid %s var index: %llu, max: %llu", what, idx, nvars - 1);
+        terminate(TERM_ERROR);
+    }
+    VSObject *var = TUPLE_GET(vars, idx);
+    STACK_PUSH_INCREF(stack, VS_CELL_GET(var));
+}
+
+// load the cell itself, to be captured by a closure.
+inline void vs_op_load_cell(cpt_stack_t &stack, VSTupleObject *vars, vs_size_t nvars, vs_addr_t idx, const char *what) {
+    if (idx >= nvars) {
+        err("Internal error: invalid %s var index: %llu, max: %llu", what, idx, nvars - 1);
+        terminate(TERM_ERROR);
+    }
+    VSObject *cell = TUPLE_GET(vars, idx);
+    STACK_PUSH_INCREF(stack, cell);
+}
+
+inline void vs_op_store_var(cpt_stack_t &stack, VSTupleObject *vars, vs_size_t nvars, vs_addr_t idx, const char *what) {
+    VSObject *val = STACK_POP(stack);
+    if (idx >= nvars) {
+        err("Internal error: invalid %s var index: %llu, max: %llu", what, idx, nvars - 1);
+        terminate(TERM_ERROR);
+    }
+
+    VSObject *cell = TUPLE_GET(vars, idx);
+    VS_CELL_SET(cell, val);
+    DECREF(val);
+}
+
+inline void vs_op_store_cell(cpt_stack_t &stack, VSTupleObject *cellvars, vs_size_t ncellvars, vs_addr_t idx) {
+    VSObject *val = STACK_POP(stack);
+    if (idx >= ncellvars) {
+        err("Internal error: invalid cell var index: %llu, max: %llu", idx, ncellvars - 1);
+        terminate(TERM_ERROR);
+    }
+
+    TUPLE_SET(cellvars, idx, val);
+    DECREF(val);
+}
+
+inline void vs_op_load_attr(cpt_stack_t &stack, VSCodeObject *code, vs_addr_t idx) {
+    VSObject *obj = STACK_POP(stack);
+    if (idx >= code->nnames) {
+        err("Internal error: invalid name index: %llu, max: %llu", idx, code->nnames - 1);
+        terminate(TERM_ERROR);
+    }
+
+    VSObject *attrnameobj = LIST_GET(code->names, idx);
+    std::string &attrname = STRING_TO_C_STRING(attrnameobj);
+    if (!obj->hasattr(attrname)) {
+        ERR_NO_ATTR(obj, attrname);
+        terminate(TERM_ERROR);
+    }
+
+    VSObject *attr = obj->getattr(attrname);
+    STACK_PUSH(stack, attr);
+    DECREF(obj);
+}
+
+inline void vs_op_store_attr(cpt_stack_t &stack, VSCodeObject *code, vs_addr_t idx) {
+    VSObject *obj = STACK_POP(stack);
+    VSObject *attrvalue = STACK_POP(stack);
+    if (idx >= code->nnames) {
+        err("Internal error: invalid name index: %llu, max: %llu", idx, code->nnames - 1);
+        terminate(TERM_ERROR);
+    }
+
+    VSObject *attrnameobj = LIST_GET(code->names, idx);
+    std::string &attrname = STRING_TO_C_STRING(attrnameobj);
+    if (!obj->hasattr(attrname)) {
+        ERR_NO_ATTR(obj, attrname);
+        terminate(TERM_ERROR);
+    }
+
+    obj->setattr(attrname, attrvalue);
+    DECREF(attrvalue);
+    DECREF(obj);
+}
+
+inline void vs_op_load_const(cpt_stack_t &stack, VSCodeObject *code, vs_addr_t idx) {
+    if (idx >= code->nconsts) {
+        err("Internal error: invalid const index: %llu, max: %llu", idx, code->nconsts - 1);
+        terminate(TERM_ERROR);
+    }
+
+    VSObject *obj = LIST_GET(code->consts, idx);
+    STACK_PUSH_INCREF(stack, obj);
+}
+
+inline void vs_op_load_builtin(cpt_stack_t &stack, vs_addr_t idx) {
+    if (idx >= nbuiltins) {
+        err("Internal error: invalid builtin index: %llu, max: %llu", idx, nbuiltins - 1);
+        terminate(TERM_ERROR);
+    }
+
+    VSObject *obj = TUPLE_GET(builtins, idx);
+    STACK_PUSH_INCREF(stack, obj);
+}
+
+// pop the condition of a conditional jump.
+inline bool vs_op_cond(cpt_stack_t &stack) {
+    VSObject *obj = STACK_POP(stack);
+    if (obj->type != T_BOOL) {
+        err("Internal error: jump condition can not be \"%s\" object", TYPE_STR[obj->type]);
+        terminate(TERM_ERROR);
+    }
+
+    bool cond = BOOL_TO_C_BOOL(obj);
+    DECREF(obj);
+    return cond;
+}
+
+inline void vs_op_build_func(cpt_stack_t &stack) {
+    VSObject *codeobj = STACK_POP(stack);
+    VSObject *freevars = STACK_POP(stack);
+    VSCodeObject *code = (VSCodeObject *)codeobj;
+
+    VSFunctionObject *func = new VSDynamicFunctionObject(code->name, code, AS_TUPLE(freevars), code->flags);
+    STACK_PUSH_INCREF(stack, func);
+    DECREF(freevars);
+    DECREF(code);
+}
+
+// check if a tail call is left to eval, which runs dynamic functions in the
+// frame of the caller.
+inline bool vs_op_tail_call(cpt_stack_t &stack) {
+    return stack.size() == 2 && dynamic_cast<VSDynamicFunctionObject *>(STACK_TOP(stack)) != NULL;
+}
+
+inline void vs_op_call_func(cpt_stack_t &stack) {
+    VSObject *func = STACK_POP(stack);
+    VSObject *args = STACK_POP(stack);
+
+    if (!func->hasattr(ID___call__)) {
+        err("\"%s\" object is not callable", TYPE_STR[func->type]);
+        terminate(TERM_ERROR);
+    }
+
+    VSObject *__call__ = func->getattr(ID___call__);
+
+    if (__call__->type != T_FUNC) {
+        err("attribute \"__call__\" of \"%s\" object is not function", TYPE_STR[func->type]);
+        terminate(TERM_ERROR);
+    }
+
+    if (args->type != T_TUPLE) {
+        err("Internal error: function arg list can not be \"%s\" object", TYPE_STR[func->type]);
+        terminate(TERM_ERROR);
+    }
+
+    VSObject *res = ((VSFunctionObject *)__call__)->call((VSTupleObject *)args);
+    STACK_PUSH(stack, res);
+    DECREF(__call__);
+    DECREF(func);
+}
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef VS_TRACE_H
+#define VS_TRACE_H
+
+#include "objects/VSCodeObject.hpp"
+#include "objects/VSTupleObject.hpp"
+#include "runtime/VSInterpreter.hpp"
+
+// back edges after which a loop is traced.
+#ifndef VS_TRACE_THRESHOLD
+#define VS_TRACE_THRESHOLD 100
+#endif
+
+// bytecode instructions a trace may record before it is given up.
+#define VS_TRACE_MAX_LENGTH 500
+
+// tracing jit for hot loops. One iteration of a loop is recorded while it is
+// interpreted, with the types its values have. Ints are kept unboxed in the
+// trace, in registers for the locals, and only boxed when the trace leaves at
+// a failed guard, where the locals and the compute stack are rebuilt for the
+// interpreter to go on.
+class VSTraceCache;
+
+// count a back edge to header, true if the loop has a trace or is to be
+// traced, which the interpreter does.
+bool vs_trace_hot(VSCodeObject *code, vs_addr_t header);
+
+// run the loop at pc with its trace, or record the trace once the loop is
+// hot. Returns true if it did, then pc is the instruction to go on with.
+bool vs_trace_loop(cpt_stack_t &stack, vs_addr_t &pc, VSCodeObject *code, VSTupleObject *locals);
+
+void vs_trace_free(VSTraceCache *traces);
+
+#endif
@@ -1,23 +1,54 @@
 #include "compiler/Symtable.hpp"
 
-SymtableEntry::SymtableEntry(SYM_TYPE sym_type, VSObject *symbol, int index, int cell_index)    
+#include <string>
+#include <unordered_map>
+
+#include "objects/VSStringObject.hpp"
+
+#define INIT_NSLOTS 8
+
+// ids are small consecutive numbers, spread them over the slots.
+#define SLOT_OF(id, nslots) (((id) * 0x9E3779B97F4A7C15ULL >> 32) & ((nslots) - 1))
+
+static thread_local std::unordered_map<std::string, sym_id_t> interned;
+
+sym_id_t vs_intern(VSObject *name) {
+    auto iter = interned.find(STRING_TO_C_STRING(name));
+    if (iter != interned.end()) {
+        return iter->second;
+    }
+
+    sym_id_t id = interned.size();
+    interned[STRING_TO_C_STRING(name)] = id;
+    return id;
+}
+
+SymtableEntry::SymtableEntry(SYM_TYPE sym_type, VSObject *symbol, int index, int cell_index)
         : sym_type(sym_type), symbol(symbol), index(index), cell_index(cell_index) {
+    this->id = vs_intern(symbol);
     this->is_cell = false;
+    this->inline_func = NULL;
+    this->const_value = NULL;
+    this->val_type = T_OBJECT;
     INCREF(symbol);
 }
 
 SymtableEntry::~SymtableEntry() {
     DECREF_EX(this->symbol);
+    DECREF_EX(this->const_value);
 }
 
 Symtable::Symtable(Symtable *parent) : parent(parent) {
-    this->table = NEW_REF(VSDictObject *, new VSDictObject());
+    this->slots = std::vector<SymtableEntry *>(INIT_NSLOTS, NULL);
+    this->nentries = 0;
     INCREF(parent);
 }
 
 Symtable::~Symtable() {
     DECREF(this->parent);
-    DECREF(this->table);
+    for (auto entry : this->slots) {
+        DECREF(entry);
+    }
 }
 
 bool Symtable::has_parent() {
@@ -28,33 +59,57 @@ Symtable *Symtable::get_parent() {
     return this->parent;
 }
 
-void Symtable::put(VSObject *name, SymtableEntry *value) {
-    DICT_SET(this->table, name, value);
+SymtableEntry **Symtable::find(sym_id_t id) {
+    vs_size_t mask = this->slots.size() - 1;
+    vs_size_t slot = SLOT_OF(id, this->slots.size());
+    while (this->slots[slot] != NULL && this->slots[slot]->id != id) {
+        slot = (slot + 1) & mask;
+    }
+    return &this->slots[slot];
 }
 
-SymtableEntry *Symtable::get(VSObject *name) {
-    if (DICT_HAS(this->table, name)) {
-        return (SymtableEntry *)DICT_GET(this->table, name);
+void Symtable::put(SymtableEntry *entry) {
+    INCREF(entry);
+    SymtableEntry **slot = this->find(entry->id);
+    if (*slot != NULL) {
+        DECREF(*slot);
+        *slot = entry;
+        return;
     }
-    return NULL;
+
+    *slot = entry;
+    this->nentries++;
+    // keep the table at most half full.
+    if (this->nentries * 2 > this->slots.size()) {
+        std::vector<SymtableEntry *> slots(this->slots.size() * 2, NULL);
+        this->slots.swap(slots);
+        for (auto old : slots) {
+            if (old != NULL) {
+                *this->find(old->id) = old;
+            }
+        }
+    }
+}
+
+SymtableEntry *Symtable::get(VSObject *name) {
+    return *this->find(vs_intern(name));
 }
 
 SymtableEntry *Symtable::get_recur(VSObject *name) {
-    SymtableEntry *node = this->get(name);
-    if (node == NULL && this->has_parent()) {
-        return this->parent->get_recur(name);
+    sym_id_t id = vs_intern(name);
+    for (Symtable *table = this; table != NULL; table = table->parent) {
+        SymtableEntry *entry = *table->find(id);
+        if (entry != NULL) {
+            return entry;
+        }
     }
-    return node;
+    return NULL;
 }
 
 bool Symtable::contains(VSObject *name) {
-    return DICT_HAS(this->table, name);
+    return this->get(name) != NULL;
 }
 
 bool Symtable::contains_recur(VSObject *name) {
-    bool result = this->contains(name);
-    if (result == false && this->has_parent()) {
-        return this->parent->contains_recur(name);
-    }
-    return result;
-}
\ No newline at end of file
+    return this->get_recur(name) != NULL;
+}
@@ -0,0 +1,868 @@
+#include "compiler/VSAnalysis.hpp"
+
+#include <unordered_map>
+#include <unordered_set>
+
+#include "objects/VSBoolObject.hpp"
+#include "objects/VSFloatObject.hpp"
+#include "objects/VSFunctionObject.hpp"
+#include "objects/VSIntObject.hpp"
+#include "objects/VSStringObject.hpp"
+#include "objects/VSTupleObject.hpp"
+
+NEW_IDENTIFIER(__neg__);
+NEW_IDENTIFIER(__not__);
+NEW_IDENTIFIER(__add__);
+NEW_IDENTIFIER(__sub__);
+NEW_IDENTIFIER(__mul__);
+NEW_IDENTIFIER(__div__);
+NEW_IDENTIFIER(__mod__);
+NEW_IDENTIFIER(__lt__);
+NEW_IDENTIFIER(__gt__);
+NEW_IDENTIFIER(__le__);
+NEW_IDENTIFIER(__ge__);
+NEW_IDENTIFIER(__eq__);
+NEW_IDENTIFIER(__and__);
+NEW_IDENTIFIER(__xor__);
+NEW_IDENTIFIER(__or__);
+
+typedef std::vector<std::unordered_set<std::string>> scope_stack;
+
+static std::string *get_b_op_attr(OPCODE op) {
+    switch (op) {
+        case OP_ADD:
+            return &ID___add__;
+        case OP_SUB:
+            return &ID___sub__;
+        case OP_MUL:
+            return &ID___mul__;
+        case OP_DIV:
+            return &ID___div__;
+        case OP_MOD:
+            return &ID___mod__;
+        case OP_LT:
+            return &ID___lt__;
+        case OP_GT:
+            return &ID___gt__;
+        case OP_LE:
+            return &ID___le__;
+        case OP_GE:
+            return &ID___ge__;
+        case OP_EQ:
+        case OP_NEQ:
+            return &ID___eq__;
+        case OP_AND:
+            return &ID___and__;
+        case OP_XOR:
+            return &ID___xor__;
+        case OP_OR:
+            return &ID___or__;
+        default:
+            return NULL;
+    }
+}
+
+// divisors that make div and mod fail or trap at runtime.
+static bool is_bad_divisor(VSObject *value) {
+    switch (value->type) {
+        case T_INT:
+            return INT_TO_C_INT(value) == 0 || INT_TO_C_INT(value) == -1;
+        case T_FLOAT:
+            return FLOAT_TO_C_FLOAT(value) == 0;
+        default:
+            return true;
+    }
+}
+
+// bools are singletons shared by the compiler workers, which must not call
+// their methods, so operators on bools are evaluated here. NULL if bool has
+// no such operator.
+static VSObject *fold_bool_op(OPCODE op, bool l, bool r) {
+    bool res;
+    switch (op) {
+        case OP_NOT:
+            res = !l;
+            break;
+        case OP_LT:
+            res = l < r;
+            break;
+        case OP_GT:
+            res = l > r;
+            break;
+        case OP_LE:
+            res = l <= r;
+            break;
+        case OP_GE:
+            res = l >= r;
+            break;
+        case OP_EQ:
+            res = l == r;
+            break;
+        case OP_NEQ:
+        case OP_XOR:
+            res = l != r;
+            break;
+        case OP_AND:
+            res = l && r;
+            break;
+        case OP_OR:
+            res = l || r;
+            break;
+        default:
+            return NULL;
+    }
+    INCREF_RET(C_BOOL_TO_BOOL(res));
+}
+
+VSObject *fold_u_op(OPCODE op, VSObject *operand) {
+    if (IS_TYPE(operand, T_BOOL)) {
+        return op == OP_NOT ? fold_bool_op(op, BOOL_TO_C_BOOL(operand), false) : NULL;
+    }
+
+    std::string *attrname = op == OP_NEG ? &ID___neg__ : op == OP_NOT ? &ID___not__ : NULL;
+    if (attrname == NULL || !IS_FOLDABLE(operand) || !operand->hasattr(*attrname)) {
+        return NULL;
+    }
+    return CALL_ATTR(operand, *attrname, EMPTY_TUPLE());
+}
+
+VSObject *fold_b_op(OPCODE op, VSObject *l_val, VSObject *r_val) {
+    std::string *attrname = get_b_op_attr(op);
+    // operators of native types check types strictly, leave the mismatched
+    // ones and the failing ones to the runtime error.
+    if (attrname == NULL || !IS_FOLDABLE(l_val) || l_val->type != r_val->type || !l_val->hasattr(*attrname) ||
+        ((op == OP_DIV || op == OP_MOD) && is_bad_divisor(r_val))) {
+        return NULL;
+    }
+    if (IS_TYPE(l_val, T_BOOL)) {
+        return fold_bool_op(op, BOOL_TO_C_BOOL(l_val), BOOL_TO_C_BOOL(r_val));
+    }
+
+    // __eq__ of the native types returns a bool, negate it without a call
+    VSObject *res = CALL_ATTR(l_val, *attrname, vs_tuple_pack(1, r_val));
+    if (op == OP_NEQ) {
+        VSObject *temp = res;
+        res = NEW_REF(VSObject *, C_BOOL_TO_BOOL(!BOOL_TO_C_BOOL(temp)));
+        DECREF(temp);
+    }
+    return res;
+}
+
+#define ADD_CHILD(child)                \
+    do {                                \
+        if ((child) != NULL) {          \
+            children.push_back(child);  \
+        }                               \
+    } while (0);
+
+void ast_children(VSASTNode *node, std::vector<VSASTNode *> &children) {
+    if (node == NULL) {
+        return;
+    }
+
+    switch (node->node_type) {
+        case AST_TUPLE_DECL:
+        case AST_LIST_DECL:
+        case AST_DICT_DECL:
+        case AST_SET_DECL:
+        case AST_EXPR_LST:
+        case AST_CPD_STMT:
+        case AST_PROGRAM:
+            for (auto value : ((ContainerNode *)node)->values) {
+                ADD_CHILD(value);
+            }
+            break;
+        case AST_IDX_EXPR:
+            ADD_CHILD(((IdxExprNode *)node)->obj);
+            ADD_CHILD(((IdxExprNode *)node)->index);
+            break;
+        case AST_SLICE_EXPR:
+            ADD_CHILD(((SliceExprNode *)node)->obj);
+            ADD_CHILD(((SliceExprNode *)node)->start);
+            ADD_CHILD(((SliceExprNode *)node)->end);
+            break;
+        case AST_DOT_EXPR:
+            // attrname is not a variable, skip it.
+            ADD_CHILD(((DotExprNode *)node)->obj);
+            break;
+        case AST_FUNC_CALL:
+            ADD_CHILD(((FuncCallNode *)node)->func);
+            ADD_CHILD(((FuncCallNode *)node)->args);
+            break;
+        case AST_B_OP_EXPR:
+            ADD_CHILD(((BOPNode *)node)->l_operand);
+            ADD_CHILD(((BOPNode *)node)->r_operand);
+            break;
+        case AST_U_OP_EXPR:
+            ADD_CHILD(((UOPNode *)node)->operand);
+            break;
+        case AST_ASSIGN_EXPR:
+            ADD_CHILD(((AssignExprNode *)node)->lval);
+            ADD_CHILD(((AssignExprNode *)node)->rval);
+            break;
+        case AST_PAIR_EXPR:
+            ADD_CHILD(((PairExprNode *)node)->key);
+            ADD_CHILD(((PairExprNode *)node)->value);
+            break;
+        case AST_INIT_DECL:
+            ADD_CHILD(((InitDeclNode *)node)->name);
+            ADD_CHILD(((InitDeclNode *)node)->init_val);
+            break;
+        case AST_INIT_DECL_LIST:
+            for (auto decl : ((InitDeclListNode *)node)->decls) {
+                ADD_CHILD(decl);
+            }
+            break;
+        case AST_FUNC_DECL:
+        case AST_LAMBDA_DECL: {
+            FuncDeclNode *func = (FuncDeclNode *)node;
+            ADD_CHILD(func->name);
+            for (auto arg : func->args) {
+                ADD_CHILD(arg);
+            }
+            ADD_CHILD(func->body);
+            break;
+        }
+        case AST_IF_STMT:
+            ADD_CHILD(((IfStmtNode *)node)->cond);
+            ADD_CHILD(((IfStmtNode *)node)->truestmt);
+            ADD_CHILD(((IfStmtNode *)node)->falsestmt);
+            break;
+        case AST_ELIF_LIST:
+            for (auto elif : ((ElifListNode *)node)->elifs) {
+                ADD_CHILD(elif);
+            }
+            ADD_CHILD(((ElifListNode *)node)->elsestmt);
+            break;
+        case AST_WHILE_STMT:
+            ADD_CHILD(((WhileStmtNode *)node)->cond);
+            ADD_CHILD(((WhileStmtNode *)node)->body);
+            break;
+        case AST_FOR_STMT:
+            ADD_CHILD(((ForStmtNode *)node)->init);
+            ADD_CHILD(((ForStmtNode *)node)->cond);
+            ADD_CHILD(((ForStmtNode *)node)->incr);
+            ADD_CHILD(((ForStmtNode *)node)->body);
+            break;
+        case AST_RETURN:
+            ADD_CHILD(((ReturnStmtNode *)node)->retval);
+            break;
+        default:
+            break;
+    }
+}
+
+vs_size_t ast_size(VSASTNode *node) {
+    if (node == NULL) {
+        return 0;
+    }
+
+    vs_size_t size = 1;
+    std::vector<VSASTNode *> children;
+    ast_children(node, children);
+    for (auto child : children) {
+        size += ast_size(child);
+    }
+    return size;
+}
+
+bool ast_uses_name(VSASTNode *node, std::string &name) {
+    if (node == NULL) {
+        return false;
+    }
+    if (node->node_type == AST_IDENT) {
+        return STRING_TO_C_STRING(((IdentNode *)node)->name) == name;
+    }
+
+    std::vector<VSASTNode *> children;
+    ast_children(node, children);
+    for (auto child : children) {
+        if (ast_uses_name(child, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool ast_assigns_name(VSASTNode *node, std::string &name) {
+    if (node == NULL) {
+        return false;
+    }
+    if (node->node_type == AST_ASSIGN_EXPR) {
+        VSASTNode *lval = ((AssignExprNode *)node)->lval;
+        if (lval->node_type == AST_IDENT && STRING_TO_C_STRING(((IdentNode *)lval)->name) == name) {
+            return true;
+        }
+    }
+
+    std::vector<VSASTNode *> children;
+    ast_children(node, children);
+    for (auto child : children) {
+        if (ast_assigns_name(child, name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void ast_collect_assigned(VSASTNode *node, std::unordered_set<std::string> &names) {
+    if (node == NULL) {
+        return;
+    }
+    if (node->node_type == AST_ASSIGN_EXPR) {
+        VSASTNode *lval = ((AssignExprNode *)node)->lval;
+        if (lval->node_type == AST_IDENT) {
+            names.insert(STRING_TO_C_STRING(((IdentNode *)lval)->name));
+        }
+    }
+
+    std::vector<VSASTNode *> children;
+    ast_children(node, children);
+    for (auto child : children) {
+        ast_collect_assigned(child, names);
+    }
+}
+
+void ast_collect_attr_loads(VSASTNode *node, std::vector<DotExprNode *> &loads) {
+    if (node == NULL || node->node_type == AST_FUNC_DECL || node->node_type == AST_LAMBDA_DECL) {
+        return;
+    }
+
+    if (node->node_type == AST_DOT_EXPR) {
+        loads.push_back((DotExprNode *)node);
+    } else if (node->node_type == AST_ASSIGN_EXPR) {
+        AssignExprNode *assign = (AssignExprNode *)node;
+        if (assign->lval->node_type == AST_DOT_EXPR) {
+            // the target attribute is stored, only its object is loaded.
+            ast_collect_attr_loads(((DotExprNode *)assign->lval)->obj, loads);
+            ast_collect_attr_loads(assign->rval, loads);
+            return;
+        }
+    }
+
+    std::vector<VSASTNode *> children;
+    ast_children(node, children);
+    for (auto child : children) {
+        ast_collect_attr_loads(child, loads);
+    }
+}
+
+void ast_collect_muls(VSASTNode *node, std::vector<BOPNode *> &muls) {
+    if (node == NULL || node->node_type == AST_FUNC_DECL || node->node_type == AST_LAMBDA_DECL) {
+        return;
+    }
+
+    if (node->node_type == AST_B_OP_EXPR && ((BOPNode *)node)->opcode == TK_MUL) {
+        muls.push_back((BOPNode *)node);
+    }
+
+    std::vector<VSASTNode *> children;
+    ast_children(node, children);
+    for (auto child : children) {
+        ast_collect_muls(child, muls);
+    }
+}
+
+void ast_collect_funcs(VSASTNode *node, std::vector<FuncDeclNode *> &funcs) {
+    if (node == NULL) {
+        return;
+    }
+
+    if (node->node_type == AST_FUNC_DECL || node->node_type == AST_LAMBDA_DECL) {
+        funcs.push_back((FuncDeclNode *)node);
+        return;
+    }
+
+    std::vector<VSASTNode *> children;
+    ast_children(node, children);
+    for (auto child : children) {
+        ast_collect_funcs(child, funcs);
+    }
+}
+
+static bool is_bound(scope_stack &scopes, std::string &name) {
+    for (auto &scope : scopes) {
+        if (scope.find(name) != scope.end()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool check_inline_stmt(VSASTNode *node, scope_stack &scopes, name_addr_map *builtins);
+
+static bool check_inline_expr(VSASTNode *node, scope_stack &scopes, name_addr_map *builtins) {
+    if (node == NULL) {
+        return true;
+    }
+
+    switch (node->node_type) {
+        case AST_CONST:
+            return true;
+        case AST_IDENT: {
+            std::string &name = STRING_TO_C_STRING(((IdentNode *)node)->name);
+            return is_bound(scopes, name) || builtins->find(name) != builtins->end();
+        }
+        case AST_ASSIGN_EXPR: {
+            AssignExprNode *assign = (AssignExprNode *)node;
+            // only locals of the inlined function can be assigned.
+            if (assign->lval->node_type == AST_IDENT &&
+                !is_bound(scopes, STRING_TO_C_STRING(((IdentNode *)assign->lval)->name))) {
+                return false;
+            }
+            return check_inline_expr(assign->lval, scopes, builtins) &&
+                   check_inline_expr(assign->rval, scopes, builtins);
+        }
+        case AST_TUPLE_DECL:
+        case AST_LIST_DECL:
+        case AST_DICT_DECL:
+        case AST_SET_DECL:
+        case AST_EXPR_LST:
+        case AST_IDX_EXPR:
+        case AST_SLICE_EXPR:
+        case AST_DOT_EXPR:
+        case AST_FUNC_CALL:
+        case AST_B_OP_EXPR:
+        case AST_U_OP_EXPR:
+        case AST_PAIR_EXPR: {
+            std::vector<VSASTNode *> children;
+            ast_children(node, children);
+            for (auto child : children) {
+                if (!check_inline_expr(child, scopes, builtins)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+        default:
+            // nested functions would introduce cell vars.
+            return false;
+    }
+}
+
+static bool check_inline_block(VSASTNode *node, scope_stack &scopes, name_addr_map *builtins) {
+    scopes.push_back(std::unordered_set<std::string>());
+    bool res = check_inline_stmt(node, scopes, builtins);
+    scopes.pop_back();
+    return res;
+}
+
+static bool check_inline_stmt(VSASTNode *node, scope_stack &scopes, name_addr_map *builtins) {
+    if (node == NULL) {
+        return true;
+    }
+
+    switch (node->node_type) {
+        case AST_INIT_DECL_LIST:
+            for (auto decl : ((InitDeclListNode *)node)->decls) {
+                std::string &name = STRING_TO_C_STRING(decl->name->name);
+                // a local without initial value would keep the value of the last
+                // inlined call when the call site is in a loop.
+                if (decl->init_val == NULL || ast_uses_name(decl->init_val, name)) {
+                    return false;
+                }
+                if (!check_inline_expr(decl->init_val, scopes, builtins)) {
+                    return false;
+                }
+                scopes.back().insert(name);
+            }
+            return true;
+        case AST_CPD_STMT:
+            for (auto stmt : ((CpdStmtNode *)node)->values) {
+                if (!check_inline_stmt(stmt, scopes, builtins)) {
+                    return false;
+                }
+            }
+            return true;
+        case AST_IF_STMT: {
+            IfStmtNode *if_stmt = (IfStmtNode *)node;
+            return check_inline_expr(if_stmt->cond, scopes, builtins) &&
+                   check_inline_block(if_stmt->truestmt, scopes, builtins) &&
+                   check_inline_stmt(if_stmt->falsestmt, scopes, builtins);
+        }
+        case AST_ELIF_LIST: {
+            ElifListNode *elif_list = (ElifListNode *)node;
+            for (auto elif : elif_list->elifs) {
+                if (!check_inline_expr(elif->cond, scopes, builtins) ||
+                    !check_inline_block(elif->truestmt, scopes, builtins)) {
+                    return false;
+                }
+            }
+            return check_inline_block(elif_list->elsestmt, scopes, builtins);
+        }
+        case AST_WHILE_STMT: {
+            WhileStmtNode *while_stmt = (WhileStmtNode *)node;
+            return check_inline_expr(while_stmt->cond, scopes, builtins) &&
+                   check_inline_block(while_stmt->body, scopes, builtins);
+        }
+        case AST_FOR_STMT: {
+            ForStmtNode *for_stmt = (ForStmtNode *)node;
+            scopes.push_back(std::unordered_set<std::string>());
+            bool res = (for_stmt->init == NULL || for_stmt->init->node_type == AST_INIT_DECL_LIST
+                            ? check_inline_stmt(for_stmt->init, scopes, builtins)
+                            : check_inline_expr(for_stmt->init, scopes, builtins)) &&
+                       check_inline_expr(for_stmt->cond, scopes, builtins) &&
+                       check_inline_stmt(for_stmt->body, scopes, builtins) &&
+                       check_inline_expr(for_stmt->incr, scopes, builtins);
+            scopes.pop_back();
+            return res;
+        }
+        case AST_RETURN:
+            return check_inline_expr(((ReturnStmtNode *)node)->retval, scopes, builtins);
+        case AST_BREAK:
+        case AST_CONTINUE:
+            return true;
+        default:
+            return check_inline_expr(node, scopes, builtins);
+    }
+}
+
+bool ast_inlinable(FuncDeclNode *func, name_addr_map *builtins) {
+    if (func->va_args || func->body == NULL || ast_size(func->body) > VS_INLINE_BUDGET) {
+        return false;
+    }
+
+    scope_stack scopes;
+    scopes.push_back(std::unordered_set<std::string>());
+    for (auto arg : func->args) {
+        if (arg->node_type != AST_IDENT) {
+            return false;
+        }
+        scopes.back().insert(STRING_TO_C_STRING(((IdentNode *)arg)->name));
+    }
+    return check_inline_stmt(func->body, scopes, builtins);
+}
+
+// bindings of names while resolving free vars, like the entries of symtables.
+typedef enum {
+    BIND_VAR,
+    BIND_VAL,
+    BIND_FREE,
+    BIND_BUILTIN,
+    // captured by a nested function before it is defined, like SYM_UNDEFINED.
+    BIND_PENDING
+} BIND_TYPE;
+
+struct resolve_state {
+    name_addr_map *builtins;
+    std::vector<std::unordered_map<std::string, BIND_TYPE>> scopes;
+    // names captured by nested functions declared in blocks, which the code
+    // generator looks up in the function scope at the end.
+    std::vector<std::string> block_captures;
+    // names captured in the function scope before they are defined.
+    std::vector<std::string> pending;
+    std::vector<std::string> freevars;
+    int nloops;
+    bool ok;
+};
+
+static void add_freevar(resolve_state &state, const std::string &name) {
+    for (auto &freevar : state.freevars) {
+        if (freevar == name) {
+            return;
+        }
+    }
+    state.freevars.push_back(name);
+}
+
+static BIND_TYPE *lookup(resolve_state &state, const std::string &name) {
+    for (auto scope = state.scopes.rbegin(); scope != state.scopes.rend(); scope++) {
+        auto iter = scope->find(name);
+        if (iter != scope->end()) {
+            return &iter->second;
+        }
+    }
+    return NULL;
+}
+
+static void resolve_use(resolve_state &state, const std::string &name) {
+    BIND_TYPE *bind = lookup(state, name);
+    if (bind != NULL) {
+        // the code generator gives such a name a free var index it never adds.
+        state.ok &= *bind != BIND_PENDING;
+        return;
+    }
+
+    if (state.builtins->find(name) != state.builtins->end()) {
+        state.scopes.back()[name] = BIND_BUILTIN;
+    } else {
+        state.scopes.back()[name] = BIND_FREE;
+        add_freevar(state, name);
+    }
+}
+
+static void resolve_decl(resolve_state &state, const std::string &name, BIND_TYPE type) {
+    auto &scope = state.scopes.back();
+    auto iter = scope.find(name);
+    if (iter == scope.end()) {
+        scope[name] = type;
+    } else if (iter->second == BIND_PENDING) {
+        iter->second = type;
+    } else {
+        // duplicated definition
+        state.ok = false;
+    }
+}
+
+static void resolve_capture(resolve_state &state, FuncDeclNode *func) {
+    std::vector<std::string> captures;
+    state.ok &= ast_free_vars(func, state.builtins, captures);
+
+    auto &scope = state.scopes.back();
+    for (auto &name : captures) {
+        if (state.scopes.size() > 1) {
+            state.block_captures.push_back(name);
+        }
+        if (scope.find(name) == scope.end()) {
+            scope[name] = BIND_PENDING;
+            if (state.scopes.size() == 1) {
+                state.pending.push_back(name);
+            }
+        }
+    }
+}
+
+static void resolve_cpd(resolve_state &state, VSASTNode *node);
+
+static void resolve_expr(resolve_state &state, VSASTNode *node) {
+    switch (node->node_type) {
+        case AST_IDENT:
+            resolve_use(state, STRING_TO_C_STRING(((IdentNode *)node)->name));
+            break;
+        case AST_TUPLE_DECL:
+        case AST_LIST_DECL:
+        case AST_SET_DECL:
+            for (auto value : ((ContainerNode *)node)->values) {
+                resolve_expr(state, value);
+            }
+            break;
+        case AST_DICT_DECL:
+            for (auto value : ((DictDeclNode *)node)->values) {
+                resolve_expr(state, ((PairExprNode *)value)->value);
+                resolve_expr(state, ((PairExprNode *)value)->key);
+            }
+            break;
+        case AST_DOT_EXPR:
+            resolve_expr(state, ((DotExprNode *)node)->obj);
+            break;
+        case AST_IDX_EXPR:
+            resolve_expr(state, ((IdxExprNode *)node)->index);
+            resolve_expr(state, ((IdxExprNode *)node)->obj);
+            break;
+        case AST_SLICE_EXPR: {
+            SliceExprNode *slice_expr = (SliceExprNode *)node;
+            if (slice_expr->end != NULL) {
+                resolve_expr(state, slice_expr->end);
+            }
+            if (slice_expr->start != NULL) {
+                resolve_expr(state, slice_expr->start);
+            }
+            resolve_expr(state, slice_expr->obj);
+            break;
+        }
+        case AST_FUNC_CALL:
+            if (((FuncCallNode *)node)->args == NULL) {
+                state.ok = false;
+                break;
+            }
+            resolve_expr(state, ((FuncCallNode *)node)->args);
+            resolve_expr(state, ((FuncCallNode *)node)->func);
+            break;
+        case AST_B_OP_EXPR:
+            resolve_expr(state, ((BOPNode *)node)->r_operand);
+            resolve_expr(state, ((BOPNode *)node)->l_operand);
+            break;
+        case AST_U_OP_EXPR:
+            resolve_expr(state, ((UOPNode *)node)->operand);
+            break;
+        case AST_LAMBDA_DECL:
+            resolve_capture(state, (FuncDeclNode *)node);
+            break;
+        default:
+            break;
+    }
+}
+
+static void resolve_assign(resolve_state &state, VSASTNode *node) {
+    if (node->node_type != AST_ASSIGN_EXPR) {
+        resolve_expr(state, node);
+        return;
+    }
+
+    AssignExprNode *assign = (AssignExprNode *)node;
+    resolve_expr(state, assign->rval);
+    if (assign->opcode != TK_NOP) {
+        resolve_expr(state, assign->lval);
+    }
+
+    switch (assign->lval->node_type) {
+        case AST_IDENT: {
+            // only vars and args of the function itself can be assigned.
+            BIND_TYPE *bind = lookup(state, STRING_TO_C_STRING(((IdentNode *)assign->lval)->name));
+            state.ok &= bind != NULL && *bind == BIND_VAR;
+            break;
+        }
+        case AST_IDX_EXPR:
+            resolve_expr(state, ((IdxExprNode *)assign->lval)->index);
+            resolve_expr(state, ((IdxExprNode *)assign->lval)->obj);
+            break;
+        case AST_DOT_EXPR:
+            resolve_expr(state, ((DotExprNode *)assign->lval)->obj);
+            break;
+        default:
+            state.ok = false;
+            break;
+    }
+}
+
+static void resolve_expr_list(resolve_state &state, VSASTNode *node) {
+    if (node->node_type == AST_EXPR_LST) {
+        for (auto expr : ((ExprListNode *)node)->values) {
+            resolve_assign(state, expr);
+        }
+        return;
+    }
+    resolve_assign(state, node);
+}
+
+static void resolve_decl_list(resolve_state &state, InitDeclListNode *decl_list) {
+    BIND_TYPE type = decl_list->specifier == TK_VAR ? BIND_VAR : BIND_VAL;
+    for (auto decl : decl_list->decls) {
+        resolve_decl(state, STRING_TO_C_STRING(decl->name->name), type);
+        if (decl->init_val != NULL) {
+            resolve_expr(state, decl->init_val);
+        } else if (type == BIND_VAL) {
+            state.ok = false;
+        }
+    }
+}
+
+static void resolve_block(resolve_state &state, VSASTNode *node) {
+    state.scopes.push_back(std::unordered_map<std::string, BIND_TYPE>());
+    resolve_cpd(state, node);
+    state.scopes.pop_back();
+}
+
+static void resolve_if(resolve_state &state, IfStmtNode *if_stmt) {
+    if (if_stmt->cond == NULL) {
+        state.ok = false;
+        return;
+    }
+    resolve_expr(state, if_stmt->cond);
+    resolve_block(state, if_stmt->truestmt);
+}
+
+static void resolve_cpd(resolve_state &state, VSASTNode *node) {
+    for (auto stmt : ((CpdStmtNode *)node)->values) {
+        switch (stmt->node_type) {
+            case AST_INIT_DECL_LIST:
+                resolve_decl_list(state, (InitDeclListNode *)stmt);
+                break;
+            case AST_FUNC_DECL: {
+                FuncDeclNode *func = (FuncDeclNode *)stmt;
+                // a function can not be declared over a name captured before.
+                auto &scope = state.scopes.back();
+                std::string &name = STRING_TO_C_STRING(func->name->name);
+                state.ok &= scope.find(name) == scope.end();
+                scope[name] = BIND_VAR;
+                resolve_capture(state, func);
+                break;
+            }
+            case AST_CLASS_DECL:
+            case AST_METH_DECL:
+                break;
+            case AST_BREAK:
+            case AST_CONTINUE:
+                state.ok &= state.nloops > 0;
+                break;
+            case AST_IF_STMT: {
+                IfStmtNode *if_stmt = (IfStmtNode *)stmt;
+                resolve_if(state, if_stmt);
+                if (if_stmt->falsestmt != NULL) {
+                    ElifListNode *elif_list = (ElifListNode *)if_stmt->falsestmt;
+                    for (auto elif : elif_list->elifs) {
+                        resolve_if(state, elif);
+                    }
+                    if (elif_list->elsestmt != NULL) {
+                        resolve_block(state, elif_list->elsestmt);
+                    }
+                }
+                break;
+            }
+            case AST_FOR_STMT: {
+                ForStmtNode *for_stmt = (ForStmtNode *)stmt;
+                state.scopes.push_back(std::unordered_map<std::string, BIND_TYPE>());
+                if (for_stmt->init != NULL) {
+                    if (for_stmt->init->node_type == AST_INIT_DECL_LIST) {
+                        resolve_decl_list(state, (InitDeclListNode *)for_stmt->init);
+                    } else {
+                        resolve_expr_list(state, for_stmt->init);
+                    }
+                }
+                if (for_stmt->cond == NULL) {
+                    state.ok = false;
+                } else {
+                    resolve_expr(state, for_stmt->cond);
+                }
+                state.nloops++;
+                resolve_cpd(state, for_stmt->body);
+                state.nloops--;
+                if (for_stmt->incr != NULL) {
+                    resolve_expr_list(state, for_stmt->incr);
+                }
+                state.scopes.pop_back();
+                break;
+            }
+            case AST_WHILE_STMT: {
+                WhileStmtNode *while_stmt = (WhileStmtNode *)stmt;
+                if (while_stmt->cond == NULL) {
+                    state.ok = false;
+                } else {
+                    resolve_expr(state, while_stmt->cond);
+                }
+                state.nloops++;
+                resolve_block(state, while_stmt->body);
+                state.nloops--;
+                break;
+            }
+            case AST_RETURN:
+                if (((ReturnStmtNode *)stmt)->retval != NULL) {
+                    resolve_expr(state, ((ReturnStmtNode *)stmt)->retval);
+                }
+                break;
+            case AST_ASSIGN_EXPR:
+            case AST_EXPR_LST:
+            default:
+                resolve_expr_list(state, stmt);
+                break;
+        }
+    }
+}
+
+bool ast_free_vars(FuncDeclNode *func, name_addr_map *builtins, std::vector<std::string> &freevars) {
+    resolve_state state;
+    state.builtins = builtins;
+    state.nloops = 0;
+    state.ok = true;
+    state.scopes.push_back(std::unordered_map<std::string, BIND_TYPE>());
+
+    for (auto arg : func->args) {
+        IdentNode *name = arg->node_type == AST_IDENT ? (IdentNode *)arg : ((InitDeclNode *)arg)->name;
+        state.scopes[0][STRING_TO_C_STRING(name->name)] = BIND_VAR;
+    }
+    resolve_cpd(state, func->body);
+
+    // names captured but never defined in the function are its free vars.
+    for (auto &name : state.pending) {
+        if (state.scopes[0][name] == BIND_PENDING) {
+            add_freevar(state, name);
+        }
+    }
+    // captures in blocks must be bound in the function scope at last.
+    for (auto &name : state.block_captures) {
+        state.ok &= state.scopes[0].find(name) != state.scopes[0].end();
+    }
+
+    freevars = state.freevars;
+    return state.ok;
+}
@@ -0,0 +1,82 @@
+#include "compiler/VSArena.hpp"
+
+#include <stdlib.h>
+
+#include "error.hpp"
+
+#define CHUNK_SIZE (64 * 1024)
+
+// every allocation is prefixed by the arena it is from, so that heap memory
+// can be told apart when freed. The header keeps the max alignment.
+#define HEADER_SIZE (alignof(max_align_t))
+#define ALIGN(size) (((size) + HEADER_SIZE - 1) & ~(HEADER_SIZE - 1))
+
+thread_local VSArena *VSArena::current = NULL;
+
+VSArena::VSArena() {
+    this->pos = NULL;
+    this->end = NULL;
+}
+
+VSArena::~VSArena() {
+    for (auto chunk : this->chunks) {
+        free(chunk);
+    }
+}
+
+void *VSArena::alloc(size_t size) {
+    size = ALIGN(size);
+    if (this->pos == NULL || (size_t)(this->end - this->pos) < size) {
+        // large blocks get a chunk of their own, the current one is kept.
+        size_t chunk_size = size > CHUNK_SIZE / 4 ? size : CHUNK_SIZE;
+        char *chunk = (char *)malloc(chunk_size);
+        if (chunk == NULL) {
+            err("unable to malloc memory of size: %lu\n", chunk_size);
+            terminate(TERM_ERROR);
+        }
+        this->chunks.push_back(chunk);
+        if (chunk_size != CHUNK_SIZE) {
+            return chunk;
+        }
+        this->pos = chunk;
+        this->end = chunk + chunk_size;
+    }
+
+    void *mem = this->pos;
+    this->pos += size;
+    return mem;
+}
+
+VSArenaScope::VSArenaScope() {
+    this->arena = NEW_REF(VSArena *, new VSArena());
+    this->prev = VSArena::current;
+    VSArena::current = this->arena;
+}
+
+VSArenaScope::~VSArenaScope() {
+    VSArena::current = this->prev;
+    DECREF(this->arena);
+}
+
+void *vs_arena_alloc(size_t size) {
+    VSArena *arena = VSArena::current;
+    char *mem = arena != NULL ? (char *)arena->alloc(HEADER_SIZE + size) : (char *)malloc(HEADER_SIZE + size);
+    if (mem == NULL) {
+        err("unable to malloc memory of size: %lu\n", HEADER_SIZE + size);
+        terminate(TERM_ERROR);
+    }
+
+    *(VSArena **)mem = arena;
+    return mem + HEADER_SIZE;
+}
+
+void vs_arena_free(void *ptr) {
+    if (ptr == NULL) {
+        return;
+    }
+
+    char *mem = (char *)ptr - HEADER_SIZE;
+    if (*(VSArena **)mem == NULL) {
+        free(mem);
+    }
+}
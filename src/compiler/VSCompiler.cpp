@@ -1,8 +1,20 @@
 #include "compiler/VSCompiler.hpp"
 
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
 #include "error.hpp"
+#include "objects/VSBoolObject.hpp"
+#include "objects/VSCharObject.hpp"
+#include "objects/VSDictObject.hpp"
+#include "objects/VSFloatObject.hpp"
+#include "objects/VSFunctionObject.hpp"
+#include "objects/VSIntObject.hpp"
 #include "objects/VSListObject.hpp"
+#include "objects/VSSetObject.hpp"
 #include "objects/VSStringObject.hpp"
+#include "objects/VSTupleObject.hpp"
 
 #define ENTER_BLK()                                                                  \
     do {                                                                             \
@@ -18,15 +30,15 @@
         DECREF_EX(curtable);                        \
     } while (0);
 
-#define ENTER_FUNC(name)                                \
-    do {                                                \
-        this->codeobjects.push(new VSCodeObject(name)); \
-        this->conststack.push(new name_addr_map());     \
-        this->namestack.push(new name_addr_map());      \
-        this->symtables.push(new Symtable(NULL));       \
-        auto _consts = this->conststack.top();          \
-        (*_consts)["__vs_none__"] = 0;                  \
-        INCREF(this->symtables.top());                  \
+#define ENTER_FUNC(code, outer)                     \
+    do {                                            \
+        this->codeobjects.push(code);               \
+        this->conststack.push(new name_addr_map()); \
+        this->namestack.push(new name_addr_map());  \
+        this->symtables.push(new Symtable(outer));  \
+        auto _consts = this->conststack.top();      \
+        (*_consts)["__vs_none__"] = 0;              \
+        INCREF(this->symtables.top());              \
     } while (0);
 
 #define LEAVE_FUNC()                          \
@@ -41,16 +53,58 @@
         LEAVE_BLK();                          \
     } while (0);
 
-VSCompiler::VSCompiler(name_addr_map *builtins) : builtins(builtins) {
+VSLazyAST::VSLazyAST(VSArena *arena, VSASTNode *astree) : arena(arena), astree(astree) {
+    INCREF(arena);
+    INCREF(astree);
+}
+
+VSLazyAST::~VSLazyAST() {
+    // nodes are destructed before the memory they live in is freed.
+    DECREF_EX(this->astree);
+    DECREF_EX(this->arena);
+}
+
+VSLazyFunc::VSLazyFunc(FuncDeclNode *func, name_addr_map *builtins, int opt_level, VSLazyAST *ast)
+    : func(func), builtins(builtins), opt_level(opt_level), ast(ast) {
+    INCREF(ast);
+}
+
+VSLazyFunc::~VSLazyFunc() {
+    DECREF_EX(this->ast);
+}
+
+void VSLazyFunc::gen(VSCodeObject *code) {
+    vs_size_t nfreevars = code->nfreevars;
+
+    VSCompiler compiler(this->builtins, this->opt_level, NULL, 1, false);
+    compiler.gen_func_body(this->func, code);
+    if (code->nfreevars != nfreevars) {
+        err("internal error: free vars of \"%s\" changed when generated lazily",
+            STRING_TO_C_STRING(code->name).c_str());
+        terminate(TERM_ERROR);
+    }
+
+    if (this->opt_level >= VS_OPT_SSA) {
+        compiler.optimize(code);
+    }
+}
+
+VSCompiler::VSCompiler(name_addr_map *builtins, int opt_level, FILE *ir_dump, int nthreads, bool lazy)
+    : builtins(builtins), opt_level(opt_level), ir_dump(ir_dump), nthreads(nthreads), lazy(lazy), nreused(0),
+      nrecompiled(0) {
     this->symtables = std::stack<Symtable *>();
     this->codeobjects = std::stack<VSCodeObject *>();
     this->namestack = std::stack<name_addr_map *>();
     this->conststack = std::stack<name_addr_map *>();
     this->breakposes = std::stack<std::vector<vs_addr_t> *>();
     this->continueposes = std::stack<std::vector<vs_addr_t> *>();
+    this->inlineposes = std::stack<std::vector<vs_addr_t> *>();
 }
 
 VSCompiler::~VSCompiler() {
+    for (auto &entry : this->cache) {
+        DECREF(entry.second);
+    }
 }
 
 OPCODE VSCompiler::get_b_op(TOKEN_TYPE tk) {
@@ -88,27 +142,57 @@ OPCODE VSCompiler::get_b_op(TOKEN_TYPE tk) {
     }
 }
 
-std::string VSCompiler::get_key(VSObject *value) {
-    NEW_IDENTIFIER(__str__);
-    VSObject *value_strobj = CALL_ATTR(value, ID___str__, EMPTY_TUPLE());
-    std::string value_str = STRING_TO_C_STRING(value_strobj);
-    DECREF(value_strobj);
+// check if a val bound value of known type has attr, without running it.
+static bool type_hasattr(SymtableEntry *entry, std::string &attrname) {
+    if (entry->const_value != NULL) {
+        return entry->const_value->hasattr(attrname);
+    }
 
+    VSObject *proto;
+    switch (entry->val_type) {
+        case T_TUPLE:
+            proto = vs_tuple_pack(0);
+            break;
+        case T_LIST:
+            proto = NEW_REF(VSObject *, new VSListObject(0));
+            break;
+        case T_DICT:
+            proto = NEW_REF(VSObject *, new VSDictObject());
+            break;
+        case T_SET:
+            proto = NEW_REF(VSObject *, new VSSetObject());
+            break;
+        default:
+            return false;
+    }
+    bool res = proto->hasattr(attrname);
+    DECREF(proto);
+    return res;
+}
+
+// keys of the constants are made without calls to __str__: none and bools are
+// singletons shared by the compiler workers, which must not call their methods.
+std::string VSCompiler::get_key(VSObject *value) {
     switch (value->type) {
         case T_NONE:
             return "__vs_none__";
         case T_BOOL:
-            return "__vs_bool_" + value_str + "__";
+            return BOOL_TO_C_BOOL(value) ? "__vs_bool_true__" : "__vs_bool_false__";
         case T_CHAR:
-            return "__vs_char_" + value_str + "__";
+            return "__vs_char_" + std::string(1, CHAR_TO_C_CHAR(value)) + "__";
         case T_INT:
-            return "__vs_int_" + value_str + "__";
+            return "__vs_int_" + std::to_string(INT_TO_C_INT(value)) + "__";
         case T_FLOAT:
-            return "__vs_float_" + value_str + "__";
+            return "__vs_float_" + std::to_string(FLOAT_TO_C_FLOAT(value)) + "__";
         case T_STR:
-            return "__vs_str_" + value_str + "__";
-        default:
+            return "__vs_str_" + std::string(STRING_VIEW(value)) + "__";
+        default: {
+            NEW_IDENTIFIER(__str__);
+            VSObject *value_strobj = CALL_ATTR(value, ID___str__, EMPTY_TUPLE());
+            std::string value_str = STRING_TO_C_STRING(value_strobj);
+            DECREF(value_strobj);
             return value_str;
+        }
     }
 }
 
@@ -125,12 +209,12 @@ void VSCompiler::do_store(OPCODE opcode, VSASTNode *lval) {
     switch (lval->node_type) {
         case AST_IDENT: {
             IdentNode *name = (IdentNode *)lval;
-            if (!table->contains_recur(name->name)) {
+            SymtableEntry *entry = table->get_recur(name->name);
+            if (entry == NULL) {
                 err("name \"%s\" is not defined locally, so can not be assigned.",
                     STRING_TO_C_STRING(name->name).c_str());
                 terminate(TERM_ERROR);
             }
-            SymtableEntry *entry = table->get_recur(name->name);
             if (!IS_LOCAL(entry->sym_type) || entry->sym_type == SYM_VAL) {
                 err("name \"%s\" is not defined locally or is immutable, so can not be assigned.",
                     STRING_TO_C_STRING(name->name).c_str());
@@ -187,8 +271,91 @@ void VSCompiler::fill_back_break_continue(vs_addr_t loop_start) {
     delete continues;
 }
 
+VSObject *VSCompiler::fold_const(VSASTNode *node) {
+    if (this->opt_level < VS_OPT_AST) {
+        return NULL;
+    }
+
+    switch (node->node_type) {
+        case AST_CONST:
+            INCREF_RET(((ConstNode *)node)->value);
+        case AST_IDENT: {
+            // val bound to a constant is a constant.
+            SymtableEntry *entry = this->symtables.top()->get_recur(((IdentNode *)node)->name);
+            if (entry != NULL && entry->sym_type == SYM_VAL && entry->const_value != NULL) {
+                INCREF_RET(entry->const_value);
+            }
+            return NULL;
+        }
+        case AST_U_OP_EXPR: {
+            UOPNode *uop_expr = (UOPNode *)node;
+            OPCODE op = uop_expr->opcode == TK_SUB ? OP_NEG : uop_expr->opcode == TK_NOT ? OP_NOT : OP_NOP;
+            if (op == OP_NOP) {
+                return NULL;
+            }
+
+            VSObject *operand = this->fold_const(uop_expr->operand);
+            if (operand == NULL) {
+                return NULL;
+            }
+            VSObject *res = fold_u_op(op, operand);
+            DECREF(operand);
+            return res;
+        }
+        case AST_B_OP_EXPR: {
+            BOPNode *bop_expr = (BOPNode *)node;
+            OPCODE op = get_b_op(bop_expr->opcode);
+            if (op == OP_NOP) {
+                return NULL;
+            }
+
+            VSObject *l_val = this->fold_const(bop_expr->l_operand);
+            if (l_val == NULL) {
+                return NULL;
+            }
+            VSObject *r_val = this->fold_const(bop_expr->r_operand);
+            if (r_val == NULL) {
+                DECREF(l_val);
+                return NULL;
+            }
+
+            VSObject *res = fold_b_op(op, l_val, r_val);
+            DECREF(l_val);
+            DECREF(r_val);
+            return res;
+        }
+        default:
+            return NULL;
+    }
+}
+
+void VSCompiler::optimize(VSCodeObject *code) {
+    for (vs_size_t i = 0; i < code->nconsts; i++) {
+        VSObject *object = LIST_GET(code->consts, i);
+        // code reused from the last compilation is optimized already, deferred
+        // bodies are optimized when generated.
+        if (object->type == T_CODE && AS_CODE(object)->lazy == NULL &&
+            this->reused.find(AS_CODE(object)) == this->reused.end()) {
+            this->optimize(AS_CODE(object));
+        }
+    }
+
+    IRFunction *func = NEW_REF(IRFunction *, new IRFunction(code));
+    func->sccp();
+    func->gvn();
+    func->dce();
+    if (this->ir_dump != NULL) {
+        func->dump(this->ir_dump);
+    }
+    func->emit();
+    DECREF(func);
+}
+
 void VSCompiler::gen_const(VSASTNode *node) {
-    VSObject *value = ((ConstNode *)node)->value;
+    this->gen_const_value(((ConstNode *)node)->value);
+}
+
+void VSCompiler::gen_const_value(VSObject *value) {
     auto consts = conststack.top();
     VSCodeObject *code = codeobjects.top();
     std::string const_key = get_key(value);
@@ -205,8 +372,8 @@ void VSCompiler::gen_ident(VSASTNode *node) {
     VSCodeObject *code = this->codeobjects.top();
 
     IdentNode *ident = (IdentNode *)node;
-    if (table->contains_recur(ident->name)) {
-        SymtableEntry *entry = table->get_recur(ident->name);
+    SymtableEntry *entry = table->get_recur(ident->name);
+    if (entry != NULL) {
         if (IS_LOCAL(entry->sym_type)) {
             code->add_inst(VSInst(OP_LOAD_LOCAL, entry->index));
         } else if (entry->sym_type == SYM_FREE) {
@@ -219,7 +386,6 @@ void VSCompiler::gen_ident(VSASTNode *node) {
             code->add_inst(VSInst(OP_LOAD_FREE, entry->index));
         }
     } else {
-        SymtableEntry *entry;
         auto idx_iter = this->builtins->find(STRING_TO_C_STRING(ident->name));
         if (idx_iter != this->builtins->end()) {
             entry = new SymtableEntry(SYM_BUILTIN, ident->name, idx_iter->second, 0);
@@ -229,13 +395,60 @@ void VSCompiler::gen_ident(VSASTNode *node) {
             code->add_inst(VSInst(OP_LOAD_FREE, entry->index));
             code->add_freevar(ident->name);
         }
-        table->put(ident->name, entry);
+        table->put(entry);
     }
 }
 
+bool VSCompiler::match_iv_product(BOPNode *bop_expr, SymtableEntry *&iv, cint_t &factor) {
+    if (bop_expr->opcode != TK_MUL) {
+        return false;
+    }
+
+    VSASTNode *ident = bop_expr->l_operand, *other = bop_expr->r_operand;
+    if (ident->node_type != AST_IDENT) {
+        std::swap(ident, other);
+    }
+    if (ident->node_type != AST_IDENT) {
+        return false;
+    }
+
+    VSObject *value = this->fold_const(other);
+    if (value == NULL) {
+        return false;
+    }
+    bool res = IS_TYPE(value, T_INT);
+    if (res) {
+        factor = INT_TO_C_INT(value);
+        iv = this->symtables.top()->get_recur(((IdentNode *)ident)->name);
+    }
+    DECREF(value);
+    return res && iv != NULL;
+}
+
 void VSCompiler::gen_b_expr(VSASTNode *node) {
     VSCodeObject *code = this->codeobjects.top();
     BOPNode *bop_expr = (BOPNode *)node;
+
+    VSObject *folded = this->fold_const(node);
+    if (folded != NULL) {
+        this->gen_const_value(folded);
+        DECREF(folded);
+        return;
+    }
+
+    if (!this->reduced.empty()) {
+        // product of an induction var, which is updated with the var.
+        SymtableEntry *iv;
+        cint_t factor;
+        if (this->match_iv_product(bop_expr, iv, factor)) {
+            auto iter = this->reduced.find(std::make_pair(iv, factor));
+            if (iter != this->reduced.end()) {
+                code->add_inst(VSInst(OP_LOAD_LOCAL, iter->second));
+                return;
+            }
+        }
+    }
+
     this->gen_expr(bop_expr->r_operand);
     this->gen_expr(bop_expr->l_operand);
     code->add_inst(VSInst(get_b_op(bop_expr->opcode)));
@@ -244,6 +457,14 @@ void VSCompiler::gen_b_expr(VSASTNode *node) {
 void VSCompiler::gen_u_expr(VSASTNode *node) {
     VSCodeObject *code = this->codeobjects.top();
     UOPNode *uop_expr = (UOPNode *)node;
+
+    VSObject *folded = this->fold_const(node);
+    if (folded != NULL) {
+        this->gen_const_value(folded);
+        DECREF(folded);
+        return;
+    }
+
     this->gen_expr(uop_expr->operand);
     switch (uop_expr->opcode) {
         case TK_SUB:
@@ -265,15 +486,42 @@ void VSCompiler::gen_idx_expr(VSASTNode *node) {
     code->add_inst(VSInst(OP_INDEX_LOAD));
 }
 
+void VSCompiler::gen_slice_expr(VSASTNode *node) {
+    VSCodeObject *code = this->codeobjects.top();
+    SliceExprNode *slice_expr = (SliceExprNode *)node;
+    // bounds left out are none
+    if (slice_expr->end == NULL) {
+        code->add_inst(VSInst(OP_LOAD_CONST, 0));
+    } else {
+        this->gen_expr(slice_expr->end);
+    }
+    if (slice_expr->start == NULL) {
+        code->add_inst(VSInst(OP_LOAD_CONST, 0));
+    } else {
+        this->gen_expr(slice_expr->start);
+    }
+    this->gen_expr(slice_expr->obj);
+    code->add_inst(VSInst(OP_SLICE));
+}
+
 void VSCompiler::gen_dot_expr(VSASTNode *node) {
     name_addr_map *names = this->namestack.top();
     VSCodeObject *code = this->codeobjects.top();
 
     DotExprNode *dot_expr = (DotExprNode *)node;
+    std::string &attrname = STRING_TO_C_STRING(dot_expr->attrname->name);
 
-    this->gen_expr(dot_expr->obj);
+    if (!this->hoisted.empty() && dot_expr->obj->node_type == AST_IDENT) {
+        // attribute already loaded before the loop.
+        SymtableEntry *entry = this->symtables.top()->get_recur(((IdentNode *)dot_expr->obj)->name);
+        auto hoisted_iter = this->hoisted.find(std::make_pair(entry, attrname));
+        if (hoisted_iter != this->hoisted.end()) {
+            code->add_inst(VSInst(OP_LOAD_LOCAL, hoisted_iter->second));
+            return;
+        }
+    }
 
-    std::string &attrname = STRING_TO_C_STRING(dot_expr->attrname->name);
+    this->gen_expr(dot_expr->obj);
 
     auto iter = names->find(attrname);
     if (iter == names->end()) {
@@ -314,11 +562,11 @@ void VSCompiler::gen_dict_decl(VSASTNode *node) {
     VSCodeObject *code = this->codeobjects.top();
     DictDeclNode *dict = (DictDeclNode *)node;
 
+    // each key is pushed over its value, BUILD_DICT pops them in pairs
     for (auto value : dict->values) {
         PairExprNode *pair_expr = (PairExprNode *)value;
         this->gen_expr(pair_expr->value);
         this->gen_expr(pair_expr->key);
-        code->add_inst(VSInst(OP_BUILD_TUPLE, 2));
     }
     code->add_inst(VSInst(OP_BUILD_DICT, dict->values.size()));
 }
@@ -342,6 +590,21 @@ void VSCompiler::gen_func_call(VSASTNode *node) {
         err("internal error: func->args is NULL");
         terminate(TERM_ERROR);
     }
+
+    if (funccall->func->node_type == AST_IDENT) {
+        SymtableEntry *entry = this->symtables.top()->get_recur(((IdentNode *)funccall->func)->name);
+        if (entry != NULL && entry->inline_func != NULL && IS_LOCAL(entry->sym_type)) {
+            vs_size_t nargs = funccall->args->node_type == AST_TUPLE_DECL
+                                  ? ((TupleDeclNode *)funccall->args)->values.size()
+                                  : 1;
+            // leave calls with wrong number of args to the runtime error.
+            if (nargs == entry->inline_func->args.size()) {
+                this->gen_inline_call(entry->inline_func, funccall->args);
+                return;
+            }
+        }
+    }
+
     if (funccall->args->node_type != AST_TUPLE_DECL) {
         this->gen_expr(funccall->args);
         code->add_inst(VSInst(OP_BUILD_TUPLE, 1));
@@ -362,6 +625,22 @@ void VSCompiler::gen_return(VSASTNode *node) {
     } else {
         this->gen_expr(ret->retval);
     }
+
+    if (!this->inlineposes.empty()) {
+        // return of an inlined function, leave the value on the stack and
+        // jump to the end of inlined body.
+        this->inlineposes.top()->push_back(code->ninsts);
+        code->add_inst(VSInst(OP_JMP, 0));
+        return;
+    }
+
+    // a call returned directly reuses the frame. The call may have been inlined,
+    // so check the last instruction, a call ending the inlined body is a tail call too.
+    // Scripts rely on it to recurse in constant stack, so it is done at every opt level.
+    if (ret->retval != NULL && ret->retval->node_type == AST_FUNC_CALL &&
+        code->code.back().opcode == OP_CALL_FUNC) {
+        code->code.back().opcode = OP_TAIL_CALL;
+    }
     code->add_inst(VSInst(OP_RET));
 }
 
@@ -405,6 +684,9 @@ void VSCompiler::gen_expr(VSASTNode *node) {
         case AST_IDX_EXPR:
             this->gen_idx_expr(node);
             break;
+        case AST_SLICE_EXPR:
+            this->gen_slice_expr(node);
+            break;
         case AST_FUNC_CALL:
             this->gen_func_call(node);
             break;
@@ -442,12 +724,11 @@ void VSCompiler::gen_decl_stmt(VSASTNode *node) {
 
     // "decl" is decl node, contains ident and init
     for (auto decl : decl_list->decls) {
-        SymtableEntry *entry;
         VSObject *name_obj = decl->name->name;
         std::string &name_str = STRING_TO_C_STRING(name_obj);
 
-        if (table->contains(name_obj)) {
-            entry = table->get(name_obj);
+        SymtableEntry *entry = table->get(name_obj);
+        if (entry != NULL) {
             if (entry->sym_type != SYM_UNDEFINED) {
                 err("duplicated definition of name: \"%s\"", name_str.c_str());
                 terminate(TERM_ERROR);
@@ -456,7 +737,7 @@ void VSCompiler::gen_decl_stmt(VSASTNode *node) {
             entry->index = code->nlvars;
         } else {
             entry = new SymtableEntry(sym_type, name_obj, code->nlvars, 0);
-            table->put(name_obj, entry);
+            table->put(entry);
         }
 
         if (decl_list->specifier == TK_VAL && decl->init_val == NULL) {
@@ -465,6 +746,35 @@ void VSCompiler::gen_decl_stmt(VSASTNode *node) {
         }
 
         code->add_lvar(name_obj);
+        if (sym_type == SYM_VAL) {
+            // val binding can not be reassigned, so its value and type are known
+            // if its initial value is known.
+            entry->const_value = this->fold_const(decl->init_val);
+            if (entry->const_value != NULL) {
+                entry->val_type = entry->const_value->type;
+            } else {
+                switch (decl->init_val->node_type) {
+                    case AST_TUPLE_DECL:
+                        entry->val_type = T_TUPLE;
+                        break;
+                    case AST_LIST_DECL:
+                        entry->val_type = T_LIST;
+                        break;
+                    case AST_DICT_DECL:
+                        entry->val_type = T_DICT;
+                        break;
+                    case AST_SET_DECL:
+                        entry->val_type = T_SET;
+                        break;
+                    case AST_LAMBDA_DECL:
+                        entry->val_type = T_FUNC;
+                        this->mark_inlinable(entry, (FuncDeclNode *)decl->init_val);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
         // Assign value.
         if (decl->init_val != NULL) {
             this->gen_expr(decl->init_val);
@@ -485,6 +795,102 @@ void VSCompiler::gen_assign_expr(VSASTNode *node) {
     }
 }
 
+void VSCompiler::hoist_attr_loads(std::vector<VSASTNode *> parts, std::vector<std::pair<SymtableEntry *, std::string>> &keys) {
+    if (this->opt_level < VS_OPT_AST) {
+        return;
+    }
+
+    Symtable *table = this->symtables.top();
+    VSCodeObject *code = this->codeobjects.top();
+
+    std::vector<DotExprNode *> loads;
+    for (auto part : parts) {
+        ast_collect_attr_loads(part, loads);
+    }
+
+    for (auto load : loads) {
+        if (load->obj->node_type != AST_IDENT) {
+            continue;
+        }
+
+        // attributes of native objects never change, so attribute loads on a val
+        // bound to a native object are invariant, no matter what user functions
+        // called in the loop do. Attributes of other objects may be changed
+        // by setattr() in any call, so they are not hoisted.
+        SymtableEntry *entry = table->get_recur(((IdentNode *)load->obj)->name);
+        if (entry == NULL || entry->sym_type != SYM_VAL || entry->val_type == T_OBJECT) {
+            continue;
+        }
+
+        std::string &attrname = STRING_TO_C_STRING(load->attrname->name);
+        auto key = std::make_pair(entry, attrname);
+        // a hoisted load should not raise an error that the loop would not raise.
+        if (this->hoisted.find(key) != this->hoisted.end() || !type_hasattr(entry, attrname)) {
+            continue;
+        }
+
+        vs_addr_t index = code->nlvars;
+        std::string lvar = "<" + STRING_TO_C_STRING(entry->symbol) + "." + attrname + ">";
+        this->gen_dot_expr(load);
+        code->add_inst(VSInst(OP_STORE_LOCAL, index));
+        code->add_lvar(C_STRING_TO_STRING(lvar));
+        this->hoisted[key] = index;
+        keys.push_back(key);
+    }
+}
+
+SymtableEntry *VSCompiler::get_induction_var(ForStmtNode *for_stmt, cint_t &init, cint_t &step) {
+    // induction var: "var i = <int>" in init, only updated by "i += <int>",
+    // "i -= <int>" or "i = i + <int>" in incr. Locals can only be stored by
+    // the function itself, so user calls in the loop can not change it.
+    if (for_stmt->init == NULL || for_stmt->init->node_type != AST_INIT_DECL_LIST ||
+        for_stmt->incr == NULL || for_stmt->incr->node_type != AST_ASSIGN_EXPR) {
+        return NULL;
+    }
+
+    InitDeclListNode *decl_list = (InitDeclListNode *)for_stmt->init;
+    if (decl_list->specifier != TK_VAR || decl_list->decls.size() != 1 || decl_list->decls[0]->init_val == NULL) {
+        return NULL;
+    }
+    IdentNode *name = decl_list->decls[0]->name;
+    std::string &name_str = STRING_TO_C_STRING(name->name);
+
+    AssignExprNode *incr = (AssignExprNode *)for_stmt->incr;
+    if (incr->lval->node_type != AST_IDENT || STRING_TO_C_STRING(((IdentNode *)incr->lval)->name) != name_str ||
+        ast_assigns_name(for_stmt->cond, name_str) || ast_assigns_name(for_stmt->body, name_str) ||
+        ast_assigns_name(incr->rval, name_str)) {
+        return NULL;
+    }
+
+    VSASTNode *delta = NULL;
+    bool negative = false;
+    if (incr->opcode == TK_ADD || incr->opcode == TK_SUB) {
+        delta = incr->rval;
+        negative = incr->opcode == TK_SUB;
+    } else if (incr->opcode == TK_NOP && incr->rval->node_type == AST_B_OP_EXPR) {
+        BOPNode *bop_expr = (BOPNode *)incr->rval;
+        if (bop_expr->opcode == TK_ADD && bop_expr->l_operand->node_type == AST_IDENT &&
+            STRING_TO_C_STRING(((IdentNode *)bop_expr->l_operand)->name) == name_str) {
+            delta = bop_expr->r_operand;
+        }
+    }
+    if (delta == NULL) {
+        return NULL;
+    }
+
+    VSObject *init_val = this->fold_const(decl_list->decls[0]->init_val);
+    VSObject *step_val = this->fold_const(delta);
+    bool is_int = init_val != NULL && step_val != NULL && IS_TYPE(init_val, T_INT) && IS_TYPE(step_val, T_INT);
+    if (is_int) {
+        init = INT_TO_C_INT(init_val);
+        step = negative ? -INT_TO_C_INT(step_val) : INT_TO_C_INT(step_val);
+    }
+    DECREF(init_val);
+    DECREF(step_val);
+
+    return is_int ? this->symtables.top()->get(name->name) : NULL;
+}
+
 void VSCompiler::gen_for_stmt(VSASTNode *node) {
     VSCodeObject *code = codeobjects.top();
     ForStmtNode *for_stmt = (ForStmtNode *)node;
@@ -502,6 +908,42 @@ void VSCompiler::gen_for_stmt(VSASTNode *node) {
         }
     }
 
+    std::vector<std::pair<SymtableEntry *, std::string>> hoisted_keys;
+    this->hoist_attr_loads({for_stmt->cond, for_stmt->body, for_stmt->incr}, hoisted_keys);
+
+    // strength reduction: keep products of the induction var in locals and
+    // update them by addition in the incr part.
+    std::vector<std::pair<SymtableEntry *, cint_t>> reduced_keys;
+    cint_t iv_init, iv_step;
+    SymtableEntry *iv = this->get_induction_var(for_stmt, iv_init, iv_step);
+    if (iv != NULL) {
+        std::vector<BOPNode *> muls;
+        ast_collect_muls(for_stmt->cond, muls);
+        ast_collect_muls(for_stmt->body, muls);
+        for (auto mul : muls) {
+            SymtableEntry *entry;
+            cint_t factor;
+            if (!this->match_iv_product(mul, entry, factor) || entry != iv) {
+                continue;
+            }
+            auto key = std::make_pair(iv, factor);
+            if (this->reduced.find(key) != this->reduced.end()) {
+                continue;
+            }
+
+            VSObject *product = NEW_REF(VSObject *, C_INT_TO_INT(iv_init * factor));
+            this->gen_const_value(product);
+            DECREF(product);
+
+            vs_addr_t index = code->nlvars;
+            std::string lvar = "<" + STRING_TO_C_STRING(iv->symbol) + " * " + std::to_string(factor) + ">";
+            code->add_inst(VSInst(OP_STORE_LOCAL, index));
+            code->add_lvar(C_STRING_TO_STRING(lvar));
+            this->reduced[key] = index;
+            reduced_keys.push_back(key);
+        }
+    }
+
     vs_addr_t loop_start = code->ninsts;
 
     if (for_stmt->cond != NULL) {
@@ -522,6 +964,15 @@ void VSCompiler::gen_for_stmt(VSASTNode *node) {
     if (for_stmt->incr != NULL) {
         this->gen_expr_list(for_stmt->incr);
     }
+    for (auto key : reduced_keys) {
+        VSObject *delta = NEW_REF(VSObject *, C_INT_TO_INT(iv_step * key.second));
+        vs_addr_t index = this->reduced[key];
+        this->gen_const_value(delta);
+        code->add_inst(VSInst(OP_LOAD_LOCAL, index));
+        code->add_inst(VSInst(OP_ADD));
+        code->add_inst(VSInst(OP_STORE_LOCAL, index));
+        DECREF(delta);
+    }
 
     code->add_inst(VSInst(OP_JMP, loop_start));
     // jmp is the following inst of jif, so jif + 1 is the pos of jmp.
@@ -531,6 +982,13 @@ void VSCompiler::gen_for_stmt(VSASTNode *node) {
     // incr_start as jump target of continue statements.
     this->fill_back_break_continue(incr_start);
 
+    for (auto key : hoisted_keys) {
+        this->hoisted.erase(key);
+    }
+    for (auto key : reduced_keys) {
+        this->reduced.erase(key);
+    }
+
     LEAVE_BLK();
 }
 
@@ -540,19 +998,26 @@ void VSCompiler::set_up_cellvars() {
 
     for (vs_size_t i = 0; i < code->ncellvars; i++) {
         VSObject *cellvar = LIST_GET(code->cellvars, i);
-        if (!table->contains(cellvar)) {
+        // free vars of a deferred body are resolved already, in the table
+        // outside the function table.
+        SymtableEntry *entry = table->get_recur(cellvar);
+        if (entry == NULL) {
             err("internal error: cellvar \"%s\" is used by not defined",
                 STRING_TO_C_STRING(cellvar).c_str());
             terminate(TERM_ERROR);
         }
 
-        SymtableEntry *entry = table->get(cellvar);
+        SymtableEntry *outer = table->has_parent() ? table->get_parent()->get(cellvar) : NULL;
         if (IS_LOCAL(entry->sym_type)) {
             // cell var is defined locally.
             code->add_inst(VSInst(OP_LOAD_LOCAL_CELL, entry->index));
         } else if (entry->sym_type == SYM_FREE) {
             // cell var is a free var of current code object.
             code->add_inst(VSInst(OP_LOAD_FREE_CELL, entry->index));
+        } else if (outer != NULL) {
+            entry->sym_type = SYM_FREE;
+            entry->index = outer->index;
+            code->add_inst(VSInst(OP_LOAD_FREE_CELL, entry->index));
         } else {
             // cell var is undefined, which means it is used by inner functions
             // but not used or defined by current function it self. It should be a
@@ -566,16 +1031,34 @@ void VSCompiler::set_up_cellvars() {
     }
 }
 
+void VSCompiler::move_to_head(vs_addr_t pos) {
+    VSCodeObject *code = this->codeobjects.top();
+
+    // cell vars are only known after the body is generated, so the set up code
+    // is generated at the tail and moved to the head, then the body needs no
+    // jumps around it.
+    vs_size_t nmoved = code->ninsts - pos;
+    std::vector<VSInst> insts(code->code.begin() + pos, code->code.end());
+    for (vs_addr_t i = 0; i < pos; i++) {
+        const VSInst &inst = code->code[i];
+        if (inst.opcode == OP_JMP || inst.opcode == OP_JIF) {
+            insts.push_back(VSInst(inst.opcode, inst.operand + nmoved));
+        } else {
+            insts.push_back(inst);
+        }
+    }
+    code->code.swap(insts);
+}
+
 void VSCompiler::gen_build_func(VSCodeObject *code, bool anonymous) {
     Symtable *p_table = this->symtables.top();
     VSCodeObject *p_code = this->codeobjects.top();
 
     for (vs_size_t i = 0; i < code->nfreevars; i++) {
-        SymtableEntry *entry;
         VSObject *freevar = LIST_GET(code->freevars, i);
-        if (p_table->contains(freevar)) {
+        SymtableEntry *entry = p_table->get(freevar);
+        if (entry != NULL) {
             // free var is defined in parent code object's symtable.
-            entry = p_table->get(freevar);
             if (!entry->is_cell) {
                 entry->cell_index = p_code->ncellvars;
                 p_code->add_cellvar(freevar);
@@ -584,7 +1067,7 @@ void VSCompiler::gen_build_func(VSCodeObject *code, bool anonymous) {
         } else {
             // freevar is currently not defined.
             entry = new SymtableEntry(SYM_UNDEFINED, freevar, 0, p_code->ncellvars);
-            p_table->put(freevar, entry);
+            p_table->put(entry);
             p_code->add_cellvar(freevar);
             entry->is_cell = true;
         }
@@ -599,32 +1082,127 @@ void VSCompiler::gen_build_func(VSCodeObject *code, bool anonymous) {
     }
 }
 
-void VSCompiler::gen_func_decl(VSASTNode *node) {
-    static VSObject *ANONYMOUS_FUNC_NAME = C_STRING_TO_STRING("<__anonymous_function__>");
+void VSCompiler::mark_inlinable(SymtableEntry *entry, FuncDeclNode *func) {
+    if (this->opt_level >= VS_OPT_AST && ast_inlinable(func, this->builtins)) {
+        entry->inline_func = func;
+    }
+}
+
+void VSCompiler::gen_inline_call(FuncDeclNode *func, VSASTNode *args) {
+    VSCodeObject *code = this->codeobjects.top();
+
+    // evaluate args from end to start, so the first arg is on the top.
+    if (args->node_type == AST_TUPLE_DECL) {
+        TupleDeclNode *tuple = (TupleDeclNode *)args;
+        int index = tuple->values.size() - 1;
+        while (index >= 0) {
+            this->gen_expr(tuple->values[index]);
+            index--;
+        }
+    } else {
+        this->gen_expr(args);
+    }
+
+    // the inlined body only sees its args, its own locals and builtins, which
+    // are all remapped to new locals of the caller.
+    this->symtables.push(new Symtable(NULL));
+    INCREF(this->symtables.top());
+    Symtable *table = this->symtables.top();
+    for (auto argnode : func->args) {
+        VSObject *argname = ((IdentNode *)argnode)->name;
+        table->put(new SymtableEntry(SYM_ARG, argname, code->nlvars, 0));
+        code->add_inst(VSInst(OP_STORE_LOCAL, code->nlvars));
+        code->add_lvar(argname);
+    }
+
+    auto rets = new std::vector<vs_addr_t>();
+    this->inlineposes.push(rets);
+
+    CpdStmtNode *body = (CpdStmtNode *)func->body;
+    this->gen_cpd_stmt(body);
+
+    if (!body->values.empty() && body->values.back()->node_type == AST_RETURN) {
+        // the trailing return falls through to the end, drop its jump.
+        rets->pop_back();
+        code->code.pop_back();
+        code->ninsts--;
+    } else {
+        // default return none
+        code->add_inst(VSInst(OP_LOAD_CONST, 0));
+    }
 
+    for (auto ret_pos : *rets) {
+        code->code[ret_pos].operand = code->ninsts;
+    }
+    this->inlineposes.pop();
+    delete rets;
+
+    LEAVE_BLK();
+}
+
+void VSCompiler::gen_func_decl(VSASTNode *node) {
     Symtable *p_table = this->symtables.top();
     VSCodeObject *p_code = this->codeobjects.top();
 
     FuncDeclNode *func = (FuncDeclNode *)node;
 
     bool anonymous = func->name == NULL;
-    VSObject *name = anonymous ? ANONYMOUS_FUNC_NAME : func->name->name;
-
     if (!anonymous) {
         // Add function name to parent code locals.
+        VSObject *name = func->name->name;
         if (p_table->contains(name)) {
             err("duplicated definition of name: \"%s\"", STRING_TO_C_STRING(name).c_str());
             terminate(TERM_ERROR);
         }
         // create symtable entry
-        p_table->put(name, new SymtableEntry(SYM_VAR, name, p_code->nlvars, 0));
+        SymtableEntry *entry = new SymtableEntry(SYM_VAR, name, p_code->nlvars, 0);
+        p_table->put(entry);
+        // function name can be inlined only if it is never reassigned.
+        if (this->assigned.find(STRING_TO_C_STRING(name)) == this->assigned.end()) {
+            this->mark_inlinable(entry, func);
+        }
+    }
+
+    // the body only refers to its own symtable, so it is compiled in a context
+    // of its own, unless a worker thread has compiled it already.
+    VSCodeObject *code;
+    auto iter = this->compiled.find(func);
+    if (iter != this->compiled.end()) {
+        code = iter->second;
+        this->compiled.erase(iter);
+    } else {
+        VSCompiler compiler(this->builtins, this->opt_level, NULL, 1, false);
+        code = compiler.gen_func_body(func, NULL);
+    }
+
+    // Add instructions to build function
+    this->gen_build_func(code, anonymous);
+
+    if (!anonymous) {
+        p_code->add_lvar(code->name);
     }
+    p_code->add_const(code);
+}
 
-    ENTER_FUNC((VSStringObject *)name);
+VSCodeObject *VSCompiler::gen_func_body(FuncDeclNode *func, VSCodeObject *stub) {
+    VSCodeObject *code = stub;
+    Symtable *outer = NULL;
+    if (stub == NULL) {
+        VSObject *name = func->name == NULL ? C_STRING_TO_STRING("<__anonymous_function__>") : func->name->name;
+        code = new VSCodeObject((VSStringObject *)name);
+    } else {
+        // the body of a stub is generated into it, and refers to the free vars
+        // the stub is built with by their indices.
+        outer = new Symtable(NULL);
+        for (vs_size_t i = 0; i < stub->nfreevars; i++) {
+            VSObject *freevar = LIST_GET(stub->freevars, i);
+            outer->put(new SymtableEntry(SYM_FREE, freevar, i, 0));
+        }
+    }
+
+    ENTER_FUNC(code, outer);
 
     Symtable *table = this->symtables.top();
-    // Add function code to parent code consts.
-    VSCodeObject *code = this->codeobjects.top();
 
     // Set flags.
     code->flags |= func->va_args ? VS_FUNC_VARARGS : 0;
@@ -637,15 +1215,14 @@ void VSCompiler::gen_func_decl(VSASTNode *node) {
         } else {
             argname = ((InitDeclNode *)argnode)->name->name;
         }
-        table->put(argname, new SymtableEntry(SYM_ARG, argname, code->nlvars, 0));
+        table->put(new SymtableEntry(SYM_ARG, argname, code->nlvars, 0));
         code->add_arg(argname);
     }
 
-    // should set up cell vars first, so jump.
-    vs_size_t start_pos = code->ninsts;
-    code->add_inst(VSInst(OP_JMP, 0));
-
     // gen function body.
+    if (this->opt_level >= VS_OPT_AST) {
+        ast_collect_assigned(func->body, this->assigned);
+    }
     this->gen_cpd_stmt(func->body);
 
     // default return none
@@ -653,21 +1230,115 @@ void VSCompiler::gen_func_decl(VSASTNode *node) {
     code->add_inst(VSInst(OP_RET));
 
     // set up cell vars
-    code->code[start_pos].operand = code->ninsts;
+    vs_addr_t setup_pos = code->ninsts;
     this->set_up_cellvars();
-
-    // jump back to the function body start point
-    code->add_inst(VSInst(OP_JMP, start_pos + 1));
+    this->move_to_head(setup_pos);
 
     LEAVE_FUNC();
 
-    // Add instructions to build function
-    this->gen_build_func(code, anonymous);
+    return code;
+}
 
-    if (!anonymous) {
-        p_code->add_lvar(code->name);
+void VSCompiler::compile_funcs(VSASTNode *node, VSTokenizer *tokenizer) {
+    std::vector<FuncDeclNode *> funcs;
+    ast_collect_funcs(node, funcs);
+
+    // a body depends on nothing but its text, the builtins and the opt level,
+    // the names it captures included. The last two are fixed for a compiler,
+    // so a function with the same text as in the last compilation reuses its code.
+    std::vector<std::string> texts;
+    std::vector<FuncDeclNode *> jobs;
+    for (auto func : funcs) {
+        texts.push_back(tokenizer->text(func->span_start, func->span_end));
+        auto iter = this->cache.find(texts.back());
+        if (iter != this->cache.end()) {
+            this->compiled[func] = iter->second;
+            this->reused.insert(iter->second);
+        } else {
+            jobs.push_back(func);
+        }
     }
-    p_code->add_const(code);
+    this->nreused = funcs.size() - jobs.size();
+    this->nrecompiled = jobs.size();
+
+    // a deferred body only needs its free vars now, for the parent to build the
+    // function with. Bodies that would fail to generate are generated now, so
+    // their errors are still reported before the program runs.
+    if (this->lazy && !jobs.empty()) {
+        VSLazyAST *ast = NEW_REF(VSLazyAST *, new VSLazyAST(VSArena::current, node));
+        std::vector<FuncDeclNode *> eager;
+        for (auto func : jobs) {
+            std::vector<std::string> freevars;
+            if (!ast_free_vars(func, this->builtins, freevars)) {
+                eager.push_back(func);
+                continue;
+            }
+
+            VSObject *name = func->name == NULL ? C_STRING_TO_STRING("<__anonymous_function__>") : func->name->name;
+            VSCodeObject *code = new VSCodeObject((VSStringObject *)name);
+            code->flags |= func->va_args ? VS_FUNC_VARARGS : 0;
+            for (auto &freevar : freevars) {
+                code->add_freevar(C_STRING_TO_STRING(freevar));
+            }
+            code->lazy = NEW_REF(VSLazyBody *, new VSLazyFunc(func, this->builtins, this->opt_level, ast));
+            this->compiled[func] = code;
+        }
+        DECREF(ast);
+        jobs.swap(eager);
+    }
+
+    vs_size_t nthreads = std::min((vs_size_t)this->nthreads, (vs_size_t)jobs.size());
+    if (jobs.size() < VS_PARALLEL_MIN_FUNCS) {
+        nthreads = 1;
+    }
+
+    // singletons are shared by all workers, create them before the workers start.
+    // Their refcnt is immortal, so workers only read it, and they never call
+    // methods on them, see get_key and fold_bool_op.
+    (void)VS_NONE;
+    (void)VS_TRUE;
+    (void)VS_FALSE;
+    (void)VS_ZERO;
+    (void)VS_ONE;
+    DECREF(EMPTY_TUPLE());
+
+    // each body is compiled by a compiler of its own and touches no state of
+    // the others, so workers only share the index of the next function.
+    std::vector<VSCodeObject *> codes(jobs.size());
+    std::atomic<vs_size_t> next(0);
+    auto worker = [&]() {
+        for (vs_size_t i = next++; i < jobs.size(); i = next++) {
+            VSCompiler compiler(this->builtins, this->opt_level, NULL, 1, false);
+            codes[i] = compiler.gen_func_body(jobs[i], NULL);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (vs_size_t i = 1; i < nthreads; i++) {
+        threads.push_back(std::thread(worker));
+    }
+    worker();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+
+    for (vs_size_t i = 0; i < jobs.size(); i++) {
+        this->compiled[jobs[i]] = codes[i];
+    }
+
+    // keep only the functions of this compilation for the next one.
+    std::unordered_map<std::string, VSCodeObject *> cache;
+    for (vs_size_t i = 0; i < funcs.size(); i++) {
+        if (cache.find(texts[i]) == cache.end()) {
+            VSCodeObject *code = this->compiled[funcs[i]];
+            INCREF(code);
+            cache[texts[i]] = code;
+        }
+    }
+    for (auto &entry : this->cache) {
+        DECREF(entry.second);
+    }
+    this->cache.swap(cache);
 }
 
 void VSCompiler::gen_elif_list(VSASTNode *node) {
@@ -752,6 +1423,9 @@ void VSCompiler::gen_while_stmt(VSASTNode *node) {
     this->breakposes.push(new std::vector<vs_addr_t>());
     this->continueposes.push(new std::vector<vs_addr_t>());
 
+    std::vector<std::pair<SymtableEntry *, std::string>> hoisted_keys;
+    this->hoist_attr_loads({while_stmt->cond, while_stmt->body}, hoisted_keys);
+
     int loop_start = code->ninsts;
     if (while_stmt->cond != NULL) {
         this->gen_expr(while_stmt->cond);
@@ -772,10 +1446,23 @@ void VSCompiler::gen_while_stmt(VSASTNode *node) {
     code->code[jif_pos + 1].operand = code->ninsts;
 
     this->fill_back_break_continue(loop_start);
+
+    for (auto key : hoisted_keys) {
+        this->hoisted.erase(key);
+    }
 }
 
 void VSCompiler::gen_cpd_stmt(VSASTNode *node) {
     CpdStmtNode *cpd_stmt = (CpdStmtNode *)node;
+    VSCodeObject *code = this->codeobjects.top();
+
+    // statements after return, break or continue are never run. They are still
+    // compiled, so names declared there stay visible to inner functions, then
+    // their code and the jumps recorded by them are dropped.
+    bool dead = false;
+    vs_addr_t dead_pos = 0;
+    vs_size_t nbreaks = 0, ncontinues = 0, ninlines = 0;
+
     for (auto stmt : cpd_stmt->values) {
         switch (stmt->node_type) {
             case AST_INIT_DECL_LIST:
@@ -816,26 +1503,69 @@ void VSCompiler::gen_cpd_stmt(VSASTNode *node) {
                 this->gen_expr_list(stmt);
                 break;
         }
+
+        if (!dead && (stmt->node_type == AST_RETURN || stmt->node_type == AST_BREAK ||
+                      stmt->node_type == AST_CONTINUE)) {
+            dead = true;
+            dead_pos = code->ninsts;
+            nbreaks = this->breakposes.empty() ? 0 : this->breakposes.top()->size();
+            ncontinues = this->continueposes.empty() ? 0 : this->continueposes.top()->size();
+            ninlines = this->inlineposes.empty() ? 0 : this->inlineposes.top()->size();
+        }
+    }
+
+    if (dead) {
+        std::vector<VSInst> insts(code->code.begin(), code->code.begin() + dead_pos);
+        code->code.swap(insts);
+        code->ninsts = dead_pos;
+        if (!this->breakposes.empty()) {
+            this->breakposes.top()->resize(nbreaks);
+        }
+        if (!this->continueposes.empty()) {
+            this->continueposes.top()->resize(ncontinues);
+        }
+        if (!this->inlineposes.empty()) {
+            this->inlineposes.top()->resize(ninlines);
+        }
     }
 }
 
 VSCodeObject *VSCompiler::compile(std::string filename) {
-    VSTokenizer *tokenizer = new VSTokenizer(fopen(filename.c_str(), "r"));
+    FILE *file = fopen(filename.c_str(), "r");
+    if (file == NULL) {
+        err("unable to open file: \"%s\"", filename.c_str());
+        terminate(TERM_ERROR);
+    }
+
+    // tokens and ast nodes of the compilation are freed with the arena.
+    VSArenaScope arena;
+    return this->compile(new VSTokenizer(file));
+}
+
+VSCodeObject *VSCompiler::compile_source(std::string source) {
+    VSArenaScope arena;
+    return this->compile(new VSTokenizer(source));
+}
+
+VSCodeObject *VSCompiler::compile(VSTokenizer *tokenizer) {
     VSParser *parser = new VSParser(tokenizer);
 
     INCREF(parser);
 
-    ENTER_FUNC(C_STRING_TO_STRING("__main__"));
+    ENTER_FUNC(new VSCodeObject(C_STRING_TO_STRING("__main__")), NULL);
 
     Symtable *table = this->symtables.top();
     VSCodeObject *program = this->codeobjects.top();
 
-    // should set up cell vars first, so jump.
-    vs_size_t start_pos = program->ninsts;
-    program->add_inst(VSInst(OP_JMP, 0));
-
     // generate top level code object.
     VSASTNode *astree = parser->parse();
+    INCREF(astree);
+    this->assigned.clear();
+    this->reused.clear();
+    this->compile_funcs(astree, tokenizer);
+    if (this->opt_level >= VS_OPT_AST) {
+        ast_collect_assigned(astree, this->assigned);
+    }
     this->gen_cpd_stmt(astree);
 
     program->add_inst(VSInst(OP_RET));
@@ -852,16 +1582,14 @@ VSCodeObject *VSCompiler::compile(std::string filename) {
     // all cell vars in top level code object should be locally defined.
     for (vs_size_t i = 0; i < program->ncellvars; i++) {
         VSObject *cellvar = LIST_GET(program->cellvars, i);
-        if (!table->contains(cellvar)) {
+        SymtableEntry *entry = table->get(cellvar);
+        if (entry == NULL) {
             err("internal error: cell var \"%s\" is used but not defined",
                 STRING_TO_C_STRING(cellvar).c_str());
             error = true;
-        } else {
-            SymtableEntry *entry = table->get(cellvar);
-            if (entry->sym_type == SYM_FREE || entry->sym_type == SYM_UNDEFINED) {
-                err("name: \"%s\" is not defined", STRING_TO_C_STRING(cellvar).c_str());
-                error = true;
-            }
+        } else if (entry->sym_type == SYM_FREE || entry->sym_type == SYM_UNDEFINED) {
+            err("name: \"%s\" is not defined", STRING_TO_C_STRING(cellvar).c_str());
+            error = true;
         }
     }
 
@@ -870,19 +1598,24 @@ VSCodeObject *VSCompiler::compile(std::string filename) {
     }
 
     // set up cell vars
-    program->code[start_pos].operand = program->ninsts;
+    vs_addr_t setup_pos = program->ninsts;
     for (vs_size_t i = 0; i < program->ncellvars; i++) {
         VSObject *cellvar = LIST_GET(program->cellvars, i);
         program->add_inst(VSInst(OP_LOAD_LOCAL_CELL, table->get(cellvar)->index));
         program->add_inst(VSInst(OP_STORE_CELL, i));
     }
+    this->move_to_head(setup_pos);
 
-    // jump back to the function body start point
-    program->add_inst(VSInst(OP_JMP, start_pos + 1));
+    if (this->opt_level >= VS_OPT_SSA) {
+        this->optimize(program);
+    }
 
     LEAVE_FUNC();
 
+    // nothing refers to the tokens and the ast after compilation.
+    DECREF(astree);
     DECREF(parser);
+    DECREF(tokenizer);
 
     return program;
 }
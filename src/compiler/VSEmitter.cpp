@@ -0,0 +1,360 @@
+#include "compiler/VSEmitter.hpp"
+
+#include <ctype.h>
+#include <math.h>
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "error.hpp"
+#include "objects/VSBoolObject.hpp"
+#include "objects/VSCharObject.hpp"
+#include "objects/VSFloatObject.hpp"
+#include "objects/VSIntObject.hpp"
+#include "runtime/VSOps.hpp"
+
+typedef std::unordered_map<VSCodeObject *, int> code_id_map;
+
+// number the code objects of the program, children before their parents so
+// that each builder is defined before it is called.
+static void number_code(VSCodeObject *code, code_id_map &ids, std::vector<VSCodeObject *> &order) {
+    if (ids.find(code) != ids.end()) {
+        return;
+    }
+    ids[code] = -1;
+
+    code->load();
+    for (vs_size_t i = 0; i < code->nconsts; i++) {
+        VSObject *obj = LIST_GET(code->consts, i);
+        if (obj->type == T_CODE) {
+            number_code(AS_CODE(obj), ids, order);
+        }
+    }
+
+    ids[code] = order.size();
+    order.push_back(code);
+}
+
+// c++ string literal of a vs string, octal escapes keep the bytes exact.
+static std::string str_literal(std::string &str) {
+    std::string res = "\"";
+    char buf[8];
+    for (unsigned char c : str) {
+        if (c == '"' || c == '\\') {
+            res += '\\';
+            res += c;
+        } else if (c < 0x20 || c >= 0x7f || c == '?') {
+            snprintf(buf, sizeof(buf), "\\%03o", c);
+            res += buf;
+        } else {
+            res += c;
+        }
+    }
+    return res + "\"";
+}
+
+static std::string float_literal(cfloat_t value) {
+    char buf[64];
+    if (isnan(value)) {
+        return "NAN";
+    } else if (isinf(value)) {
+        return value > 0 ? "INFINITY" : "-INFINITY";
+    }
+    snprintf(buf, sizeof(buf), "%LaL", value);
+    return buf;
+}
+
+static void emit_const(FILE *file, VSObject *obj, code_id_map &ids) {
+    switch (obj->type) {
+        case T_NONE:
+            fprintf(file, "VS_NONE");
+            break;
+        case T_BOOL:
+            fprintf(file, "C_BOOL_TO_BOOL(%s)", BOOL_TO_C_BOOL(obj) ? "true" : "false");
+            break;
+        case T_CHAR:
+            fprintf(file, "C_CHAR_TO_CHAR((cchar_t)%d)", (int)CHAR_TO_C_CHAR(obj));
+            break;
+        case T_INT:
+            fprintf(file, "C_INT_TO_INT((cint_t)%lluULL)", (unsigned long long)INT_TO_C_INT(obj));
+            break;
+        case T_FLOAT:
+            fprintf(file, "C_FLOAT_TO_FLOAT(%s)", float_literal(FLOAT_TO_C_FLOAT(obj)).c_str());
+            break;
+        case T_STR: {
+            std::string &str = STRING_TO_C_STRING(obj);
+            fprintf(file, "C_STRING_TO_STRING(std::string(%s, %lu))", str_literal(str).c_str(), str.length());
+            break;
+        }
+        case T_CODE:
+            fprintf(file, "vs_code_%d()", ids[AS_CODE(obj)]);
+            break;
+        default:
+            err("Internal error: can not emit \"%s\" constant", TYPE_STR[obj->type]);
+            terminate(TERM_ERROR);
+    }
+}
+
+static void emit_names(FILE *file, VSListObject *names, vs_size_t nnames, vs_size_t start, const char *method) {
+    for (vs_size_t i = start; i < nnames; i++) {
+        std::string &name = STRING_TO_C_STRING(LIST_GET(names, i));
+        fprintf(file, "    code->%s(C_STRING_TO_STRING(std::string(%s, %lu)));\n",
+                method, str_literal(name).c_str(), name.length());
+    }
+}
+
+// the body, one block of calls into the runtime ops per instruction and a
+// goto per jump. It stops at RET and at tail calls left to eval like exec does.
+static void emit_body(FILE *file, VSCodeObject *code, int id) {
+    std::set<vs_addr_t> targets;
+    bool uses[3] = {false, false, false};
+    bool uses_code = false;
+    for (auto &inst : code->code) {
+        switch (inst.opcode) {
+            case OP_JMP:
+                if (inst.operand >= code->ninsts) {
+                    err("Internal error: invalid jump target: %llu, max: %llu", inst.operand, code->ninsts - 1);
+                    terminate(TERM_ERROR);
+                }
+                targets.insert(inst.operand);
+                break;
+            case OP_JIF:
+                targets.insert(inst.operand);
+                break;
+            case OP_LOAD_LOCAL:
+            case OP_LOAD_LOCAL_CELL:
+            case OP_STORE_LOCAL:
+                uses[0] = true;
+                break;
+            case OP_LOAD_FREE:
+            case OP_LOAD_FREE_CELL:
+            case OP_STORE_FREE:
+                uses[1] = true;
+                break;
+            case OP_LOAD_CELL:
+            case OP_STORE_CELL:
+                uses[2] = true;
+                break;
+            case OP_LOAD_ATTR:
+            case OP_STORE_ATTR:
+            case OP_LOAD_CONST:
+                uses_code = true;
+                break;
+            default:
+                break;
+        }
+    }
+
+    fprintf(file, "static bool vs_native_%d(\n", id);
+    fprintf(file, "    cpt_stack_t &stack, vs_addr_t &pc, VSCodeObject *%s, VSTupleObject *%s,\n",
+            uses_code ? "code" : "", uses[0] ? "locals" : "");
+    fprintf(file, "    VSTupleObject *%s, VSTupleObject *%s) {\n", uses[1] ? "freevars" : "", uses[2] ? "cellvars" : "");
+    if (uses[0]) {
+        fprintf(file, "    vs_size_t nlocals = locals == NULL ? 0 : TUPLE_LEN(locals);\n");
+    }
+    if (uses[1]) {
+        fprintf(file, "    vs_size_t nfreevars = freevars == NULL ? 0 : TUPLE_LEN(freevars);\n");
+    }
+    if (uses[2]) {
+        fprintf(file, "    vs_size_t ncellvars = cellvars == NULL ? 0 : TUPLE_LEN(cellvars);\n");
+    }
+
+    for (vs_addr_t pc = 0; pc < code->ninsts; pc++) {
+        VSInst &inst = code->code[pc];
+        if (targets.find(pc) != targets.end()) {
+            fprintf(file, "L%llu:\n", pc);
+        }
+        switch (inst.opcode) {
+            case OP_POP:
+                fprintf(file, "    vs_op_pop(stack);\n");
+                break;
+            case OP_ADD:
+                // a store to a local right after the add makes locals used
+                if (vs_add_dest(code, pc) != 0) {
+                    fprintf(file, "    vs_op_add(stack, locals, nlocals, %llu);\n", vs_add_dest(code, pc));
+                } else {
+                    fprintf(file, "    vs_op_add(stack, NULL, 0, 0);\n");
+                }
+                break;
+            case OP_SUB:
+            case OP_MUL:
+            case OP_DIV:
+            case OP_MOD:
+            case OP_LT:
+            case OP_GT:
+            case OP_LE:
+            case OP_GE:
+            case OP_EQ:
+            case OP_AND:
+            case OP_XOR:
+            case OP_OR: {
+                std::string method = OPCODE_STR[inst.opcode];
+                for (auto &c : method) {
+                    c = tolower(c);
+                }
+                fprintf(file, "    vs_op_binary(stack, ID___%s__);\n", method.c_str());
+                break;
+            }
+            case OP_NEQ:
+                fprintf(file, "    vs_op_neq(stack);\n");
+                break;
+            case OP_NOT:
+                fprintf(file, "    vs_op_unary(stack, ID___not__);\n");
+                break;
+            case OP_NEG:
+                fprintf(file, "    vs_op_unary(stack, ID___neg__);\n");
+                break;
+            case OP_BUILD_TUPLE:
+                fprintf(file, "    vs_op_build_tuple(stack, %llu);\n", inst.operand);
+                break;
+            case OP_BUILD_LIST:
+                fprintf(file, "    vs_op_build_list(stack, %llu);\n", inst.operand);
+                break;
+            case OP_BUILD_DICT:
+                fprintf(file, "    vs_op_build_dict(stack, %llu);\n", inst.operand);
+                break;
+            case OP_BUILD_SET:
+                fprintf(file, "    vs_op_build_set(stack, %llu);\n", inst.operand);
+                break;
+            case OP_INDEX_LOAD:
+                fprintf(file, "    vs_op_index_load(stack);\n");
+                break;
+            case OP_INDEX_STORE:
+                fprintf(file, "    vs_op_index_store(stack);\n");
+                break;
+            case OP_SLICE:
+                fprintf(file, "    vs_op_slice(stack);\n");
+                break;
+            case OP_LOAD_LOCAL:
+                fprintf(file, "    vs_op_load_var(stack, locals, nlocals, %llu, \"local\");\n", inst.operand);
+                break;
+            case OP_LOAD_FREE:
+                fprintf(file, "    vs_op_load_var(stack, freevars, nfreevars, %llu, \"free\");\n", inst.operand);
+                break;
+            case OP_LOAD_CELL:
+                fprintf(file, "    vs_op_load_cell(stack, cellvars, ncellvars, %llu, \"cell\");\n", inst.operand);
+                break;
+            case OP_LOAD_LOCAL_CELL:
+                fprintf(file, "    vs_op_load_cell(stack, locals, nlocals, %llu, \"local\");\n", inst.operand);
+                break;
+            case OP_LOAD_FREE_CELL:
+                fprintf(file, "    vs_op_load_cell(stack, freevars, nfreevars, %llu, \"free\");\n", inst.operand);
+                break;
+            case OP_LOAD_ATTR:
+                fprintf(file, "    vs_op_load_attr(stack, code, %llu);\n", inst.operand);
+                break;
+            case OP_STORE_LOCAL:
+                fprintf(file, "    vs_op_store_var(stack, locals, nlocals, %llu, \"local\");\n", inst.operand);
+                break;
+            case OP_STORE_FREE:
+                fprintf(file, "    vs_op_store_var(stack, freevars, nfreevars, %llu, \"free\");\n", inst.operand);
+                break;
+            case OP_STORE_CELL:
+                fprintf(file, "    vs_op_store_cell(stack, cellvars, ncellvars, %llu);\n", inst.operand);
+                break;
+            case OP_STORE_ATTR:
+                fprintf(file, "    vs_op_store_attr(stack, code, %llu);\n", inst.operand);
+                break;
+            case OP_LOAD_CONST:
+                fprintf(file, "    vs_op_load_const(stack, code, %llu);\n", inst.operand);
+                break;
+            case OP_LOAD_BUILTIN:
+                fprintf(file, "    vs_op_load_builtin(stack, %llu);\n", inst.operand);
+                break;
+            case OP_JMP:
+                fprintf(file, "    goto L%llu;\n", inst.operand);
+                break;
+            case OP_JIF:
+                fprintf(file, "    if (vs_op_cond(stack)) goto L%llu;\n", inst.operand);
+                break;
+            case OP_BUILD_FUNC:
+                fprintf(file, "    vs_op_build_func(stack);\n");
+                break;
+            case OP_TAIL_CALL:
+                fprintf(file, "    if (vs_op_tail_call(stack)) { pc = %llu; return true; }\n", pc);
+                fprintf(file, "    vs_op_call_func(stack);\n");
+                break;
+            case OP_CALL_FUNC:
+                fprintf(file, "    vs_op_call_func(stack);\n");
+                break;
+            case OP_RET:
+                fprintf(file, "    pc = %llu; return true;\n", pc);
+                break;
+            default:
+                break;
+        }
+    }
+
+    // jumps past the last instruction end the code.
+    if (targets.find(code->ninsts) != targets.end()) {
+        fprintf(file, "L%llu:\n", code->ninsts);
+    }
+    fprintf(file, "    pc = %llu;\n", code->ninsts);
+    fprintf(file, "    return true;\n");
+    fprintf(file, "}\n\n");
+}
+
+// the builder, which makes a code object like the compiler does with the
+// native body attached. The instructions are kept for eval and printers.
+static void emit_builder(FILE *file, VSCodeObject *code, int id, code_id_map &ids) {
+    fprintf(file, "static VSCodeObject *vs_code_%d() {\n", id);
+    std::string &name = STRING_TO_C_STRING(code->name);
+    fprintf(file, "    VSCodeObject *code = new VSCodeObject(C_STRING_TO_STRING(std::string(%s, %lu)));\n",
+            str_literal(name).c_str(), name.length());
+    fprintf(file, "    code->flags = %d;\n", code->flags);
+
+    // args are the first local vars.
+    emit_names(file, code->lvars, code->nargs, 0, "add_arg");
+    emit_names(file, code->lvars, code->nlvars, code->nargs, "add_lvar");
+    emit_names(file, code->names, code->nnames, 0, "add_name");
+    emit_names(file, code->cellvars, code->ncellvars, 0, "add_cellvar");
+    emit_names(file, code->freevars, code->nfreevars, 0, "add_freevar");
+
+    // const 0 is the none added by the constructor.
+    for (vs_size_t i = 1; i < code->nconsts; i++) {
+        fprintf(file, "    code->add_const(");
+        emit_const(file, LIST_GET(code->consts, i), ids);
+        fprintf(file, ");\n");
+    }
+
+    for (auto &inst : code->code) {
+        fprintf(file, "    code->add_inst(VSInst(OP_%s, %llu));\n", OPCODE_STR[inst.opcode], inst.operand);
+    }
+    fprintf(file, "    code->native = vs_native_%d;\n", id);
+    fprintf(file, "    return code;\n");
+    fprintf(file, "}\n\n");
+}
+
+void emit_native(FILE *file, VSCodeObject *program) {
+    code_id_map ids;
+    std::vector<VSCodeObject *> order;
+    number_code(program, ids, order);
+
+    fprintf(file, "// generated by \"vs --emit-c\", link with the runtime objects.\n\n");
+    fprintf(file, "#include <math.h>\n\n");
+    fprintf(file, "#include \"objects/VSBoolObject.hpp\"\n");
+    fprintf(file, "#include \"objects/VSCharObject.hpp\"\n");
+    fprintf(file, "#include \"objects/VSFloatObject.hpp\"\n");
+    fprintf(file, "#include \"objects/VSIntObject.hpp\"\n");
+    fprintf(file, "#include \"objects/VSNoneObject.hpp\"\n");
+    fprintf(file, "#include \"printers.hpp\"\n");
+    fprintf(file, "#include \"runtime/VSOps.hpp\"\n\n");
+
+    for (auto code : order) {
+        emit_body(file, code, ids[code]);
+    }
+    for (auto code : order) {
+        emit_builder(file, code, ids[code], ids);
+    }
+
+    fprintf(file, "int main() {\n");
+    fprintf(file, "    init_printer();\n");
+    fprintf(file, "    VSCodeObject *program = vs_code_%d();\n", ids[program]);
+    fprintf(file, "    VSFrameObject *frame = new VSFrameObject(program, NULL, new VSTupleObject(program->ncellvars), NULL, NULL);\n");
+    fprintf(file, "    auto stack = std::stack<VSObject *>();\n");
+    fprintf(file, "    INTERPRETER.eval(stack, frame);\n");
+    fprintf(file, "    return 0;\n");
+    fprintf(file, "}\n");
+}
@@ -0,0 +1,734 @@
+#include "compiler/VSIR.hpp"
+
+#include <algorithm>
+
+#include "error.hpp"
+#include "objects/VSBoolObject.hpp"
+#include "objects/VSFunctionObject.hpp"
+#include "objects/VSListObject.hpp"
+#include "objects/VSStringObject.hpp"
+#include "objects/VSTupleObject.hpp"
+
+NEW_IDENTIFIER(__str__);
+
+#define IS_STACK_VAR(var) ((var) < 0)
+#define STACK_VAR(slot) (-(long)(slot)-1)
+
+static IRValue *resolve(IRValue *value) {
+    while (value->forward != NULL) {
+        value = value->forward;
+    }
+    return value;
+}
+
+IRValue::IRValue(int id, IR_KIND kind, OPCODE opcode, vs_addr_t operand, IRBlock *block)
+    : id(id), kind(kind), opcode(opcode), operand(operand), block(block) {
+    this->def = NULL;
+    this->var = 0;
+    this->forward = NULL;
+    this->lattice = LAT_TOP;
+    this->const_value = NULL;
+    this->value_type = T_OBJECT;
+    this->pinned = false;
+    this->live = false;
+    this->replacement = NULL;
+    this->spill = -1;
+}
+
+IRValue::~IRValue() {
+    DECREF_EX(this->const_value);
+}
+
+bool IRValue::is_stack_phi() {
+    return this->kind == IR_PHI && IS_STACK_VAR(this->var);
+}
+
+void IRValue::set_const(VSObject *value) {
+    INCREF(value);
+    DECREF_EX(this->const_value);
+    this->const_value = value;
+}
+
+IRBlock::IRBlock(int id, vs_addr_t start, vs_addr_t end) : id(id), start(start), end(end) {
+    this->target = NULL;
+    this->fallthrough = NULL;
+    this->depth = -1;
+    this->filled = false;
+    this->sealed = false;
+    this->executable = false;
+    this->idom = NULL;
+    this->rpo_index = -1;
+    this->new_start = 0;
+}
+
+void ir_stack_effect(VSInst &inst, int &npops, int &npushes) {
+    npops = 0;
+    npushes = 0;
+    switch (inst.opcode) {
+        case OP_POP:
+            npops = 1;
+            break;
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+        case OP_DIV:
+        case OP_MOD:
+        case OP_LT:
+        case OP_GT:
+        case OP_LE:
+        case OP_GE:
+        case OP_EQ:
+        case OP_NEQ:
+        case OP_AND:
+        case OP_XOR:
+        case OP_OR:
+        case OP_INDEX_LOAD:
+        case OP_BUILD_FUNC:
+        case OP_CALL_FUNC:
+        case OP_TAIL_CALL:
+            npops = 2;
+            npushes = 1;
+            break;
+        case OP_NOT:
+        case OP_NEG:
+        case OP_LOAD_ATTR:
+            npops = 1;
+            npushes = 1;
+            break;
+        case OP_BUILD_TUPLE:
+        case OP_BUILD_LIST:
+        case OP_BUILD_SET:
+            npops = inst.operand;
+            npushes = 1;
+            break;
+        case OP_BUILD_DICT:
+            npops = inst.operand * 2;
+            npushes = 1;
+            break;
+        case OP_INDEX_STORE:
+            npops = 3;
+            break;
+        case OP_SLICE:
+            npops = 3;
+            npushes = 1;
+            break;
+        case OP_LOAD_LOCAL:
+        case OP_LOAD_FREE:
+        case OP_LOAD_CELL:
+        case OP_LOAD_LOCAL_CELL:
+        case OP_LOAD_FREE_CELL:
+        case OP_LOAD_CONST:
+        case OP_LOAD_BUILTIN:
+            npushes = 1;
+            break;
+        case OP_STORE_LOCAL:
+        case OP_STORE_FREE:
+        case OP_STORE_CELL:
+        case OP_JIF:
+            npops = 1;
+            break;
+        case OP_STORE_ATTR:
+            npops = 2;
+            break;
+        default:
+            break;
+    }
+}
+
+IRFunction::IRFunction(VSCodeObject *code) : code(code) {
+    this->promoted = std::vector<bool>(code->nlvars, true);
+    for (auto &inst : code->code) {
+        if (inst.opcode == OP_LOAD_LOCAL_CELL && inst.operand < code->nlvars) {
+            this->promoted[inst.operand] = false;
+        }
+    }
+
+    this->valid = this->build_cfg();
+    if (!this->valid) {
+        return;
+    }
+
+    this->compute_rpo();
+
+    // ssa construction of Braun et al., a block is sealed once all its preds are filled.
+    this->seal_block(this->blocks[0]);
+    for (auto block : this->rpo) {
+        this->fill_block(block);
+        for (auto succ : block->succs) {
+            bool ready = !succ->sealed;
+            for (auto pred : succ->preds) {
+                ready = ready && pred->filled;
+            }
+            if (ready) {
+                this->seal_block(succ);
+            }
+        }
+    }
+
+    this->mark_pinned();
+}
+
+IRFunction::~IRFunction() {
+    for (auto value : this->values) {
+        delete value;
+    }
+    for (auto block : this->blocks) {
+        delete block;
+    }
+}
+
+IRValue *IRFunction::new_value(IR_KIND kind, OPCODE opcode, vs_addr_t operand, IRBlock *block) {
+    IRValue *value = new IRValue(this->values.size(), kind, opcode, operand, block);
+    this->values.push_back(value);
+    return value;
+}
+
+void IRFunction::add_use(IRValue *value, IRValue *user) {
+    value->users.push_back(user);
+}
+
+bool IRFunction::build_cfg() {
+    vs_size_t ninsts = this->code->ninsts;
+    if (ninsts == 0) {
+        return false;
+    }
+
+    std::vector<bool> leaders(ninsts + 1, false);
+    leaders[0] = true;
+    for (vs_addr_t pc = 0; pc < ninsts; pc++) {
+        VSInst &inst = this->code->code[pc];
+        if (inst.opcode == OP_JMP || inst.opcode == OP_JIF) {
+            if (inst.operand >= ninsts) {
+                return false;
+            }
+            leaders[inst.operand] = true;
+        }
+        if (inst.opcode == OP_JMP || inst.opcode == OP_JIF || inst.opcode == OP_RET) {
+            leaders[pc + 1] = true;
+        }
+    }
+
+    // an empty entry block, so that the first instruction can be a loop header.
+    this->blocks.push_back(new IRBlock(0, 0, 0));
+    std::vector<IRBlock *> block_at(ninsts, NULL);
+    for (vs_addr_t pc = 0; pc < ninsts; pc++) {
+        if (leaders[pc]) {
+            this->blocks.push_back(new IRBlock(this->blocks.size(), pc, pc));
+        }
+        this->blocks.back()->end = pc + 1;
+        block_at[pc] = this->blocks.back();
+    }
+
+    for (vs_size_t i = 0; i < this->blocks.size(); i++) {
+        IRBlock *block = this->blocks[i];
+        IRBlock *next = i + 1 < this->blocks.size() ? this->blocks[i + 1] : NULL;
+        if (block->start == block->end) {
+            block->fallthrough = next;
+        } else {
+            VSInst &last = this->code->code[block->end - 1];
+            if (last.opcode == OP_JMP || last.opcode == OP_JIF) {
+                block->target = block_at[last.operand];
+            }
+            if (last.opcode != OP_JMP && last.opcode != OP_RET) {
+                if (next == NULL) {
+                    // falls off the end of code
+                    return false;
+                }
+                block->fallthrough = next;
+            }
+        }
+
+        if (block->fallthrough != NULL) {
+            block->succs.push_back(block->fallthrough);
+        }
+        if (block->target != NULL && block->target != block->fallthrough) {
+            block->succs.push_back(block->target);
+        }
+    }
+
+    // find reachable blocks and the stack depth at their entries.
+    std::vector<IRBlock *> worklist;
+    this->blocks[0]->depth = 0;
+    worklist.push_back(this->blocks[0]);
+    while (!worklist.empty()) {
+        IRBlock *block = worklist.back();
+        worklist.pop_back();
+
+        long depth = block->depth;
+        for (vs_addr_t pc = block->start; pc < block->end; pc++) {
+            int npops, npushes;
+            ir_stack_effect(this->code->code[pc], npops, npushes);
+            if (depth < npops) {
+                return false;
+            }
+            depth += npushes - npops;
+        }
+
+        for (auto succ : block->succs) {
+            if (succ->depth == -1) {
+                succ->depth = depth;
+                worklist.push_back(succ);
+            } else if (succ->depth != depth) {
+                return false;
+            }
+        }
+    }
+
+    for (auto block : this->blocks) {
+        if (block->depth == -1) {
+            continue;
+        }
+        for (auto succ : block->succs) {
+            succ->preds.push_back(block);
+        }
+    }
+    for (auto block : this->blocks) {
+        block->pred_executable = std::vector<bool>(block->preds.size(), false);
+    }
+    return true;
+}
+
+void IRFunction::compute_rpo() {
+    std::vector<IRBlock *> postorder;
+    std::vector<std::pair<IRBlock *, vs_size_t>> stack;
+    std::vector<bool> visited(this->blocks.size(), false);
+
+    visited[0] = true;
+    stack.push_back(std::make_pair(this->blocks[0], 0));
+    while (!stack.empty()) {
+        auto &top = stack.back();
+        if (top.second < top.first->succs.size()) {
+            IRBlock *succ = top.first->succs[top.second++];
+            if (!visited[succ->id]) {
+                visited[succ->id] = true;
+                stack.push_back(std::make_pair(succ, 0));
+            }
+        } else {
+            postorder.push_back(top.first);
+            stack.pop_back();
+        }
+    }
+
+    this->rpo = std::vector<IRBlock *>(postorder.rbegin(), postorder.rend());
+    for (vs_size_t i = 0; i < this->rpo.size(); i++) {
+        this->rpo[i]->rpo_index = i;
+    }
+}
+
+void IRFunction::fill_block(IRBlock *block) {
+    std::vector<IRValue *> stack;
+    for (long slot = 0; slot < block->depth; slot++) {
+        stack.push_back(this->read_var(STACK_VAR(slot), block));
+    }
+
+    for (vs_addr_t pc = block->start; pc < block->end; pc++) {
+        VSInst &inst = this->code->code[pc];
+        int npops, npushes;
+        ir_stack_effect(inst, npops, npushes);
+        if (inst.opcode == OP_RET) {
+            // the function returns the stack top, if there is one.
+            npops = stack.size();
+        }
+
+        IRValue *value = this->new_value(IR_INST, inst.opcode, inst.operand, block);
+        for (int i = 0; i < npops; i++) {
+            IRValue *arg = resolve(stack.back());
+            stack.pop_back();
+            value->args.push_back(arg);
+            this->add_use(arg, value);
+        }
+
+        if (inst.opcode == OP_LOAD_LOCAL && this->promoted[inst.operand]) {
+            value->def = this->read_var(inst.operand, block);
+            this->add_use(value->def, value);
+        } else if (inst.opcode == OP_STORE_LOCAL && this->promoted[inst.operand]) {
+            value->var = inst.operand;
+            this->write_var(inst.operand, block, value);
+        }
+
+        if (npushes > 0) {
+            stack.push_back(value);
+        }
+        block->insts.push_back(value);
+    }
+
+    for (vs_size_t slot = 0; slot < stack.size(); slot++) {
+        this->write_var(STACK_VAR(slot), block, resolve(stack[slot]));
+    }
+    block->filled = true;
+}
+
+void IRFunction::seal_block(IRBlock *block) {
+    for (auto phi : block->incomplete_phis) {
+        this->add_phi_operands(phi);
+    }
+    block->incomplete_phis.clear();
+    block->sealed = true;
+}
+
+void IRFunction::write_var(long var, IRBlock *block, IRValue *value) {
+    block->defs[var] = value;
+}
+
+IRValue *IRFunction::read_var(long var, IRBlock *block) {
+    auto iter = block->defs.find(var);
+    if (iter != block->defs.end()) {
+        return resolve(iter->second);
+    }
+    return this->read_var_recursive(var, block);
+}
+
+IRValue *IRFunction::read_var_recursive(long var, IRBlock *block) {
+    IRValue *value;
+    if (!block->sealed) {
+        value = this->new_value(IR_PHI, OP_NOP, 0, block);
+        value->var = var;
+        block->phis.push_back(value);
+        block->incomplete_phis.push_back(value);
+    } else if (block->preds.empty()) {
+        value = this->get_init(var);
+    } else if (block->preds.size() == 1) {
+        value = this->read_var(var, block->preds[0]);
+    } else {
+        value = this->new_value(IR_PHI, OP_NOP, 0, block);
+        value->var = var;
+        block->phis.push_back(value);
+        // break cycles through loops
+        this->write_var(var, block, value);
+        value = this->add_phi_operands(value);
+    }
+    this->write_var(var, block, value);
+    return value;
+}
+
+IRValue *IRFunction::add_phi_operands(IRValue *phi) {
+    for (auto pred : phi->block->preds) {
+        IRValue *arg = this->read_var(phi->var, pred);
+        phi->args.push_back(arg);
+        this->add_use(arg, phi);
+    }
+    return this->try_remove_trivial_phi(phi);
+}
+
+IRValue *IRFunction::try_remove_trivial_phi(IRValue *phi) {
+    IRValue *same = NULL;
+    for (auto arg : phi->args) {
+        if (arg == same || arg == phi) {
+            continue;
+        }
+        if (same != NULL) {
+            // merges at least two values
+            return phi;
+        }
+        same = arg;
+    }
+    if (same == NULL) {
+        if (IS_STACK_VAR(phi->var)) {
+            return phi;
+        }
+        same = this->get_init(phi->var);
+    }
+
+    for (auto arg : phi->args) {
+        auto &users = arg->users;
+        users.erase(std::remove(users.begin(), users.end(), phi), users.end());
+    }
+
+    std::vector<IRValue *> users;
+    for (auto user : phi->users) {
+        if (user != phi && std::find(users.begin(), users.end(), user) == users.end()) {
+            users.push_back(user);
+        }
+    }
+    for (auto user : users) {
+        for (auto &arg : user->args) {
+            if (arg == phi) {
+                arg = same;
+                this->add_use(same, user);
+            }
+        }
+        if (user->def == phi) {
+            user->def = same;
+            this->add_use(same, user);
+        }
+    }
+
+    auto &phis = phi->block->phis;
+    phis.erase(std::remove(phis.begin(), phis.end(), phi), phis.end());
+    phi->forward = same;
+    phi->args.clear();
+    phi->users.clear();
+
+    // users might become trivial now
+    for (auto user : users) {
+        if (user->kind == IR_PHI && user->forward == NULL) {
+            this->try_remove_trivial_phi(user);
+        }
+    }
+    return resolve(same);
+}
+
+IRValue *IRFunction::get_init(long var) {
+    auto iter = this->inits.find(var);
+    if (iter != this->inits.end()) {
+        return iter->second;
+    }
+    IRValue *value = this->new_value(IR_INIT, OP_NOP, 0, this->blocks[0]);
+    value->var = var;
+    this->inits[var] = value;
+    return value;
+}
+
+void IRFunction::mark_pinned() {
+    // values living on the stack across blocks are left where they are.
+    for (auto block : this->rpo) {
+        for (auto phi : block->phis) {
+            if (phi->is_stack_phi()) {
+                phi->pinned = true;
+                for (auto arg : phi->args) {
+                    arg->pinned = true;
+                }
+            }
+        }
+        for (auto value : block->insts) {
+            for (auto arg : value->args) {
+                if (arg->block != block) {
+                    arg->pinned = true;
+                }
+            }
+        }
+    }
+}
+
+vs_addr_t IRFunction::get_const_index(VSObject *value) {
+    for (vs_size_t i = 0; i < this->code->nconsts; i++) {
+        if (ir_same_const(LIST_GET(this->code->consts, i), value)) {
+            return i;
+        }
+    }
+    this->code->add_const(value);
+    return this->code->nconsts - 1;
+}
+
+static bool is_folded(IRValue *value) {
+    return value->kind == IR_INST && value->lattice == LAT_CONST && !value->pinned &&
+           value->opcode != OP_LOAD_CONST && value->opcode != OP_STORE_LOCAL && ir_is_pure(value);
+}
+
+static bool is_resolved_branch(IRValue *value) {
+    return value->opcode == OP_JIF && value->args[0]->lattice == LAT_CONST;
+}
+
+void IRFunction::emit() {
+    if (!this->valid) {
+        return;
+    }
+
+    std::vector<VSInst> code;
+    std::vector<std::pair<vs_addr_t, IRBlock *>> jumps;
+
+    // unreachable blocks are not emitted, jumps to the block laid out next are dropped.
+    std::vector<IRBlock *> layout;
+    for (auto block : this->blocks) {
+        if (block->executable) {
+            layout.push_back(block);
+        }
+    }
+
+    for (vs_size_t i = 0; i < layout.size(); i++) {
+        IRBlock *block = layout[i];
+        IRBlock *next = i + 1 < layout.size() ? layout[i + 1] : NULL;
+        block->new_start = code.size();
+
+        for (auto value : block->insts) {
+            bool replaced = !value->live || is_folded(value) || value->replacement != NULL ||
+                            is_resolved_branch(value);
+            if (replaced) {
+                // drop the operands left on the stack by the kept producers.
+                for (auto arg : value->args) {
+                    if (arg->live) {
+                        code.push_back(VSInst(OP_POP));
+                    }
+                }
+            }
+
+            if (!value->live) {
+                continue;
+            } else if (is_folded(value)) {
+                code.push_back(VSInst(OP_LOAD_CONST, this->get_const_index(value->const_value)));
+            } else if (value->replacement != NULL) {
+                code.push_back(VSInst(OP_LOAD_LOCAL, value->replacement->spill));
+            } else if (is_resolved_branch(value)) {
+                if (BOOL_TO_C_BOOL(value->args[0]->const_value) && block->target != next) {
+                    jumps.push_back(std::make_pair(code.size(), block->target));
+                    code.push_back(VSInst(OP_JMP, 0));
+                }
+            } else if (value->opcode == OP_JMP && block->target == next) {
+                continue;
+            } else if (value->opcode == OP_JMP || value->opcode == OP_JIF) {
+                jumps.push_back(std::make_pair(code.size(), block->target));
+                code.push_back(VSInst(value->opcode, 0));
+            } else {
+                code.push_back(VSInst(value->opcode, value->operand));
+            }
+
+            if (value->spill >= 0) {
+                code.push_back(VSInst(OP_STORE_LOCAL, value->spill));
+                code.push_back(VSInst(OP_LOAD_LOCAL, value->spill));
+            }
+        }
+    }
+
+    for (auto &jump : jumps) {
+        code[jump.first].operand = jump.second->new_start;
+    }
+
+    this->code->code.swap(code);
+    this->code->ninsts = this->code->code.size();
+}
+
+static void fprint_value_ref(FILE *file, IRValue *value) {
+    if (value == NULL) {
+        fprintf(file, "?");
+    } else if (value->kind == IR_INIT) {
+        fprintf(file, "%%init%ld", value->var);
+    } else {
+        fprintf(file, "%%%d", value->id);
+    }
+}
+
+static std::string object_str(VSObject *object) {
+    VSObject *strobj = CALL_ATTR(object, ID___str__, EMPTY_TUPLE());
+    std::string res = STRING_TO_C_STRING(strobj);
+    DECREF(strobj);
+    return res;
+}
+
+void IRFunction::dump(FILE *file) {
+    fprintf(file, "%s:\n", STRING_TO_C_STRING(this->code->name).c_str());
+    if (!this->valid) {
+        fprintf(file, "    (not optimized)\n\n");
+        return;
+    }
+
+    for (auto block : this->rpo) {
+        fprintf(file, "bb%d [%llu, %llu)%s preds:", block->id, block->start, block->end,
+                block->executable ? "" : " unreachable");
+        for (auto pred : block->preds) {
+            fprintf(file, " bb%d", pred->id);
+        }
+        fprintf(file, " succs:");
+        for (auto succ : block->succs) {
+            fprintf(file, " bb%d", succ->id);
+        }
+        fprintf(file, "\n");
+
+        std::vector<IRValue *> values = block->phis;
+        values.insert(values.end(), block->insts.begin(), block->insts.end());
+        for (auto value : values) {
+            int npops, npushes;
+            VSInst inst(value->opcode, value->operand);
+            ir_stack_effect(inst, npops, npushes);
+
+            fprintf(file, "    ");
+            if (value->kind == IR_PHI || npushes > 0 || value->opcode == OP_STORE_LOCAL) {
+                fprint_value_ref(file, value);
+                fprintf(file, " = ");
+            }
+
+            if (value->kind == IR_PHI) {
+                if (value->is_stack_phi()) {
+                    fprintf(file, "phi stack%ld", -value->var - 1);
+                } else {
+                    fprintf(file, "phi %s", STRING_TO_C_STRING(LIST_GET(this->code->lvars, value->var)).c_str());
+                }
+                for (vs_size_t i = 0; i < value->args.size(); i++) {
+                    fprintf(file, "%s bb%d: ", i == 0 ? " [" : ",", block->preds[i]->id);
+                    fprint_value_ref(file, value->args[i]);
+                }
+                fprintf(file, "]");
+            } else {
+                fprintf(file, "%s", OPCODE_STR[value->opcode]);
+                switch (value->opcode) {
+                    case OP_LOAD_LOCAL:
+                    case OP_STORE_LOCAL:
+                    case OP_LOAD_LOCAL_CELL:
+                        fprintf(file, " %s", STRING_TO_C_STRING(LIST_GET(this->code->lvars, value->operand)).c_str());
+                        break;
+                    case OP_LOAD_CONST: {
+                        VSObject *object = LIST_GET(this->code->consts, value->operand);
+                        if (object->type == T_CODE) {
+                            fprintf(file, " <code %s>", STRING_TO_C_STRING(AS_CODE(object)->name).c_str());
+                        } else {
+                            fprintf(file, " %s", object_str(object).c_str());
+                        }
+                        break;
+                    }
+                    case OP_JMP:
+                    case OP_JIF:
+                        fprintf(file, " bb%d", block->target->id);
+                        break;
+                    case OP_POP:
+                    case OP_ADD:
+                    case OP_SUB:
+                    case OP_MUL:
+                    case OP_DIV:
+                    case OP_MOD:
+                    case OP_LT:
+                    case OP_GT:
+                    case OP_LE:
+                    case OP_GE:
+                    case OP_EQ:
+                    case OP_NEQ:
+                    case OP_AND:
+                    case OP_XOR:
+                    case OP_OR:
+                    case OP_NOT:
+                    case OP_NEG:
+                    case OP_INDEX_LOAD:
+                    case OP_INDEX_STORE:
+                    case OP_SLICE:
+                    case OP_BUILD_FUNC:
+                    case OP_CALL_FUNC:
+                    case OP_TAIL_CALL:
+                    case OP_RET:
+                        break;
+                    default:
+                        fprintf(file, " %llu", value->operand);
+                        break;
+                }
+                for (vs_size_t i = 0; i < value->args.size(); i++) {
+                    fprintf(file, i == 0 ? " " : ", ");
+                    fprint_value_ref(file, value->args[i]);
+                }
+                if (value->def != NULL) {
+                    fprintf(file, " (");
+                    fprint_value_ref(file, value->def);
+                    fprintf(file, ")");
+                }
+            }
+
+            // analysis results
+            std::vector<std::string> notes;
+            if (value->lattice == LAT_CONST && value->const_value != NULL) {
+                notes.push_back("const " + object_str(value->const_value));
+            } else if (value->lattice == LAT_TYPE) {
+                notes.push_back(std::string("type ") + TYPE_STR[value->value_type]);
+            }
+            if (value->pinned) {
+                notes.push_back("pinned");
+            }
+            if (value->replacement != NULL) {
+                notes.push_back("same as %" + std::to_string(value->replacement->id));
+            }
+            if (!value->live) {
+                notes.push_back("dead");
+            }
+            for (vs_size_t i = 0; i < notes.size(); i++) {
+                fprintf(file, "%s%s", i == 0 ? "\t; " : ", ", notes[i].c_str());
+            }
+            fprintf(file, "\n");
+        }
+    }
+    fprintf(file, "\n");
+}
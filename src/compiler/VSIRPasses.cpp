@@ -0,0 +1,536 @@
+#include "compiler/VSIR.hpp"
+
+#include <math.h>
+
+#include <unordered_set>
+
+#include "compiler/VSAnalysis.hpp"
+#include "objects/VSBoolObject.hpp"
+#include "objects/VSFloatObject.hpp"
+#include "objects/VSIntObject.hpp"
+#include "objects/VSListObject.hpp"
+#include "objects/VSNoneObject.hpp"
+#include "objects/VSStringObject.hpp"
+
+#define IS_B_OP(op) ((op) >= OP_ADD && (op) <= OP_OR)
+#define IS_U_OP(op) ((op) == OP_NOT || (op) == OP_NEG)
+
+// type of the value, T_OBJECT if it is not known.
+#define KNOWN_TYPE(value) \
+    ((value)->lattice == LAT_CONST || (value)->lattice == LAT_TYPE ? (value)->value_type : T_OBJECT)
+
+// result type of operators of native types that never fail, T_OBJECT for the others.
+static TYPE native_result_type(OPCODE op, TYPE l_type, TYPE r_type) {
+    if (l_type != r_type) {
+        return T_OBJECT;
+    }
+
+    switch (op) {
+        case OP_ADD:
+        case OP_SUB:
+        case OP_MUL:
+            return l_type == T_INT || l_type == T_FLOAT ? l_type : T_OBJECT;
+        case OP_LT:
+        case OP_GT:
+        case OP_LE:
+        case OP_GE:
+        case OP_EQ:
+        case OP_NEQ:
+            return l_type == T_INT || l_type == T_FLOAT || l_type == T_BOOL ? T_BOOL : T_OBJECT;
+        case OP_AND:
+        case OP_XOR:
+        case OP_OR:
+            return l_type == T_BOOL ? T_BOOL : T_OBJECT;
+        case OP_NEG:
+            return l_type == T_INT || l_type == T_FLOAT ? l_type : T_OBJECT;
+        case OP_NOT:
+            return l_type == T_BOOL ? T_BOOL : T_OBJECT;
+        default:
+            return T_OBJECT;
+    }
+}
+
+bool ir_same_const(VSObject *a, VSObject *b) {
+    if (a->type != b->type) {
+        return false;
+    }
+
+    switch (a->type) {
+        case T_NONE:
+            return true;
+        case T_BOOL:
+            return BOOL_TO_C_BOOL(a) == BOOL_TO_C_BOOL(b);
+        case T_INT:
+            return INT_TO_C_INT(a) == INT_TO_C_INT(b);
+        case T_FLOAT:
+            return FLOAT_TO_C_FLOAT(a) == FLOAT_TO_C_FLOAT(b) &&
+                   signbit(FLOAT_TO_C_FLOAT(a)) == signbit(FLOAT_TO_C_FLOAT(b));
+        default:
+            return a == b;
+    }
+}
+
+bool ir_is_pure(IRValue *value) {
+    if (value->kind != IR_INST) {
+        return true;
+    }
+
+    switch (value->opcode) {
+        case OP_POP:
+        case OP_LOAD_LOCAL:
+        case OP_LOAD_FREE:
+        case OP_LOAD_CELL:
+        case OP_LOAD_LOCAL_CELL:
+        case OP_LOAD_FREE_CELL:
+        case OP_LOAD_CONST:
+        case OP_LOAD_BUILTIN:
+        case OP_BUILD_TUPLE:
+        case OP_BUILD_LIST:
+        case OP_BUILD_FUNC:
+            return true;
+        case OP_NOT:
+        case OP_NEG:
+            return value->lattice == LAT_CONST ||
+                   native_result_type(value->opcode, KNOWN_TYPE(value->args[0]), KNOWN_TYPE(value->args[0])) != T_OBJECT;
+        default:
+            if (IS_B_OP(value->opcode)) {
+                return value->lattice == LAT_CONST ||
+                       native_result_type(value->opcode, KNOWN_TYPE(value->args[0]), KNOWN_TYPE(value->args[1])) != T_OBJECT;
+            }
+            return false;
+    }
+}
+
+// lattice cell of a value, the constant is borrowed.
+struct LatticeCell {
+    IR_LATTICE state;
+    VSObject *value;
+    TYPE type;
+};
+
+static LatticeCell cell_of(IRValue *value) {
+    return LatticeCell{value->lattice, value->const_value, value->value_type};
+}
+
+static LatticeCell meet(LatticeCell a, LatticeCell b) {
+    if (a.state == LAT_TOP) {
+        return b;
+    }
+    if (b.state == LAT_TOP) {
+        return a;
+    }
+    if (a.state == LAT_BOTTOM || b.state == LAT_BOTTOM || a.type != b.type) {
+        return LatticeCell{LAT_BOTTOM, NULL, T_OBJECT};
+    }
+    if (a.state == LAT_CONST && b.state == LAT_CONST && ir_same_const(a.value, b.value)) {
+        return a;
+    }
+    return LatticeCell{LAT_TYPE, NULL, a.type};
+}
+
+// evaluate the value with the current lattice of its operands, the constant of
+// the result is a new reference.
+static LatticeCell evaluate(IRValue *value, VSCodeObject *code) {
+    LatticeCell bottom = LatticeCell{LAT_BOTTOM, NULL, T_OBJECT};
+
+    switch (value->kind) {
+        case IR_INIT:
+            if (value->var < (long)code->nargs) {
+                return bottom;
+            }
+            // locals other than args start as none.
+            return LatticeCell{LAT_CONST, NEW_REF(VSObject *, VS_NONE), T_NONE};
+        case IR_PHI: {
+            LatticeCell res = LatticeCell{LAT_TOP, NULL, T_OBJECT};
+            for (vs_size_t i = 0; i < value->args.size(); i++) {
+                if (value->block->pred_executable[i]) {
+                    res = meet(res, cell_of(value->args[i]));
+                }
+            }
+            INCREF(res.value);
+            return res;
+        }
+        default:
+            break;
+    }
+
+    switch (value->opcode) {
+        case OP_LOAD_CONST: {
+            VSObject *object = LIST_GET(code->consts, value->operand);
+            if (IS_FOLDABLE(object) || IS_TYPE(object, T_NONE)) {
+                return LatticeCell{LAT_CONST, NEW_REF(VSObject *, object), object->type};
+            }
+            return LatticeCell{LAT_TYPE, NULL, object->type};
+        }
+        case OP_LOAD_LOCAL:
+        case OP_STORE_LOCAL: {
+            IRValue *src = value->opcode == OP_LOAD_LOCAL ? value->def : value->args[0];
+            if (src == NULL) {
+                return bottom;
+            }
+            LatticeCell res = cell_of(src);
+            INCREF(res.value);
+            return res;
+        }
+        case OP_BUILD_TUPLE:
+            return LatticeCell{LAT_TYPE, NULL, T_TUPLE};
+        case OP_BUILD_LIST:
+            return LatticeCell{LAT_TYPE, NULL, T_LIST};
+        case OP_BUILD_DICT:
+            return LatticeCell{LAT_TYPE, NULL, T_DICT};
+        case OP_BUILD_SET:
+            return LatticeCell{LAT_TYPE, NULL, T_SET};
+        case OP_BUILD_FUNC:
+            return LatticeCell{LAT_TYPE, NULL, T_FUNC};
+        default:
+            break;
+    }
+
+    if (IS_B_OP(value->opcode) || IS_U_OP(value->opcode)) {
+        IRValue *l_val = value->args[0];
+        IRValue *r_val = IS_B_OP(value->opcode) ? value->args[1] : l_val;
+        if (l_val->lattice == LAT_TOP || r_val->lattice == LAT_TOP) {
+            return LatticeCell{LAT_TOP, NULL, T_OBJECT};
+        }
+        if (l_val->lattice == LAT_CONST && r_val->lattice == LAT_CONST) {
+            VSObject *res = IS_B_OP(value->opcode)
+                                ? fold_b_op(value->opcode, l_val->const_value, r_val->const_value)
+                                : fold_u_op(value->opcode, l_val->const_value);
+            if (res != NULL) {
+                return LatticeCell{LAT_CONST, res, res->type};
+            }
+        }
+        TYPE type = native_result_type(value->opcode, KNOWN_TYPE(l_val), KNOWN_TYPE(r_val));
+        if (type != T_OBJECT) {
+            return LatticeCell{LAT_TYPE, NULL, type};
+        }
+    }
+    return bottom;
+}
+
+bool IRFunction::visit(IRValue *value) {
+    LatticeCell cell = evaluate(value, this->code);
+    LatticeCell res = meet(cell_of(value), cell);
+
+    bool changed = res.state != value->lattice || res.type != value->value_type ||
+                   (res.state == LAT_CONST && value->const_value == NULL);
+    if (changed) {
+        value->lattice = res.state;
+        value->value_type = res.type;
+        if (res.state == LAT_CONST) {
+            value->set_const(res.value);
+        } else {
+            DECREF_EX(value->const_value);
+            value->const_value = NULL;
+        }
+    }
+    DECREF_EX(cell.value);
+    return changed;
+}
+
+void IRFunction::visit_branch(IRBlock *block, std::vector<std::pair<IRBlock *, IRBlock *>> &edges) {
+    IRValue *last = block->insts.empty() ? NULL : block->insts.back();
+    if (last != NULL && last->opcode == OP_JIF) {
+        IRValue *cond = last->args[0];
+        if (cond->lattice == LAT_TOP) {
+            return;
+        }
+        if (cond->lattice == LAT_CONST && IS_TYPE(cond->const_value, T_BOOL)) {
+            edges.push_back(std::make_pair(block, BOOL_TO_C_BOOL(cond->const_value) ? block->target : block->fallthrough));
+            return;
+        }
+    }
+    for (auto succ : block->succs) {
+        edges.push_back(std::make_pair(block, succ));
+    }
+}
+
+void IRFunction::sccp() {
+    if (!this->valid) {
+        return;
+    }
+
+    // sparse conditional constant propagation of Wegman and Zadeck, with native
+    // types tracked below constants.
+    std::vector<std::pair<IRBlock *, IRBlock *>> edges;
+    std::vector<IRValue *> ssa_worklist;
+
+    for (auto init : this->inits) {
+        this->visit(init.second);
+    }
+    IRBlock *entry = this->blocks[0];
+    entry->executable = true;
+    this->visit_branch(entry, edges);
+
+    while (!edges.empty() || !ssa_worklist.empty()) {
+        if (!edges.empty()) {
+            auto edge = edges.back();
+            edges.pop_back();
+
+            IRBlock *block = edge.second;
+            vs_size_t idx = 0;
+            while (block->preds[idx] != edge.first) {
+                idx++;
+            }
+            if (block->pred_executable[idx]) {
+                continue;
+            }
+            block->pred_executable[idx] = true;
+
+            for (auto phi : block->phis) {
+                if (this->visit(phi)) {
+                    ssa_worklist.push_back(phi);
+                }
+            }
+            if (!block->executable) {
+                block->executable = true;
+                for (auto value : block->insts) {
+                    if (this->visit(value)) {
+                        ssa_worklist.push_back(value);
+                    }
+                }
+                this->visit_branch(block, edges);
+            }
+            continue;
+        }
+
+        IRValue *value = ssa_worklist.back();
+        ssa_worklist.pop_back();
+        for (auto user : value->users) {
+            if (!user->block->executable) {
+                continue;
+            }
+            if (this->visit(user)) {
+                ssa_worklist.push_back(user);
+            }
+            if (user->opcode == OP_JIF && user->kind == IR_INST) {
+                this->visit_branch(user->block, edges);
+            }
+        }
+    }
+}
+
+void IRFunction::compute_dominators() {
+    // iterative algorithm of Cooper, Harvey and Kennedy over executable blocks.
+    std::vector<IRBlock *> order;
+    for (auto block : this->rpo) {
+        if (block->executable) {
+            block->rpo_index = order.size();
+            order.push_back(block);
+        }
+        block->idom = NULL;
+    }
+    order[0]->idom = order[0];
+
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        for (vs_size_t i = 1; i < order.size(); i++) {
+            IRBlock *block = order[i];
+            IRBlock *idom = NULL;
+            for (vs_size_t j = 0; j < block->preds.size(); j++) {
+                IRBlock *pred = block->preds[j];
+                if (!block->pred_executable[j] || pred->idom == NULL) {
+                    continue;
+                }
+                if (idom == NULL) {
+                    idom = pred;
+                    continue;
+                }
+                IRBlock *a = pred, *b = idom;
+                while (a != b) {
+                    while (a->rpo_index > b->rpo_index) {
+                        a = a->idom;
+                    }
+                    while (b->rpo_index > a->rpo_index) {
+                        b = b->idom;
+                    }
+                }
+                idom = a;
+            }
+            if (block->idom != idom) {
+                block->idom = idom;
+                changed = true;
+            }
+        }
+    }
+}
+
+bool IRFunction::dominates(IRValue *a, IRValue *b) {
+    if (a->block == b->block) {
+        for (auto value : a->block->insts) {
+            if (value == a) {
+                return true;
+            }
+            if (value == b) {
+                return false;
+            }
+        }
+        return false;
+    }
+
+    IRBlock *block = b->block;
+    while (block->idom != block) {
+        block = block->idom;
+        if (block == a->block) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static std::string const_key(VSObject *value) {
+    switch (value->type) {
+        case T_BOOL:
+            return "b" + std::to_string(BOOL_TO_C_BOOL(value));
+        case T_INT:
+            return "i" + std::to_string(INT_TO_C_INT(value));
+        case T_FLOAT: {
+            char buf[64];
+            snprintf(buf, sizeof(buf), "f%La", FLOAT_TO_C_FLOAT(value));
+            return buf;
+        }
+        default:
+            return "n";
+    }
+}
+
+long IRFunction::value_number(IRValue *value, std::unordered_map<IRValue *, long> &numbers) {
+    if (value->replacement != NULL) {
+        return this->value_number(value->replacement, numbers);
+    }
+    if (value->opcode == OP_LOAD_LOCAL && value->def != NULL) {
+        return this->value_number(value->def, numbers);
+    }
+    if (value->kind == IR_INST && value->opcode == OP_STORE_LOCAL && value->var == (long)value->operand) {
+        return this->value_number(value->args[0], numbers);
+    }
+
+    auto iter = numbers.find(value);
+    if (iter != numbers.end()) {
+        return iter->second;
+    }
+    long number = numbers.size();
+    numbers[value] = number;
+    return number;
+}
+
+void IRFunction::gvn() {
+    if (!this->valid) {
+        return;
+    }
+    this->compute_dominators();
+
+    // constants are numbered by their values, the others by their definitions.
+    std::unordered_map<IRValue *, long> numbers;
+    std::unordered_map<std::string, long> const_numbers;
+    std::unordered_map<std::string, std::vector<IRValue *>> exprs;
+
+    for (auto block : this->rpo) {
+        if (!block->executable) {
+            continue;
+        }
+        for (auto value : block->insts) {
+            if (value->lattice == LAT_CONST && value->const_value != NULL) {
+                std::string key = const_key(value->const_value);
+                if (const_numbers.find(key) == const_numbers.end()) {
+                    const_numbers[key] = -(long)const_numbers.size() - 1;
+                }
+                numbers[value] = const_numbers[key];
+            }
+
+            if (!(IS_B_OP(value->opcode) || IS_U_OP(value->opcode)) || value->lattice != LAT_TYPE ||
+                value->pinned || !ir_is_pure(value)) {
+                continue;
+            }
+
+            std::string key = std::to_string(value->opcode);
+            for (auto arg : value->args) {
+                key += "," + std::to_string(this->value_number(arg, numbers));
+            }
+
+            auto &candidates = exprs[key];
+            for (auto candidate : candidates) {
+                if (this->dominates(candidate, value)) {
+                    value->replacement = candidate;
+                    if (candidate->spill < 0) {
+                        candidate->spill = this->code->nlvars;
+                        this->code->add_lvar(C_STRING_TO_STRING("<%" + std::to_string(candidate->id) + ">"));
+                    }
+                    break;
+                }
+            }
+            if (value->replacement == NULL) {
+                candidates.push_back(value);
+            }
+        }
+    }
+}
+
+void IRFunction::mark_live(IRValue *value) {
+    std::vector<IRValue *> worklist;
+    worklist.push_back(value);
+    while (!worklist.empty()) {
+        IRValue *cur = worklist.back();
+        worklist.pop_back();
+        if (cur->live) {
+            continue;
+        }
+        cur->live = true;
+
+        if (cur->kind == IR_PHI) {
+            for (vs_size_t i = 0; i < cur->args.size(); i++) {
+                if (cur->block->pred_executable[i]) {
+                    worklist.push_back(cur->args[i]);
+                }
+            }
+            continue;
+        }
+        if (cur->kind != IR_INST || (cur->lattice == LAT_CONST && !cur->pinned && ir_is_pure(cur) &&
+                                     cur->opcode != OP_STORE_LOCAL)) {
+            // constants need no operands
+            continue;
+        }
+        if (cur->replacement != NULL) {
+            worklist.push_back(cur->replacement);
+            continue;
+        }
+        if (cur->opcode == OP_JIF && cur->args[0]->lattice == LAT_CONST) {
+            continue;
+        }
+        for (auto arg : cur->args) {
+            worklist.push_back(arg);
+        }
+        if (cur->def != NULL) {
+            worklist.push_back(cur->def);
+        }
+    }
+}
+
+void IRFunction::dce() {
+    if (!this->valid) {
+        return;
+    }
+
+    for (auto value : this->values) {
+        value->live = false;
+    }
+    for (auto block : this->rpo) {
+        if (!block->executable) {
+            continue;
+        }
+        for (auto phi : block->phis) {
+            if (phi->pinned) {
+                this->mark_live(phi);
+            }
+        }
+        for (auto value : block->insts) {
+            // stores of promoted locals are only kept if a live load reaches them,
+            // other locals may be read through cells.
+            bool root = value->opcode == OP_STORE_LOCAL ? !this->promoted[value->operand] : !ir_is_pure(value);
+            if (value->pinned || root) {
+                this->mark_live(value);
+            }
+        }
+    }
+}
@@ -134,6 +134,7 @@ void VSParser::read_func_def(FuncDeclNode *func) {
         err("line: %ld, missing function body\n", PEEKTOKEN()->ln);
     }
     func->set_body(func_body);
+    func->span_end = this->tokenizer->tell();
 }
 
 VSASTNode *VSParser::read_tuple_decl_or_expr() {
@@ -218,12 +219,14 @@ VSASTNode *VSParser::read_dict_or_set_decl() {
 }
 
 VSASTNode *VSParser::read_lambda_decl() {
+    size_t span_start = PEEKTOKEN()->pos;
     POPTOKEN(1, TK_LAMBDA);
     POPTOKEN(1, TK_L_PAREN);
 
     ENTER_FUNC();
 
     FuncDeclNode *func = new FuncDeclNode(NULL);
+    func->span_start = span_start;
 
     this->read_func_def(func);
 
@@ -280,13 +283,20 @@ VSASTNode *VSParser::read_postfix_expr() {
     while (token->tk_type == TK_L_BRACK || token->tk_type == TK_L_PAREN || token->tk_type == TK_DOT) {
         if (token->tk_type == TK_L_BRACK) {
             POPTOKEN(1, TK_L_BRACK);
-            VSASTNode *index = this->read_log_or_expr();
-            if (index == NULL) {
+            ENSURE_TOKEN(node);
+            VSASTNode *index = PEEKTOKEN()->tk_type == TK_COLON ? NULL : this->read_log_or_expr();
+            ENSURE_TOKEN(node);
+            if (PEEKTOKEN()->tk_type == TK_COLON) {
+                POPTOKEN(1, TK_COLON);
                 ENSURE_TOKEN(node);
+                VSASTNode *end = PEEKTOKEN()->tk_type == TK_R_BRACK ? NULL : this->read_log_or_expr();
+                node = new SliceExprNode(node, index, end);
+            } else if (index != NULL) {
+                node = new IdxExprNode(node, index);
+            } else {
                 err("line: %ld, invalid list index\n", PEEKTOKEN()->ln);
                 terminate(TERM_ERROR);
             }
-            node = new IdxExprNode(node, index);
             POPTOKEN(1, TK_R_BRACK);
         } else if (token->tk_type == TK_L_PAREN) {
             POPTOKEN(1, TK_L_PAREN);
@@ -601,6 +611,7 @@ VSASTNode *VSParser::read_for_stmt() {
 }
 
 VSASTNode *VSParser::read_func_decl() {
+    size_t span_start = PEEKTOKEN()->pos;
     POPTOKEN(1, TK_FUNC);
     VSToken *token = this->expect(1, TK_IDENTIFIER);
     if (token == NULL) {
@@ -611,6 +622,7 @@ VSASTNode *VSParser::read_func_decl() {
     ENTER_FUNC();
 
     FuncDeclNode *func = new FuncDeclNode(new IdentNode(token->literal));
+    func->span_start = span_start;
 
     this->read_func_def(func);
 
@@ -1,6 +1,14 @@
 #include "compiler/VSTokenizer.hpp"
 
 #include <errno.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#if defined(__SSE2__) && !defined(VS_NO_SIMD)
+#include <emmintrin.h>
+#define VS_LEX_SIMD
+#endif
 
 #include "error.hpp"
 #include "objects/VSBoolObject.hpp"
@@ -12,9 +20,103 @@
 
 #define ERR_WITH_POS(ln, col, msg, ...) err("line: %ld, col: %d, " msg, ln, col, __VA_ARGS__)
 
+#define IS_SPACE(c) ((c) == ' ' || (c) == '\n' || (c) == '\t' || (c) == '\r')
+
+#define IS_QUOTED_STOP(c) (IS_QUOTE(c) || (c) == '\\')
+
+// Scanners return the first char in [p, end) not in their char class. Most
+// runs are short, so the first 16 chars are checked one by one. Longer runs
+// go on 16 chars at a time with sse2, the rest is left to the scalar loop.
+#ifdef VS_LEX_SIMD
+#define SIMD_WIDTH 16
+
+// mask of chars in [lo, hi], chars above 0x7f are negative and never in range.
+static inline __m128i simd_in_range(__m128i chunk, char lo, char hi) {
+    return _mm_and_si128(_mm_cmpgt_epi8(chunk, _mm_set1_epi8(lo - 1)), _mm_cmpgt_epi8(_mm_set1_epi8(hi + 1), chunk));
+}
+
+static inline __m128i simd_eq(__m128i chunk, char c) {
+    return _mm_cmpeq_epi8(chunk, _mm_set1_epi8(c));
+}
+
+static inline __m128i simd_digit(__m128i chunk) {
+    return simd_in_range(chunk, '0', '9');
+}
+
+static inline __m128i simd_word(__m128i chunk) {
+    // case folded letters, digits and '_'
+    __m128i letter = simd_in_range(_mm_or_si128(chunk, _mm_set1_epi8(0x20)), 'a', 'z');
+    return _mm_or_si128(_mm_or_si128(letter, simd_digit(chunk)), simd_eq(chunk, '_'));
+}
+
+static inline __m128i simd_space(__m128i chunk) {
+    return _mm_or_si128(_mm_or_si128(simd_eq(chunk, ' '), simd_eq(chunk, '\n')),
+                        _mm_or_si128(simd_eq(chunk, '\t'), simd_eq(chunk, '\r')));
+}
+
+static inline __m128i simd_not_quoted_stop(__m128i chunk) {
+    __m128i stop = _mm_or_si128(_mm_or_si128(simd_eq(chunk, '\''), simd_eq(chunk, '\"')), simd_eq(chunk, '\\'));
+    return _mm_xor_si128(stop, _mm_set1_epi8(-1));
+}
+
+#define SCAN(p, end, in_class, simd_in_class)                                     \
+    do {                                                                          \
+        const char *_limit = (end) - (p) > SIMD_WIDTH ? (p) + SIMD_WIDTH : (end); \
+        while ((p) < _limit && in_class(*(p))) {                                  \
+            (p)++;                                                                \
+        }                                                                         \
+        if ((p) < _limit) {                                                       \
+            break;                                                                \
+        }                                                                         \
+        while ((p) + SIMD_WIDTH <= (end)) {                                       \
+            __m128i _chunk = _mm_loadu_si128((const __m128i *)(p));              \
+            int _mask = ~_mm_movemask_epi8(simd_in_class(_chunk)) & 0xffff;       \
+            if (_mask != 0) {                                                     \
+                (p) += __builtin_ctz(_mask);                                      \
+                break;                                                            \
+            }                                                                     \
+            (p) += SIMD_WIDTH;                                                    \
+        }                                                                         \
+        while ((p) < (end) && in_class(*(p))) {                                   \
+            (p)++;                                                                \
+        }                                                                         \
+    } while (0)
+#else
+#define SCAN(p, end, in_class, simd_in_class)     \
+    do {                                          \
+        while ((p) < (end) && in_class(*(p))) {   \
+            (p)++;                                \
+        }                                         \
+    } while (0)
+#endif
+
+#define IS_NOT_QUOTED_STOP(c) (!IS_QUOTED_STOP(c))
+
+static const char *scan_word(const char *p, const char *end) {
+    SCAN(p, end, IS_WORD_CHAR, simd_word);
+    return p;
+}
+
+static const char *scan_digits(const char *p, const char *end) {
+    SCAN(p, end, IS_NUMBER, simd_digit);
+    return p;
+}
+
+static const char *scan_space(const char *p, const char *end) {
+    SCAN(p, end, IS_SPACE, simd_space);
+    return p;
+}
+
+static const char *scan_quoted(const char *p, const char *end) {
+    SCAN(p, end, IS_NOT_QUOTED_STOP, simd_not_quoted_stop);
+    return p;
+}
+
 VSToken::VSToken(
     TOKEN_TYPE tk_type, VSObject *tk_value, VSObject *literal, long long ln, long long col) : tk_type(tk_type), tk_value(tk_value), literal(literal), ln(ln), col(col) {
     this->refcnt = 1;
+    this->pos = 0;
+    this->end = 0;
     INCREF(tk_value);
     INCREF(literal);
 }
@@ -25,7 +127,48 @@ VSToken::~VSToken() {
 }
 
 VSTokenizer::VSTokenizer(FILE *file) {
-    this->file = file;
+    this->mapped_len = 0;
+    this->start = NULL;
+
+    struct stat st;
+    if (fstat(fileno(file), &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+        void *mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+        if (mapped != MAP_FAILED) {
+            this->mapped_len = st.st_size;
+            this->start = (const char *)mapped;
+        }
+    }
+
+    // not a regular file or not mappable, read it all
+    if (this->start == NULL) {
+        char buf[BUFSIZ];
+        size_t nread;
+        while ((nread = fread(buf, 1, BUFSIZ, file)) > 0) {
+            this->source.append(buf, nread);
+        }
+        this->start = this->source.data();
+    }
+    fclose(file);
+
+    this->end = this->start + (this->mapped_len > 0 ? this->mapped_len : this->source.length());
+    this->cur = this->start;
+    this->at_end = false;
+    this->taken_end = 0;
+    this->peek = NULL;
+    this->ln = 1;
+    this->col = 1;
+    this->refcnt = 1;
+    this->gettoken();
+}
+
+VSTokenizer::VSTokenizer(std::string source) {
+    this->mapped_len = 0;
+    this->source = source;
+    this->start = this->source.data();
+    this->end = this->start + this->source.length();
+    this->cur = this->start;
+    this->at_end = false;
+    this->taken_end = 0;
     this->peek = NULL;
     this->ln = 1;
     this->col = 1;
@@ -35,45 +178,92 @@ VSTokenizer::VSTokenizer(FILE *file) {
 
 VSTokenizer::~VSTokenizer() {
     DECREF_EX(this->peek);
-    fclose(this->file);
+    if (this->mapped_len > 0) {
+        munmap((void *)this->start, this->mapped_len);
+    }
+}
+
+bool VSTokenizer::eof() {
+    return this->at_end;
 }
 
 char VSTokenizer::getchar() {
-    char c = fgetc(this->file);
+    if (this->cur >= this->end) {
+        this->at_end = true;
+        return EOF;
+    }
+
+    char c = *this->cur++;
     if (c == '\n') {
         this->ln++;
         this->col = 1;
-    } else if (!feof(this->file)) {
+    } else {
         this->col++;
     }
     return c;
 }
 
 int VSTokenizer::ungetchar() {
-    if (fseek(this->file, -1, SEEK_CUR)) {
+    if (this->cur == this->start) {
         return -1;
     }
-    if (this->peekchar() == '\n') {
+
+    this->cur--;
+    this->at_end = false;
+    if (*this->cur == '\n') {
+        // back to the end of the previous line
+        const char *line = this->cur;
+        while (line > this->start && line[-1] != '\n') {
+            line--;
+        }
         this->ln--;
-        this->col = 1;
+        this->col = this->cur - line + 1;
     } else if (col > 1) {
         this->col--;
     }
     return 0;
 }
 
+void VSTokenizer::advance(const char *stop) {
+    if (stop == this->cur) {
+        return;
+    }
+
+    // only newlines change the line, the column counts from the last one
+    const char *p = this->cur, *nl;
+    while ((nl = (const char *)memchr(p, '\n', stop - p)) != NULL) {
+        this->ln++;
+        this->col = 1;
+        p = nl + 1;
+    }
+    this->col += stop - p;
+    this->cur = stop;
+}
+
+int VSTokenizer::append_run(std::string &str, const char *stop, bool multiline) {
+    int len = stop - this->cur;
+    str.append(this->cur, len);
+    if (multiline) {
+        this->advance(stop);
+    } else {
+        this->col += len;
+        this->cur = stop;
+    }
+    return len;
+}
+
 char VSTokenizer::peekchar() {
-    char c = fgetc(this->file);
-    if (!feof(this->file)) {
-        fseek(this->file, -1, SEEK_CUR);
+    if (this->cur >= this->end) {
+        this->at_end = true;
+        return EOF;
     }
-    return c;
+    return *this->cur;
 }
 
 int VSTokenizer::seek(int steps) {
     int seeked = 0;
     if (steps > 0) {
-        while (seeked < steps && !feof(this->file)) {
+        while (seeked < steps && !this->eof()) {
             this->getchar();
             seeked++;
         }
@@ -113,16 +303,14 @@ int VSTokenizer::getnum(std::string &str) {
     char c = this->peekchar();
 
     // integer part of the number
-    while (IS_NUMBER(c)) {
-        APPEND_CHAR(str, c, i);
-    }
+    i += this->append_run(str, scan_digits(this->cur, this->end), false);
+    c = this->peekchar();
 
     // if the number has decimal part
     if (c == '.') {
         APPEND_CHAR(str, c, i);
-        while (IS_NUMBER(c)) {
-            APPEND_CHAR(str, c, i);
-        }
+        i += this->append_run(str, scan_digits(this->cur, this->end), false);
+        this->peekchar();
     }
 
     return i;
@@ -132,14 +320,14 @@ int VSTokenizer::getword(std::string &str) {
     int i = 0;
     char c = this->peekchar();
 
-    while (!IS_WORD_CHAR(c) && !feof(this->file)) {
+    while (!IS_WORD_CHAR(c) && !this->eof()) {
         this->getchar();
         c = this->peekchar();
     }
 
-    while (IS_WORD_CHAR(c)) {
-        APPEND_CHAR(str, c, i);
-    }
+    i += this->append_run(str, scan_word(this->cur, this->end), false);
+    // peek the char after the word, to notice the end of source
+    this->peekchar();
 
     return i;
 }
@@ -147,20 +335,24 @@ int VSTokenizer::getword(std::string &str) {
 int VSTokenizer::getquoted(std::string &str) {
     int i = 0;
     char c = this->peekchar();
-    if (feof(this->file) || !IS_QUOTE(c)) {
+    if (this->eof() || !IS_QUOTE(c)) {
         return i;
     }
 
     APPEND_CHAR(str, c, i);
-    while (!feof(this->file) && !IS_QUOTE(c)) {
+    while (!this->eof() && !IS_QUOTE(c)) {
         if (c == '\\') {
             this->getchar();
             c = this->escape(this->peekchar());
+            APPEND_CHAR(str, c, i);
+        } else {
+            // copy the run up to the next quote or escape at once
+            i += this->append_run(str, scan_quoted(this->cur, this->end), true);
+            c = this->peekchar();
         }
-        APPEND_CHAR(str, c, i);
     }
 
-    if (!feof(this->file)) {
+    if (!this->eof()) {
         APPEND_CHAR(str, c, i);
     }
     return i;
@@ -169,7 +361,7 @@ int VSTokenizer::getquoted(std::string &str) {
 int VSTokenizer::getstr(std::string &str, int len) {
     int i = 0;
     char c = this->peekchar();
-    while (i < len - 1 && !feof(this->file)) {
+    while (i < len - 1 && !this->eof()) {
         APPEND_CHAR(str, c, i);
     }
     return i;
@@ -322,14 +514,21 @@ VSToken *VSTokenizer::reco_kwd(std::string &literal) {
 }
 
 bool VSTokenizer::hastoken() {
-    return this->peektoken() != NULL || !feof(this->file);
+    return this->peektoken() != NULL || !this->eof();
 }
 
 VSToken *VSTokenizer::gettoken() {
     VSToken *old = this->peek;
     auto literal = std::string();
+    const char *tk_start;
+
+    if (old != NULL) {
+        this->taken_end = old->end;
+    }
 
 begain:
+    this->advance(scan_space(this->cur, this->end));
+    tk_start = this->cur;
     char tk_char = this->peekchar();
 
     if (IS_NUMBER(tk_char)) {
@@ -425,8 +624,14 @@ begain:
                     this->getchar();
                     this->peek = NEW_SYM_TOKEN(TK_DIV_ASSIGN, "/=");
                 } else if (this->peekchar() == '/') {
-                    while (!feof(this->file) && this->getchar() != '\n')
-                        ;
+                    // skip the comment to the end of line, or of source
+                    const char *nl = (const char *)memchr(this->cur, '\n', this->end - this->cur);
+                    if (nl != NULL) {
+                        this->advance(nl + 1);
+                    } else {
+                        this->advance(this->end);
+                        this->getchar();
+                    }
                     goto begain;
                 } else {
                     this->peek = NEW_SYM_TOKEN(TK_DIV, "/");
@@ -525,7 +730,7 @@ begain:
                 goto begain;
             default:
                 this->peek = NULL;
-                if (!feof(this->file)) {
+                if (!this->eof()) {
                     ERR_WITH_POS(this->ln, this->col, "illegal token: \"%c\"\n", tk_char);
                 }
                 break;
@@ -535,6 +740,10 @@ begain:
     }
 
 done:
+    if (this->peek != NULL) {
+        this->peek->pos = tk_start - this->start;
+        this->peek->end = this->cur - this->start;
+    }
     // if (this->peek == NULL) {
     //     note("peek token is null");
     // } else {
@@ -549,3 +758,11 @@ done:
 VSToken *VSTokenizer::peektoken() {
     return this->peek;
 }
+
+size_t VSTokenizer::tell() {
+    return this->taken_end;
+}
+
+std::string VSTokenizer::text(size_t from, size_t to) {
+    return std::string(this->start + from, this->start + to);
+}
@@ -0,0 +1,412 @@
+#include "objects/VSArrayKernels.hpp"
+
+#include <string.h>
+
+#include <algorithm>
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+static cint_t scalar_sum_int(const cint_t *items, vs_size_t n) {
+    return vs_kernel_sum<cint_t, cint_t>(items, n);
+}
+
+static cint_t scalar_min_int(const cint_t *items, vs_size_t n) {
+    return vs_kernel_min(items, n);
+}
+
+static cint_t scalar_max_int(const cint_t *items, vs_size_t n) {
+    return vs_kernel_max(items, n);
+}
+
+static void scalar_scale_int(cint_t *dst, const cint_t *src, vs_size_t n, cint_t k) {
+    vs_kernel_scale(dst, src, n, k);
+}
+
+static void scalar_add_int(cint_t *dst, const cint_t *a, const cint_t *b, vs_size_t n) {
+    vs_kernel_add(dst, a, b, n);
+}
+
+static void scalar_cmp_int(cbyte_t *dst, const cint_t *src, vs_size_t n, cint_t x, int cmp) {
+    vs_kernel_cmp(dst, src, n, x, cmp);
+}
+
+static void scalar_cumsum_int(cint_t *dst, const cint_t *src, vs_size_t n) {
+    vs_kernel_cumsum(dst, src, n);
+}
+
+static cint_t scalar_sum_byte(const cbyte_t *items, vs_size_t n) {
+    return vs_kernel_sum<cbyte_t, cint_t>(items, n);
+}
+
+static cbyte_t scalar_min_byte(const cbyte_t *items, vs_size_t n) {
+    return vs_kernel_min(items, n);
+}
+
+static cbyte_t scalar_max_byte(const cbyte_t *items, vs_size_t n) {
+    return vs_kernel_max(items, n);
+}
+
+static void scalar_cmp_byte(cbyte_t *dst, const cbyte_t *src, vs_size_t n, cbyte_t x, int cmp) {
+    vs_kernel_cmp(dst, src, n, x, cmp);
+}
+
+static const VSArrayKernels scalar_kernels = {
+    VS_SIMD_NONE,
+    scalar_sum_int, scalar_min_int, scalar_max_int, scalar_scale_int,
+    scalar_add_int, scalar_cmp_int, scalar_cumsum_int,
+    scalar_sum_byte, scalar_min_byte, scalar_max_byte, scalar_cmp_byte};
+
+#if defined(__x86_64__)
+
+/* begin sse2 kernels, sse2 is part of x86-64 */
+
+// low 64 bits of the products of the 64 bit lanes, from 32 bit products.
+static inline __m128i sse2_mul_epi64(__m128i a, __m128i b) {
+    __m128i lo = _mm_mul_epu32(a, b);
+    __m128i cross = _mm_add_epi64(
+        _mm_mul_epu32(_mm_srli_epi64(a, 32), b), _mm_mul_epu32(a, _mm_srli_epi64(b, 32)));
+    return _mm_add_epi64(lo, _mm_slli_epi64(cross, 32));
+}
+
+static cint_t sse2_sum_int(const cint_t *items, vs_size_t n) {
+    __m128i sum0 = _mm_setzero_si128(), sum1 = _mm_setzero_si128();
+    vs_size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        sum0 = _mm_add_epi64(sum0, _mm_loadu_si128((const __m128i *)(items + i)));
+        sum1 = _mm_add_epi64(sum1, _mm_loadu_si128((const __m128i *)(items + i + 2)));
+    }
+
+    cint_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, _mm_add_epi64(sum0, sum1));
+    return lanes[0] + lanes[1] + scalar_sum_int(items + i, n - i);
+}
+
+static void sse2_scale_int(cint_t *dst, const cint_t *src, vs_size_t n, cint_t k) {
+    __m128i factor = _mm_set1_epi64x(k);
+    vs_size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i items = _mm_loadu_si128((const __m128i *)(src + i));
+        _mm_storeu_si128((__m128i *)(dst + i), sse2_mul_epi64(items, factor));
+    }
+    scalar_scale_int(dst + i, src + i, n - i, k);
+}
+
+static void sse2_add_int(cint_t *dst, const cint_t *a, const cint_t *b, vs_size_t n) {
+    vs_size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i sum = _mm_add_epi64(
+            _mm_loadu_si128((const __m128i *)(a + i)), _mm_loadu_si128((const __m128i *)(b + i)));
+        _mm_storeu_si128((__m128i *)(dst + i), sum);
+    }
+    scalar_add_int(dst + i, a + i, b + i, n - i);
+}
+
+static void sse2_cumsum_int(cint_t *dst, const cint_t *src, vs_size_t n) {
+    __m128i carry = _mm_setzero_si128();
+    vs_size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i items = _mm_loadu_si128((const __m128i *)(src + i));
+        // [a, b] to [a, a + b], then the sum of the items before
+        items = _mm_add_epi64(items, _mm_slli_si128(items, 8));
+        items = _mm_add_epi64(items, carry);
+        _mm_storeu_si128((__m128i *)(dst + i), items);
+        carry = _mm_shuffle_epi32(items, _MM_SHUFFLE(3, 2, 3, 2));
+    }
+
+    cint_t sum = i > 0 ? dst[i - 1] : 0;
+    for (; i < n; i++) {
+        sum += src[i];
+        dst[i] = sum;
+    }
+}
+
+static cint_t sse2_sum_byte(const cbyte_t *items, vs_size_t n) {
+    __m128i zero = _mm_setzero_si128(), sum = _mm_setzero_si128();
+    vs_size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        // sums of 8 bytes each into the 64 bit lanes
+        sum = _mm_add_epi64(sum, _mm_sad_epu8(_mm_loadu_si128((const __m128i *)(items + i)), zero));
+    }
+
+    cint_t lanes[2];
+    _mm_storeu_si128((__m128i *)lanes, sum);
+    return lanes[0] + lanes[1] + scalar_sum_byte(items + i, n - i);
+}
+
+static cbyte_t sse2_min_byte(const cbyte_t *items, vs_size_t n) {
+    if (n < 16) {
+        return scalar_min_byte(items, n);
+    }
+
+    __m128i res = _mm_loadu_si128((const __m128i *)items);
+    vs_size_t i = 16;
+    for (; i + 16 <= n; i += 16) {
+        res = _mm_min_epu8(res, _mm_loadu_si128((const __m128i *)(items + i)));
+    }
+
+    cbyte_t lanes[16];
+    _mm_storeu_si128((__m128i *)lanes, res);
+    cbyte_t min = scalar_min_byte(lanes, 16);
+    return i < n ? std::min(min, scalar_min_byte(items + i, n - i)) : min;
+}
+
+static cbyte_t sse2_max_byte(const cbyte_t *items, vs_size_t n) {
+    if (n < 16) {
+        return scalar_max_byte(items, n);
+    }
+
+    __m128i res = _mm_loadu_si128((const __m128i *)items);
+    vs_size_t i = 16;
+    for (; i + 16 <= n; i += 16) {
+        res = _mm_max_epu8(res, _mm_loadu_si128((const __m128i *)(items + i)));
+    }
+
+    cbyte_t lanes[16];
+    _mm_storeu_si128((__m128i *)lanes, res);
+    cbyte_t max = scalar_max_byte(lanes, 16);
+    return i < n ? std::max(max, scalar_max_byte(items + i, n - i)) : max;
+}
+
+static void sse2_cmp_byte(cbyte_t *dst, const cbyte_t *src, vs_size_t n, cbyte_t x, int cmp) {
+    // bytes are compared signed, so flip their sign bits for unsigned order
+    __m128i sign = _mm_set1_epi8((char)0x80), one = _mm_set1_epi8(1);
+    __m128i scalar = _mm_xor_si128(_mm_set1_epi8((char)x), sign);
+    vs_size_t i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i items = _mm_xor_si128(_mm_loadu_si128((const __m128i *)(src + i)), sign);
+        __m128i mask = cmp == VS_CMP_LT   ? _mm_cmplt_epi8(items, scalar)
+                       : cmp == VS_CMP_GT ? _mm_cmpgt_epi8(items, scalar)
+                                          : _mm_cmpeq_epi8(items, scalar);
+        _mm_storeu_si128((__m128i *)(dst + i), _mm_and_si128(mask, one));
+    }
+    scalar_cmp_byte(dst + i, src + i, n - i, x, cmp);
+}
+
+/* end sse2 kernels */
+
+/* begin avx2 kernels */
+
+#define AVX2 __attribute__((target("avx2")))
+
+AVX2 static inline __m256i avx2_mul_epi64(__m256i a, __m256i b) {
+    __m256i lo = _mm256_mul_epu32(a, b);
+    __m256i cross = _mm256_add_epi64(
+        _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b), _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+
+AVX2 static cint_t avx2_sum_int(const cint_t *items, vs_size_t n) {
+    __m256i sum0 = _mm256_setzero_si256(), sum1 = _mm256_setzero_si256();
+    vs_size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        sum0 = _mm256_add_epi64(sum0, _mm256_loadu_si256((const __m256i *)(items + i)));
+        sum1 = _mm256_add_epi64(sum1, _mm256_loadu_si256((const __m256i *)(items + i + 4)));
+    }
+
+    cint_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, _mm256_add_epi64(sum0, sum1));
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + scalar_sum_int(items + i, n - i);
+}
+
+AVX2 static cint_t avx2_min_int(const cint_t *items, vs_size_t n) {
+    if (n < 4) {
+        return scalar_min_int(items, n);
+    }
+
+    __m256i res = _mm256_loadu_si256((const __m256i *)items);
+    vs_size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256i next = _mm256_loadu_si256((const __m256i *)(items + i));
+        res = _mm256_blendv_epi8(res, next, _mm256_cmpgt_epi64(res, next));
+    }
+
+    cint_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, res);
+    cint_t min = scalar_min_int(lanes, 4);
+    return i < n ? std::min(min, scalar_min_int(items + i, n - i)) : min;
+}
+
+AVX2 static cint_t avx2_max_int(const cint_t *items, vs_size_t n) {
+    if (n < 4) {
+        return scalar_max_int(items, n);
+    }
+
+    __m256i res = _mm256_loadu_si256((const __m256i *)items);
+    vs_size_t i = 4;
+    for (; i + 4 <= n; i += 4) {
+        __m256i next = _mm256_loadu_si256((const __m256i *)(items + i));
+        res = _mm256_blendv_epi8(res, next, _mm256_cmpgt_epi64(next, res));
+    }
+
+    cint_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, res);
+    cint_t max = scalar_max_int(lanes, 4);
+    return i < n ? std::max(max, scalar_max_int(items + i, n - i)) : max;
+}
+
+AVX2 static void avx2_scale_int(cint_t *dst, const cint_t *src, vs_size_t n, cint_t k) {
+    __m256i factor = _mm256_set1_epi64x(k);
+    vs_size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i items = _mm256_loadu_si256((const __m256i *)(src + i));
+        _mm256_storeu_si256((__m256i *)(dst + i), avx2_mul_epi64(items, factor));
+    }
+    scalar_scale_int(dst + i, src + i, n - i, k);
+}
+
+AVX2 static void avx2_add_int(cint_t *dst, const cint_t *a, const cint_t *b, vs_size_t n) {
+    vs_size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i sum = _mm256_add_epi64(
+            _mm256_loadu_si256((const __m256i *)(a + i)), _mm256_loadu_si256((const __m256i *)(b + i)));
+        _mm256_storeu_si256((__m256i *)(dst + i), sum);
+    }
+    scalar_add_int(dst + i, a + i, b + i, n - i);
+}
+
+// bytes of 4 bit masks, the bytes of the low bits first.
+static const uint32_t mask_bytes[16] = {
+    0x00000000, 0x00000001, 0x00000100, 0x00000101, 0x00010000, 0x00010001, 0x00010100, 0x00010101,
+    0x01000000, 0x01000001, 0x01000100, 0x01000101, 0x01010000, 0x01010001, 0x01010100, 0x01010101};
+
+AVX2 static void avx2_cmp_int(cbyte_t *dst, const cint_t *src, vs_size_t n, cint_t x, int cmp) {
+    __m256i scalar = _mm256_set1_epi64x(x);
+    vs_size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i items = _mm256_loadu_si256((const __m256i *)(src + i));
+        __m256i mask = cmp == VS_CMP_LT   ? _mm256_cmpgt_epi64(scalar, items)
+                       : cmp == VS_CMP_GT ? _mm256_cmpgt_epi64(items, scalar)
+                                          : _mm256_cmpeq_epi64(items, scalar);
+        // a bit per lane, spread to a byte per item
+        int bits = _mm256_movemask_pd(_mm256_castsi256_pd(mask));
+        memcpy(dst + i, &mask_bytes[bits], 4);
+    }
+    scalar_cmp_int(dst + i, src + i, n - i, x, cmp);
+}
+
+AVX2 static void avx2_cumsum_int(cint_t *dst, const cint_t *src, vs_size_t n) {
+    __m256i zero = _mm256_setzero_si256(), carry = zero;
+    vs_size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i items = _mm256_loadu_si256((const __m256i *)(src + i));
+        // [a, b, c, d] to [a, a + b, b + c, c + d], then add the first half
+        // to the second for [a, a + b, a + b + c, a + b + c + d]
+        __m256i shifted = _mm256_permute4x64_epi64(items, _MM_SHUFFLE(2, 1, 0, 0));
+        items = _mm256_add_epi64(items, _mm256_blend_epi32(shifted, zero, 0x03));
+        items = _mm256_add_epi64(items, _mm256_permute2x128_si256(items, items, 0x08));
+        items = _mm256_add_epi64(items, carry);
+        _mm256_storeu_si256((__m256i *)(dst + i), items);
+        carry = _mm256_permute4x64_epi64(items, _MM_SHUFFLE(3, 3, 3, 3));
+    }
+
+    cint_t sum = i > 0 ? dst[i - 1] : 0;
+    for (; i < n; i++) {
+        sum += src[i];
+        dst[i] = sum;
+    }
+}
+
+AVX2 static cint_t avx2_sum_byte(const cbyte_t *items, vs_size_t n) {
+    __m256i zero = _mm256_setzero_si256(), sum = _mm256_setzero_si256();
+    vs_size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        sum = _mm256_add_epi64(sum, _mm256_sad_epu8(_mm256_loadu_si256((const __m256i *)(items + i)), zero));
+    }
+
+    cint_t lanes[4];
+    _mm256_storeu_si256((__m256i *)lanes, sum);
+    return lanes[0] + lanes[1] + lanes[2] + lanes[3] + sse2_sum_byte(items + i, n - i);
+}
+
+AVX2 static cbyte_t avx2_min_byte(const cbyte_t *items, vs_size_t n) {
+    if (n < 32) {
+        return sse2_min_byte(items, n);
+    }
+
+    __m256i res = _mm256_loadu_si256((const __m256i *)items);
+    vs_size_t i = 32;
+    for (; i + 32 <= n; i += 32) {
+        res = _mm256_min_epu8(res, _mm256_loadu_si256((const __m256i *)(items + i)));
+    }
+
+    cbyte_t lanes[32];
+    _mm256_storeu_si256((__m256i *)lanes, res);
+    cbyte_t min = sse2_min_byte(lanes, 32);
+    return i < n ? std::min(min, sse2_min_byte(items + i, n - i)) : min;
+}
+
+AVX2 static cbyte_t avx2_max_byte(const cbyte_t *items, vs_size_t n) {
+    if (n < 32) {
+        return sse2_max_byte(items, n);
+    }
+
+    __m256i res = _mm256_loadu_si256((const __m256i *)items);
+    vs_size_t i = 32;
+    for (; i + 32 <= n; i += 32) {
+        res = _mm256_max_epu8(res, _mm256_loadu_si256((const __m256i *)(items + i)));
+    }
+
+    cbyte_t lanes[32];
+    _mm256_storeu_si256((__m256i *)lanes, res);
+    cbyte_t max = sse2_max_byte(lanes, 32);
+    return i < n ? std::max(max, sse2_max_byte(items + i, n - i)) : max;
+}
+
+AVX2 static void avx2_cmp_byte(cbyte_t *dst, const cbyte_t *src, vs_size_t n, cbyte_t x, int cmp) {
+    __m256i sign = _mm256_set1_epi8((char)0x80), one = _mm256_set1_epi8(1);
+    __m256i scalar = _mm256_xor_si256(_mm256_set1_epi8((char)x), sign);
+    vs_size_t i = 0;
+    for (; i + 32 <= n; i += 32) {
+        __m256i items = _mm256_xor_si256(_mm256_loadu_si256((const __m256i *)(src + i)), sign);
+        __m256i mask = cmp == VS_CMP_LT   ? _mm256_cmpgt_epi8(scalar, items)
+                       : cmp == VS_CMP_GT ? _mm256_cmpgt_epi8(items, scalar)
+                                          : _mm256_cmpeq_epi8(items, scalar);
+        _mm256_storeu_si256((__m256i *)(dst + i), _mm256_and_si256(mask, one));
+    }
+    sse2_cmp_byte(dst + i, src + i, n - i, x, cmp);
+}
+
+/* end avx2 kernels */
+
+// sse2 has no 64 bit compares, so ints are compared by the scalar kernels.
+static const VSArrayKernels sse2_kernels = {
+    VS_SIMD_SSE2,
+    sse2_sum_int, scalar_min_int, scalar_max_int, sse2_scale_int,
+    sse2_add_int, scalar_cmp_int, sse2_cumsum_int,
+    sse2_sum_byte, sse2_min_byte, sse2_max_byte, sse2_cmp_byte};
+
+static const VSArrayKernels avx2_kernels = {
+    VS_SIMD_AVX2,
+    avx2_sum_int, avx2_min_int, avx2_max_int, avx2_scale_int,
+    avx2_add_int, avx2_cmp_int, avx2_cumsum_int,
+    avx2_sum_byte, avx2_min_byte, avx2_max_byte, avx2_cmp_byte};
+
+int vs_simd_level() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") ? VS_SIMD_AVX2 : VS_SIMD_SSE2;
+}
+
+static VSArrayKernels select_kernels(int level) {
+    level = std::min(level, vs_simd_level());
+    return level == VS_SIMD_AVX2 ? avx2_kernels : level == VS_SIMD_SSE2 ? sse2_kernels : scalar_kernels;
+}
+
+#else
+
+int vs_simd_level() {
+    return VS_SIMD_NONE;
+}
+
+static VSArrayKernels select_kernels(int) {
+    return scalar_kernels;
+}
+
+#endif
+
+VSArrayKernels vs_array_kernels = select_kernels(VS_SIMD_AVX2);
+
+void vs_array_kernels_select(int level) {
+    vs_array_kernels = select_kernels(level);
+}
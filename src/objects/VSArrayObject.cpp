@@ -0,0 +1,523 @@
+#include "objects/VSArrayObject.hpp"
+
+#include <algorithm>
+
+#include "error.hpp"
+#include "objects/VSArrayKernels.hpp"
+#include "objects/VSFloatObject.hpp"
+#include "objects/VSFunctionObject.hpp"
+#include "objects/VSIntObject.hpp"
+#include "objects/VSListObject.hpp"
+#include "objects/VSNoneObject.hpp"
+#include "objects/VSStringObject.hpp"
+#include "objects/VSTupleObject.hpp"
+
+NEW_IDENTIFIER(__hash__);
+NEW_IDENTIFIER(__eq__);
+NEW_IDENTIFIER(__str__);
+NEW_IDENTIFIER(copy);
+NEW_IDENTIFIER(clear);
+NEW_IDENTIFIER(len);
+NEW_IDENTIFIER(get);
+NEW_IDENTIFIER(set);
+NEW_IDENTIFIER(append);
+NEW_IDENTIFIER(sum);
+NEW_IDENTIFIER(min);
+NEW_IDENTIFIER(max);
+NEW_IDENTIFIER(dot);
+NEW_IDENTIFIER(scale);
+NEW_IDENTIFIER(add);
+NEW_IDENTIFIER(lt);
+NEW_IDENTIFIER(gt);
+NEW_IDENTIFIER(eq);
+NEW_IDENTIFIER(cumsum);
+NEW_IDENTIFIER(slice);
+
+// type, name and boxing of the items of an array of T. sum_t is the type sums
+// and dot products of the items are accumulated in.
+template <typename T>
+struct ArrayItem;
+
+template <>
+struct ArrayItem<cint_t> {
+    typedef cint_t sum_t;
+    static const TYPE type = T_INTARRAY;
+    static constexpr const char *name = "intarray";
+
+    static bool unbox(VSObject *obj, cint_t &item) {
+        if (obj->type != T_INT) {
+            return false;
+        }
+        item = INT_TO_C_INT(obj);
+        return true;
+    }
+
+    static VSObject *box(cint_t item) {
+        return C_INT_TO_INT(item);
+    }
+};
+
+template <>
+struct ArrayItem<cfloat_t> {
+    typedef cfloat_t sum_t;
+    static const TYPE type = T_FLOATARRAY;
+    static constexpr const char *name = "floatarray";
+
+    // ints are converted, as in float()
+    static bool unbox(VSObject *obj, cfloat_t &item) {
+        if (obj->type == T_FLOAT) {
+            item = FLOAT_TO_C_FLOAT(obj);
+        } else if (obj->type == T_INT) {
+            item = (cfloat_t)INT_TO_C_INT(obj);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
+    static VSObject *box(cfloat_t item) {
+        return C_FLOAT_TO_FLOAT(item);
+    }
+};
+
+template <>
+struct ArrayItem<cbyte_t> {
+    typedef cint_t sum_t;
+    static const TYPE type = T_BYTEARRAY;
+    static constexpr const char *name = "bytearray";
+
+    // ints in [0, 255]
+    static bool unbox(VSObject *obj, cbyte_t &item) {
+        if (obj->type != T_INT || INT_TO_C_INT(obj) < 0 || INT_TO_C_INT(obj) > 255) {
+            return false;
+        }
+        item = (cbyte_t)INT_TO_C_INT(obj);
+        return true;
+    }
+
+    static VSObject *box(cbyte_t item) {
+        return C_INT_TO_INT(item);
+    }
+};
+
+// check the nargs of a method of an array of T and the type of its self.
+template <typename T>
+static VSArrayObject<T> *array_self(VSObject *self, const char *method, vs_size_t expected, vs_size_t nargs) {
+    if (nargs != expected) {
+        err("Unexpected nargs for function \"%s.%s()\": %ld, expected: %ld",
+            ArrayItem<T>::name, method, nargs, expected);
+        terminate(TERM_ERROR);
+    }
+
+    if (self->type != ArrayItem<T>::type) {
+        err("Can not apply \"%s.%s()\" on type \"%s\".", ArrayItem<T>::name, method, TYPE_STR[self->type]);
+        terminate(TERM_ERROR);
+    }
+    return AS_ARRAY(T, self);
+}
+
+template <typename T>
+static T array_unbox(VSObject *obj) {
+    T item;
+    if (!ArrayItem<T>::unbox(obj, item)) {
+        err("can not store \"%s\" object in %s", TYPE_STR[obj->type], ArrayItem<T>::name);
+        terminate(TERM_ERROR);
+    }
+    return item;
+}
+
+template <typename T>
+static vs_size_t array_index(VSArrayObject<T> *array, VSObject *idxobj) {
+    ENSURE_TYPE(idxobj, T_INT, "as array index");
+
+    vs_size_t idx = (vs_size_t)INT_TO_C_INT(idxobj);
+    if (idx >= array->items.size()) {
+        INDEX_OUT_OF_BOUND(idx, array->items.size());
+        terminate(TERM_ERROR);
+    }
+    return idx;
+}
+
+// kernels over the raw items, the int and byte ones vectorized.
+template <typename T>
+static typename ArrayItem<T>::sum_t items_sum(std::vector<T> &items) {
+    return vs_kernel_sum<T, typename ArrayItem<T>::sum_t>(items.data(), items.size());
+}
+
+static cint_t items_sum(std::vector<cint_t> &items) {
+    return vs_array_kernels.sum_int(items.data(), items.size());
+}
+
+static cint_t items_sum(std::vector<cbyte_t> &items) {
+    return vs_array_kernels.sum_byte(items.data(), items.size());
+}
+
+template <typename T>
+static T items_min(std::vector<T> &items) {
+    return vs_kernel_min(items.data(), items.size());
+}
+
+static cint_t items_min(std::vector<cint_t> &items) {
+    return vs_array_kernels.min_int(items.data(), items.size());
+}
+
+static cbyte_t items_min(std::vector<cbyte_t> &items) {
+    return vs_array_kernels.min_byte(items.data(), items.size());
+}
+
+template <typename T>
+static T items_max(std::vector<T> &items) {
+    return vs_kernel_max(items.data(), items.size());
+}
+
+static cint_t items_max(std::vector<cint_t> &items) {
+    return vs_array_kernels.max_int(items.data(), items.size());
+}
+
+static cbyte_t items_max(std::vector<cbyte_t> &items) {
+    return vs_array_kernels.max_byte(items.data(), items.size());
+}
+
+template <typename T>
+static void items_scale(std::vector<T> &items, T k) {
+    vs_kernel_scale(items.data(), items.data(), items.size(), k);
+}
+
+static void items_scale(std::vector<cint_t> &items, cint_t k) {
+    vs_array_kernels.scale_int(items.data(), items.data(), items.size(), k);
+}
+
+template <typename S, typename T>
+static void items_add(std::vector<S> &items, std::vector<T> &that) {
+    for (vs_size_t i = 0; i < items.size(); i++) {
+        items[i] += that[i];
+    }
+}
+
+static void items_add(std::vector<cint_t> &items, std::vector<cint_t> &that) {
+    vs_array_kernels.add_int(items.data(), items.data(), that.data(), items.size());
+}
+
+template <typename T>
+static void items_cumsum(std::vector<T> &items) {
+    vs_kernel_cumsum(items.data(), items.data(), items.size());
+}
+
+static void items_cumsum(std::vector<cint_t> &items) {
+    vs_array_kernels.cumsum_int(items.data(), items.data(), items.size());
+}
+
+template <typename T>
+static void items_cmp(std::vector<cbyte_t> &mask, std::vector<T> &items, T x, int cmp) {
+    vs_kernel_cmp(mask.data(), items.data(), items.size(), x, cmp);
+}
+
+static void items_cmp(std::vector<cbyte_t> &mask, std::vector<cint_t> &items, cint_t x, int cmp) {
+    vs_array_kernels.cmp_int(mask.data(), items.data(), items.size(), x, cmp);
+}
+
+static void items_cmp(std::vector<cbyte_t> &mask, std::vector<cbyte_t> &items, cint_t x, int cmp) {
+    if (x >= 0 && x <= 255) {
+        vs_array_kernels.cmp_byte(mask.data(), items.data(), items.size(), (cbyte_t)x, cmp);
+    } else {
+        // all the items are on the same side of x
+        cbyte_t res = cmp == VS_CMP_LT ? x > 255 : cmp == VS_CMP_GT ? x < 0 : 0;
+        std::fill(mask.begin(), mask.end(), res);
+    }
+}
+
+// copy of the items of array as sum_t, which the elementwise methods return.
+template <typename T>
+static VSArrayObject<typename ArrayItem<T>::sum_t> *array_widen(VSArrayObject<T> *array) {
+    auto res = new VSArrayObject<typename ArrayItem<T>::sum_t>(0);
+    res->items.assign(array->items.begin(), array->items.end());
+    return res;
+}
+
+// intarray(), intarray(n) of n zeros, or intarray(list, tuple or intarray),
+// and the same for the others.
+template <typename T>
+static VSObject *vs_array(VSObject *const *args, vs_size_t nargs) {
+    if (nargs > 1) {
+        err("Unexpected nargs for function \"%s()\": %ld, expected: %ld", ArrayItem<T>::name, nargs, 1L);
+        terminate(TERM_ERROR);
+    }
+
+    VSArrayObject<T> *array = new VSArrayObject<T>(0);
+    if (nargs == 0) {
+        INCREF_RET(array);
+    }
+
+    VSObject *obj = args[0];
+    if (obj->type == T_INT) {
+        if (INT_TO_C_INT(obj) < 0) {
+            err("negative length of %s: %ld", ArrayItem<T>::name, INT_TO_C_INT(obj));
+            terminate(TERM_ERROR);
+        }
+        array->items.resize(INT_TO_C_INT(obj));
+    } else if (obj->type == T_LIST) {
+        for (auto item : AS_LIST(obj)->items) {
+            array->items.push_back(array_unbox<T>(item));
+        }
+    } else if (obj->type == T_TUPLE) {
+        for (vs_size_t i = 0; i < TUPLE_LEN(obj); i++) {
+            array->items.push_back(array_unbox<T>(TUPLE_GET(obj, i)));
+        }
+    } else if (obj->type == ArrayItem<T>::type) {
+        array->items = AS_ARRAY(T, obj)->items;
+    } else {
+        err("can not cast \"%s\" object to %s", TYPE_STR[obj->type], ArrayItem<T>::name);
+        terminate(TERM_ERROR);
+    }
+    INCREF_RET(array);
+}
+
+VSObject *vs_intarray(VSObject *, VSObject *const *args, vs_size_t nargs) {
+    return vs_array<cint_t>(args, nargs);
+}
+
+VSObject *vs_floatarray(VSObject *, VSObject *const *args, vs_size_t nargs) {
+    return vs_array<cfloat_t>(args, nargs);
+}
+
+VSObject *vs_bytearray(VSObject *, VSObject *const *args, vs_size_t nargs) {
+    return vs_array<cbyte_t>(args, nargs);
+}
+
+template <typename T>
+static VSObject *vs_array_str(VSObject *self, VSObject *const *, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "__str__", 0, nargs);
+
+    std::string array_str = "[";
+    for (vs_size_t i = 0; i < array->items.size(); i++) {
+        if (i > 0) {
+            array_str.append(", ");
+        }
+        array_str.append(std::to_string(array->items[i]));
+    }
+    array_str.append("]");
+
+    INCREF_RET(C_STRING_TO_STRING(array_str));
+}
+
+template <typename T>
+static VSObject *vs_array_copy(VSObject *self, VSObject *const *, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "copy", 0, nargs);
+
+    VSArrayObject<T> *new_array = new VSArrayObject<T>(0);
+    new_array->items = array->items;
+    INCREF_RET(new_array);
+}
+
+template <typename T>
+static VSObject *vs_array_slice(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "slice", 2, nargs);
+
+    vs_size_t start, end;
+    vs_slice_bounds(args[0], args[1], array->items.size(), start, end);
+
+    VSArrayObject<T> *new_array = new VSArrayObject<T>(0);
+    new_array->items.assign(array->items.begin() + start, array->items.begin() + end);
+    INCREF_RET(new_array);
+}
+
+template <typename T>
+static VSObject *vs_array_clear(VSObject *self, VSObject *const *, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "clear", 0, nargs);
+
+    array->items.clear();
+    INCREF_RET(VS_NONE);
+}
+
+template <typename T>
+static VSObject *vs_array_len(VSObject *self, VSObject *const *, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "len", 0, nargs);
+
+    INCREF_RET(C_INT_TO_INT((cint_t)array->items.size()));
+}
+
+template <typename T>
+static VSObject *vs_array_get(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "get", 1, nargs);
+
+    vs_size_t idx = array_index(array, args[0]);
+    INCREF_RET(ArrayItem<T>::box(array->items[idx]));
+}
+
+template <typename T>
+static VSObject *vs_array_set(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "set", 2, nargs);
+
+    vs_size_t idx = array_index(array, args[0]);
+    array->items[idx] = array_unbox<T>(args[1]);
+    INCREF_RET(VS_NONE);
+}
+
+template <typename T>
+static VSObject *vs_array_append(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "append", 1, nargs);
+
+    array->items.push_back(array_unbox<T>(args[0]));
+    INCREF_RET(VS_NONE);
+}
+
+template <typename T>
+static VSObject *vs_array_sum(VSObject *self, VSObject *const *, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "sum", 0, nargs);
+
+    INCREF_RET(ArrayItem<typename ArrayItem<T>::sum_t>::box(items_sum(array->items)));
+}
+
+// min or max of the items.
+template <typename T, bool max>
+static VSObject *vs_array_extreme(VSObject *self, VSObject *const *, vs_size_t nargs) {
+    const char *method = max ? "max" : "min";
+    VSArrayObject<T> *array = array_self<T>(self, method, 0, nargs);
+
+    if (array->items.empty()) {
+        err("%s.%s() of empty array", ArrayItem<T>::name, method);
+        terminate(TERM_ERROR);
+    }
+
+    INCREF_RET(ArrayItem<T>::box(max ? items_max(array->items) : items_min(array->items)));
+}
+
+template <typename T>
+static VSObject *vs_array_dot(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "dot", 1, nargs);
+
+    VSObject *that = args[0];
+    if (that->type != ArrayItem<T>::type) {
+        err("Can not apply \"%s.dot()\" on type \"%s\".", ArrayItem<T>::name, TYPE_STR[that->type]);
+        terminate(TERM_ERROR);
+    }
+
+    std::vector<T> &a = array->items, &b = AS_ARRAY(T, that)->items;
+    if (a.size() != b.size()) {
+        err("%s.dot() of arrays of length %ld and %ld", ArrayItem<T>::name, a.size(), b.size());
+        terminate(TERM_ERROR);
+    }
+
+    typedef typename ArrayItem<T>::sum_t sum_t;
+    sum_t sum = 0;
+    for (vs_size_t i = 0; i < a.size(); i++) {
+        sum += (sum_t)a[i] * (sum_t)b[i];
+    }
+    INCREF_RET(ArrayItem<sum_t>::box(sum));
+}
+
+template <typename T>
+static VSObject *vs_array_scale(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "scale", 1, nargs);
+
+    typedef typename ArrayItem<T>::sum_t sum_t;
+    sum_t k = array_unbox<sum_t>(args[0]);
+    VSArrayObject<sum_t> *res = array_widen(array);
+    items_scale(res->items, k);
+    INCREF_RET(res);
+}
+
+template <typename T>
+static VSObject *vs_array_add(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "add", 1, nargs);
+
+    VSObject *that = args[0];
+    if (that->type != ArrayItem<T>::type) {
+        err("Can not apply \"%s.add()\" on type \"%s\".", ArrayItem<T>::name, TYPE_STR[that->type]);
+        terminate(TERM_ERROR);
+    }
+    if (array->items.size() != ARRAY_LEN(T, that)) {
+        err("%s.add() of arrays of length %ld and %ld", ArrayItem<T>::name, array->items.size(), ARRAY_LEN(T, that));
+        terminate(TERM_ERROR);
+    }
+
+    auto res = array_widen(array);
+    items_add(res->items, AS_ARRAY(T, that)->items);
+    INCREF_RET(res);
+}
+
+// mask of the items compared with a scalar, as a bytearray of 0 and 1.
+template <typename T, int cmp>
+static VSObject *vs_array_cmp(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    const char *method = cmp == VS_CMP_LT ? "lt" : cmp == VS_CMP_GT ? "gt" : "eq";
+    VSArrayObject<T> *array = array_self<T>(self, method, 1, nargs);
+
+    typedef typename ArrayItem<T>::sum_t sum_t;
+    sum_t x = array_unbox<sum_t>(args[0]);
+    VSByteArrayObject *mask = new VSByteArrayObject(array->items.size());
+    items_cmp(mask->items, array->items, x, cmp);
+    INCREF_RET(mask);
+}
+
+template <typename T>
+static VSObject *vs_array_cumsum(VSObject *self, VSObject *const *, vs_size_t nargs) {
+    VSArrayObject<T> *array = array_self<T>(self, "cumsum", 0, nargs);
+
+    auto res = array_widen(array);
+    items_cumsum(res->items);
+    INCREF_RET(res);
+}
+
+template <typename T>
+static const str_func_map &vs_array_methods() {
+    static const str_func_map methods = {
+        {ID___hash__, vs_default_hash},
+        {ID___eq__, vs_default_eq},
+        {ID___str__, vs_array_str<T>},
+        {ID_copy, vs_array_copy<T>},
+        {ID_clear, vs_array_clear<T>},
+        {ID_len, vs_array_len<T>},
+        {ID_get, vs_array_get<T>},
+        {ID_set, vs_array_set<T>},
+        {ID_append, vs_array_append<T>},
+        {ID_sum, vs_array_sum<T>},
+        {ID_min, vs_array_extreme<T, false>},
+        {ID_max, vs_array_extreme<T, true>},
+        {ID_dot, vs_array_dot<T>},
+        {ID_scale, vs_array_scale<T>},
+        {ID_add, vs_array_add<T>},
+        {ID_lt, vs_array_cmp<T, VS_CMP_LT>},
+        {ID_gt, vs_array_cmp<T, VS_CMP_GT>},
+        {ID_eq, vs_array_cmp<T, VS_CMP_EQ>},
+        {ID_cumsum, vs_array_cumsum<T>},
+        {ID_slice, vs_array_slice<T>}};
+    return methods;
+}
+
+template <typename T>
+VSArrayObject<T>::VSArrayObject(vs_size_t nitems) {
+    this->type = ArrayItem<T>::type;
+    this->items = std::vector<T>(nitems);
+}
+
+template <typename T>
+VSArrayObject<T>::~VSArrayObject() {
+}
+
+template <typename T>
+bool VSArrayObject<T>::hasattr(std::string &attrname) {
+    return vs_array_methods<T>().find(attrname) != vs_array_methods<T>().end();
+}
+
+template <typename T>
+VSObject *VSArrayObject<T>::getattr(std::string &attrname) {
+    auto iter = vs_array_methods<T>().find(attrname);
+    if (iter == vs_array_methods<T>().end()) {
+        ERR_NO_ATTR(this, attrname);
+        terminate(TERM_ERROR);
+    }
+
+    VSFunctionObject *attr = new VSNativeFunctionObject(
+        this, C_STRING_TO_STRING(attrname), iter->second);
+    INCREF_RET(attr);
+}
+
+template <typename T>
+void VSArrayObject<T>::setattr(std::string &, VSObject *) {
+    err("Unable to apply setattr on native type: \"%s\"", TYPE_STR[this->type]);
+    terminate(TERM_ERROR);
+}
+
+template class VSArrayObject<cint_t>;
+template class VSArrayObject<cfloat_t>;
+template class VSArrayObject<cbyte_t>;
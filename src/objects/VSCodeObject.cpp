@@ -6,6 +6,8 @@
 #include "objects/VSIntObject.hpp"
 #include "objects/VSNoneObject.hpp"
 #include "objects/VSTupleObject.hpp"
+#include "runtime/VSJit.hpp"
+#include "runtime/VSTrace.hpp"
 
 NEW_IDENTIFIER(__hash__);
 NEW_IDENTIFIER(__eq__);
@@ -72,6 +74,11 @@ VSCodeObject::VSCodeObject(VSStringObject *name) {
     this->cellvars = vs_list_pack(0);
     this->freevars = vs_list_pack(0);
     this->code = std::vector<VSInst>();
+    this->lazy = NULL;
+    this->native = NULL;
+    this->hotness = 0;
+    this->jit = NULL;
+    this->traces = NULL;
 
     // set constants
     this->add_const(VS_NONE);
@@ -84,6 +91,9 @@ VSCodeObject::~VSCodeObject() {
     DECREF_EX(this->names);
     DECREF_EX(this->cellvars);
     DECREF_EX(this->freevars);
+    DECREF_EX(this->lazy);
+    vs_jit_free(this->jit);
+    vs_trace_free(this->traces);
 }
 
 bool VSCodeObject::hasattr(std::string &attrname) {
@@ -140,4 +150,14 @@ void VSCodeObject::add_cellvar(VSObject *name) {
 void VSCodeObject::add_freevar(VSObject *name) {
     LIST_APPEND(this->freevars, name);
     this->nfreevars++;
-}
\ No newline at end of file
+}
+void VSCodeObject::load() {
+    if (this->lazy == NULL) {
+        return;
+    }
+
+    VSLazyBody *lazy = this->lazy;
+    this->lazy = NULL;
+    lazy->gen(this);
+    DECREF(lazy);
+}
@@ -15,13 +15,18 @@ NEW_IDENTIFIER(set);
 NEW_IDENTIFIER(has_at);
 NEW_IDENTIFIER(remove_at);
 
-VSObject *vs_dict(VSObject *, VSObject *const *, vs_size_t nargs) {
-    if (nargs != 0) {
-        ERR_NARGS("dict()", 0, nargs);
+VSObject *vs_dict(VSObject *, VSObject *const *args, vs_size_t nargs) {
+    if (nargs > 1) {
+        ERR_NARGS("dict()", 1, nargs);
         terminate(TERM_ERROR);
     }
 
-    INCREF_RET(new VSDictObject());
+    VSDictObject *dict = new VSDictObject();
+    if (nargs == 1) {
+        // dict(capacity) has its buckets for that many entries up front
+        dict->_dict.reserve(vs_capacity(args[0], "dict"));
+    }
+    INCREF_RET(dict);
 }
 
 VSObject *vs_dict_str(VSObject *self, VSObject *const *, vs_size_t nargs) {
@@ -75,7 +75,7 @@ VSObject *vs_file_hash(VSObject *self, VSObject *const *, vs_size_t nargs) {
 
     ENSURE_TYPE(self, T_FILE, "file.__hash__()");
 
-    cint_t hash = (cint_t)std::hash<std::string>{}(((VSFileObject *)self)->name->_value);
+    cint_t hash = (cint_t)std::hash<std::string>{}(((VSFileObject *)self)->name->value());
     INCREF_RET(C_INT_TO_INT(hash));
 }
 
@@ -92,7 +92,7 @@ VSObject *vs_file_eq(VSObject *self, VSObject *const *args, vs_size_t nargs) {
 
     ENSURE_TYPE(self, T_FILE, "file.__eq__()");
 
-    cbool_t res = ((VSFileObject *)self)->name->_value == ((VSFileObject *)that)->name->_value;
+    cbool_t res = ((VSFileObject *)self)->name->value() == ((VSFileObject *)that)->name->value();
     INCREF_RET(res ? VS_TRUE : VS_FALSE);
 }
 
@@ -106,7 +106,7 @@ VSObject *vs_file_str(VSObject *self, VSObject *const *, vs_size_t nargs) {
 
     INCREF_RET(
         C_STRING_TO_STRING(
-            "file object: " + ((VSFileObject *)self)->name->_value));
+            "file object: " + ((VSFileObject *)self)->name->value()));
 }
 
 VSObject *vs_file_bytes(VSObject *self, VSObject *const *, vs_size_t nargs) {
@@ -138,7 +138,7 @@ VSObject *vs_file_read(VSObject *self, VSObject *const *args, vs_size_t nargs) {
     VSFileObject *file = (VSFileObject *)self;
 
     if (!(file->flags & FILE_READABLE)) {
-        err("file \"%s\" is not readable", file->name->_value.c_str());
+        err("file \"%s\" is not readable", file->name->value().c_str());
         terminate(TERM_ERROR);
     }
 
@@ -194,7 +194,7 @@ VSObject *vs_file_readline(VSObject *self, VSObject *const *, vs_size_t nargs) {
     VSFileObject *file = (VSFileObject *)self;
 
     if (!(file->flags & FILE_READABLE)) {
-        err("file \"%s\" is not readable", file->name->_value.c_str());
+        err("file \"%s\" is not readable", file->name->value().c_str());
         terminate(TERM_ERROR);
     }
 
@@ -233,7 +233,7 @@ VSObject *vs_file_write(VSObject *self, VSObject *const *args, vs_size_t nargs)
     std::string &str = STRING_TO_C_STRING(args[0]);
 
     if (!(file->flags & FILE_WRITABLE)) {
-        err("file \"%s\" is not writable", file->name->_value.c_str());
+        err("file \"%s\" is not writable", file->name->value().c_str());
         terminate(TERM_ERROR);
     }
 
@@ -270,7 +270,7 @@ VSObject *vs_file_writeline(VSObject *self, VSObject *const *args, vs_size_t nar
     std::string &str = STRING_TO_C_STRING(args[0]);
 
     if (!(file->flags & FILE_WRITABLE)) {
-        err("file \"%s\" is not writable", file->name->_value.c_str());
+        err("file \"%s\" is not writable", file->name->value().c_str());
         terminate(TERM_ERROR);
     }
 
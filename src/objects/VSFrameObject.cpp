@@ -46,45 +46,65 @@ const str_func_map VSFrameObject::vs_frame_methods = {
 VSFrameObject::VSFrameObject(VSCodeObject *code, VSTupleObject *args, VSTupleObject *cellvars, VSTupleObject *freevars, VSFrameObject *prev) {
     this->type = T_FRAME;
 
+    this->code = NULL;
+    this->locals = NULL;
+    this->cellvars = NULL;
+    this->freevars = NULL;
+    this->reset(code, args, cellvars, freevars);
+
+    this->prev = prev;
+    INCREF(prev);
+}
+
+void VSFrameObject::reset(VSCodeObject *code, VSTupleObject *args, VSTupleObject *cellvars, VSTupleObject *freevars) {
     this->pc = 0;
 
     assert(code != NULL);
-    this->code = code;
     INCREF(code);
+    DECREF_EX(this->code);
+    this->code = code;
 
+    // the locals tuple is reused if nothing else refers to it
     this->nlocals = code->nlvars;
-    this->locals = new VSTupleObject(this->nlocals);
+    if (this->locals == NULL || this->locals->refcnt > 1 || TUPLE_LEN(this->locals) != this->nlocals) {
+        DECREF_EX(this->locals);
+        this->locals = new VSTupleObject(this->nlocals);
+        INCREF(this->locals);
+    }
     for (vs_size_t i = 0; i < this->nlocals; i++) {
+        VSObject *value;
         if (i < code->nargs) {
             if (i < code->nargs - 1 || !(code->flags & VS_FUNC_VARARGS)) {
-                TUPLE_SET(this->locals, i, new VSCellObject(TUPLE_GET(args, i)));
+                value = TUPLE_GET(args, i);
             } else {
                 VSTupleObject *va_args = new VSTupleObject(TUPLE_LEN(args) - code->nargs + 1);
                 for (vs_size_t j = i; j < TUPLE_LEN(args); j++) {
                     TUPLE_SET(va_args, j - i, TUPLE_GET(args, j));
                 }
-                TUPLE_SET(this->locals, i, new VSCellObject(va_args));
+                value = va_args;
             }
         } else {
-            TUPLE_SET(this->locals, i, new VSCellObject(VS_NONE));
+            value = VS_NONE;
+        }
+
+        // cells captured by closures are left to them
+        VSObject *cell = TUPLE_GET(this->locals, i);
+        if (cell != NULL && cell->refcnt == 1) {
+            VS_CELL_SET(cell, value);
+        } else {
+            TUPLE_SET(this->locals, i, new VSCellObject(value));
         }
     }
-    INCREF(this->locals);
 
+    INCREF(cellvars);
+    DECREF_EX(this->cellvars);
     this->cellvars = cellvars;
-    if (cellvars != NULL) {
-        this->ncellvars = TUPLE_LEN(cellvars);
-        INCREF(cellvars);
-    }
+    this->ncellvars = cellvars == NULL ? 0 : TUPLE_LEN(cellvars);
 
+    INCREF(freevars);
+    DECREF_EX(this->freevars);
     this->freevars = freevars;
-    if (freevars != NULL) {
-        this->nfreevars = TUPLE_LEN(freevars);
-        INCREF(freevars);
-    }
-
-    this->prev = prev;
-    INCREF(prev);
+    this->nfreevars = freevars == NULL ? 0 : TUPLE_LEN(freevars);
 }
 
 VSFrameObject::~VSFrameObject() {
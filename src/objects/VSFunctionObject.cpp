@@ -35,7 +35,7 @@ VSObject *vs_native_func_str(VSObject *funcobj, VSObject *const *, vs_size_t nar
     }
 
     VSFunctionObject *func = (VSFunctionObject *)funcobj;
-    INCREF_RET(C_STRING_TO_STRING("native function: " + func->name->_value));
+    INCREF_RET(C_STRING_TO_STRING("native function: " + func->name->value()));
 }
 
 VSObject *vs_native_func_bytes(VSObject *funcobj, VSObject *const *, vs_size_t nargs) {
@@ -116,7 +116,7 @@ VSObject *vs_dynamic_func_str(VSObject *funcobj, VSObject *const *, vs_size_t na
     }
 
     VSFunctionObject *func = (VSFunctionObject *)funcobj;
-    INCREF_RET(C_STRING_TO_STRING("dynamic function: " + func->name->_value));
+    INCREF_RET(C_STRING_TO_STRING("dynamic function: " + func->name->value()));
 }
 
 VSObject *vs_dynamic_func_bytes(VSObject *funcobj, VSObject *const *, vs_size_t nargs) {
@@ -142,14 +142,13 @@ VSDynamicFunctionObject::VSDynamicFunctionObject(VSStringObject *name, VSCodeObj
     this->name = NEW_REF(VSStringObject *, name);
     this->code = NEW_REF(VSCodeObject *, code);
     this->freevars = NEW_REF(VSTupleObject *, freevars);
+    this->flags = flags;
 
-    this->cellvars = new VSTupleObject(code->ncellvars);
-    for (vs_addr_t i = 0; i < code->ncellvars; i++) {
-        TUPLE_SET(this->cellvars, i, VS_NONE);
+    // cell vars of a deferred body are only known when it is generated.
+    this->cellvars = NULL;
+    if (code->lazy == NULL) {
+        this->load();
     }
-    INCREF(this->cellvars);
-
-    this->flags = flags;
 }
 
 VSDynamicFunctionObject::~VSDynamicFunctionObject() {
@@ -188,18 +187,36 @@ void VSDynamicFunctionObject::setattr(std::string &, VSObject *) {
     terminate(TERM_ERROR);
 }
 
-VSObject *VSDynamicFunctionObject::call(VSTupleObject *args) {
+void VSDynamicFunctionObject::check_args(VSTupleObject *args) {
     assert(args != NULL);
     vs_size_t nargs = TUPLE_LEN(args);
     bool va_args = VS_FUNC_VARARGS & this->flags;
 
     if (va_args && nargs < this->code->nargs - 1) {
-        ERR_NARGS(this->name->_value.c_str(), this->code->nargs - 1, nargs);
+        ERR_NARGS(this->name->value().c_str(), this->code->nargs - 1, nargs);
         terminate(TERM_ERROR);
     } else if (!va_args && nargs != this->code->nargs) {
-        ERR_NARGS(this->name->_value.c_str(), this->code->nargs, nargs);
+        ERR_NARGS(this->name->value().c_str(), this->code->nargs, nargs);
         terminate(TERM_ERROR);
     }
+}
+
+void VSDynamicFunctionObject::load() {
+    if (this->cellvars != NULL) {
+        return;
+    }
+
+    this->code->load();
+    this->cellvars = new VSTupleObject(this->code->ncellvars);
+    for (vs_addr_t i = 0; i < this->code->ncellvars; i++) {
+        TUPLE_SET(this->cellvars, i, VS_NONE);
+    }
+    INCREF(this->cellvars);
+}
+
+VSObject *VSDynamicFunctionObject::call(VSTupleObject *args) {
+    this->load();
+    this->check_args(args);
 
     std::stack<VSObject *> stack = std::stack<VSObject *>();
     VSFrameObject *frame = new VSFrameObject(
@@ -1,9 +1,12 @@
 #include "objects/VSListObject.hpp"
 
+#include <algorithm>
 #include <cstdarg>
 
 #include "error.hpp"
 #include "objects/VSBoolObject.hpp"
+#include "objects/VSCharObject.hpp"
+#include "objects/VSFloatObject.hpp"
 #include "objects/VSFunctionObject.hpp"
 #include "objects/VSIntObject.hpp"
 #include "objects/VSSetObject.hpp"
@@ -15,14 +18,19 @@ NEW_IDENTIFIER(__eq__);
 NEW_IDENTIFIER(__str__);
 NEW_IDENTIFIER(__bytes__);
 NEW_IDENTIFIER(__add__);
+NEW_IDENTIFIER(__lt__);
 NEW_IDENTIFIER(copy);
 NEW_IDENTIFIER(clear);
 NEW_IDENTIFIER(len);
 NEW_IDENTIFIER(get);
 NEW_IDENTIFIER(set);
 NEW_IDENTIFIER(append);
+NEW_IDENTIFIER(extend);
 NEW_IDENTIFIER(has_at);
 NEW_IDENTIFIER(remove_at);
+NEW_IDENTIFIER(sort);
+NEW_IDENTIFIER(sorted);
+NEW_IDENTIFIER(slice);
 
 VSObject *vs_list(VSObject *, VSObject *const *args, vs_size_t nargs) {
     if (nargs == 0) {
@@ -33,13 +41,18 @@ VSObject *vs_list(VSObject *, VSObject *const *args, vs_size_t nargs) {
             INCREF_RET(obj);
         } else if (obj->type == T_TUPLE) {
             return vs_tuple_to_list(obj);
-        } else if (obj->type == T_SET) {
+        } else if (IS_SET(obj)) {
             VSSetObject *set = (VSSetObject *)obj;
             VSListObject *list = new VSListObject(0);
             for (auto item : set->_set) {
                 LIST_APPEND(list, item);
             }
             INCREF_RET(list);
+        } else if (obj->type == T_INT) {
+            // list(n) is empty, with room for n items
+            VSListObject *list = new VSListObject(0);
+            list->items.reserve(vs_capacity(obj, "list"));
+            INCREF_RET(list);
         } else {
             err("can not cast \"%s\" object to list", TYPE_STR[obj->type]);
             INCREF_RET(VS_NONE);
@@ -136,6 +149,26 @@ VSObject *vs_list_copy(VSObject *self, VSObject *const *, vs_size_t nargs) {
     INCREF_RET(AS_OBJECT(new_list));
 }
 
+VSObject *vs_list_slice(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 2) {
+        ERR_NARGS("list.slice()", 2, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_LIST, "list.slice()");
+
+    VSListObject *old_list = (VSListObject *)self;
+    vs_size_t start, end;
+    vs_slice_bounds(args[0], args[1], old_list->items.size(), start, end);
+
+    VSListObject *new_list = new VSListObject(0);
+    new_list->items.assign(old_list->items.begin() + start, old_list->items.begin() + end);
+    for (auto item : new_list->items) {
+        INCREF(item);
+    }
+    INCREF_RET(AS_OBJECT(new_list));
+}
+
 VSObject *vs_list_clear(VSObject *self, VSObject *const *, vs_size_t nargs) {
     if (nargs != 0) {
         ERR_NARGS("list.clear()", 0, nargs);
@@ -225,6 +258,40 @@ VSObject *vs_list_append(VSObject *self, VSObject *const *args, vs_size_t nargs)
     INCREF_RET(VS_NONE);
 }
 
+VSObject *vs_list_extend(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("list.extend()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_LIST, "list.extend()");
+
+    // room for all the items is made once, then they are copied over
+    VSListObject *list = (VSListObject *)self;
+    VSObject *obj = args[0];
+    if (obj->type == T_LIST || obj->type == T_TUPLE) {
+        vs_size_t nitems = obj->type == T_LIST ? LIST_LEN(obj) : TUPLE_LEN(obj);
+        list->items.reserve(list->items.size() + nitems);
+        // taken after the reserve, which may move the items of a list
+        // extended by itself
+        VSObject *const *items = obj->type == T_LIST ? AS_LIST(obj)->items.data() : AS_TUPLE(obj)->items;
+        for (vs_size_t i = 0; i < nitems; i++) {
+            INCREF(items[i]);
+            list->items.push_back(items[i]);
+        }
+    } else if (IS_SET(obj)) {
+        list->items.reserve(list->items.size() + SET_LEN(obj));
+        for (auto item : AS_SET(obj)->_set) {
+            INCREF(item);
+            list->items.push_back(item);
+        }
+    } else {
+        err("can not extend list with \"%s\" object", TYPE_STR[obj->type]);
+        terminate(TERM_ERROR);
+    }
+    INCREF_RET(VS_NONE);
+}
+
 // TODO: implement list.__has__()
 VSObject *vs_list_has(VSObject *self, VSObject *const *, vs_size_t nargs) {
     if (nargs != 1) {
@@ -291,6 +358,258 @@ VSObject *vs_list_remove_at(VSObject *self, VSObject *const *args, vs_size_t nar
     INCREF_RET(VS_NONE);
 }
 
+// runs shorter than this are extended by binary insertion before merging.
+#define SORT_MIN_RUN 32
+
+// minimum run length, so that n / minrun is a power of 2 or a bit less.
+static vs_size_t sort_min_run(vs_size_t n) {
+    vs_size_t r = 0;
+    while (n >= 2 * SORT_MIN_RUN) {
+        r |= n & 1;
+        n >>= 1;
+    }
+    return n + r;
+}
+
+// sort items[lo:end], whose items[lo:start] is sorted, by binary insertion.
+template <typename T, typename Less>
+static void sort_insertion(std::vector<T> &items, vs_size_t lo, vs_size_t start, vs_size_t end, Less &less) {
+    for (vs_size_t i = start; i < end; i++) {
+        T item = std::move(items[i]);
+        // after the equal items, for stability
+        vs_size_t left = lo, right = i;
+        while (left < right) {
+            vs_size_t mid = left + (right - left) / 2;
+            if (less(item, items[mid])) {
+                right = mid;
+            } else {
+                left = mid + 1;
+            }
+        }
+        std::move_backward(items.begin() + left, items.begin() + i, items.begin() + i + 1);
+        items[left] = std::move(item);
+    }
+}
+
+// merge the sorted adjacent items[lo:mid] and items[mid:hi].
+template <typename T, typename Less>
+static void sort_merge(std::vector<T> &items, std::vector<T> &buf, vs_size_t lo, vs_size_t mid, vs_size_t hi, Less &less) {
+    // items of the left run not greater than the first right one are in place,
+    auto first = std::upper_bound(items.begin() + lo, items.begin() + mid, items[mid], less);
+    // and so are the right ones not less than the last left one.
+    auto last = std::lower_bound(items.begin() + mid, items.begin() + hi, items[mid - 1], less);
+    if (first == items.begin() + mid) {
+        return;
+    }
+
+    buf.assign(std::make_move_iterator(first), std::make_move_iterator(items.begin() + mid));
+    auto left = buf.begin(), right = items.begin() + mid, out = first;
+    while (left != buf.end() && right != last) {
+        if (less(*right, *left)) {
+            *out++ = std::move(*right++);
+        } else {
+            *out++ = std::move(*left++);
+        }
+    }
+    std::move(left, buf.end(), out);
+}
+
+// stable hybrid merge sort after timsort. Natural runs of the items, with the
+// descending ones reversed, are extended to the minimum run length by binary
+// insertion and merged, keeping the lengths of the pending runs balanced.
+template <typename T, typename Less>
+static void sort_items(std::vector<T> &items, Less less) {
+    vs_size_t n = items.size();
+    vs_size_t min_run = sort_min_run(n);
+    std::vector<T> buf;
+    // start and length of the pending runs
+    std::vector<std::pair<vs_size_t, vs_size_t>> runs;
+
+    auto merge_at = [&](vs_size_t i) {
+        vs_size_t lo = runs[i].first, mid = lo + runs[i].second;
+        vs_size_t hi = mid + runs[i + 1].second;
+        sort_merge(items, buf, lo, mid, hi, less);
+        runs[i].second += runs[i + 1].second;
+        runs.erase(runs.begin() + i + 1);
+    };
+
+    vs_size_t lo = 0;
+    while (lo < n) {
+        vs_size_t hi = lo + 1;
+        if (hi < n && less(items[hi], items[lo])) {
+            // strictly descending, so reversing it keeps the order of equals
+            while (hi + 1 < n && less(items[hi + 1], items[hi])) {
+                hi++;
+            }
+            std::reverse(items.begin() + lo, items.begin() + hi + 1);
+        } else {
+            while (hi + 1 < n && !less(items[hi + 1], items[hi])) {
+                hi++;
+            }
+        }
+        hi++;
+
+        vs_size_t end = std::min(n, std::max(hi, lo + min_run));
+        sort_insertion(items, lo, hi, end, less);
+        runs.push_back({lo, end - lo});
+        lo = end;
+
+        // merge until each run is longer than the next one, and than the two
+        // next ones together.
+        while (runs.size() > 1) {
+            vs_size_t i = runs.size() - 2;
+            if ((i > 0 && runs[i - 1].second <= runs[i].second + runs[i + 1].second) ||
+                (i > 1 && runs[i - 2].second <= runs[i - 1].second + runs[i].second)) {
+                if (runs[i - 1].second < runs[i + 1].second) {
+                    i--;
+                }
+            } else if (runs[i].second > runs[i + 1].second) {
+                break;
+            }
+            merge_at(i);
+        }
+    }
+
+    while (runs.size() > 1) {
+        vs_size_t i = runs.size() - 2;
+        if (i > 0 && runs[i - 1].second < runs[i + 1].second) {
+            i--;
+        }
+        merge_at(i);
+    }
+}
+
+// sort items by the keys at the same indices, with the keys taken by key_of.
+template <typename K, typename KeyOf, typename Less>
+static void sort_by(std::vector<VSObject *> &items, std::vector<VSObject *> &keys, KeyOf key_of, Less less) {
+    std::vector<std::pair<K, VSObject *>> pairs(items.size());
+    for (vs_size_t i = 0; i < items.size(); i++) {
+        pairs[i] = {key_of(keys[i]), items[i]};
+    }
+
+    sort_items(pairs, [&](const std::pair<K, VSObject *> &a, const std::pair<K, VSObject *> &b) {
+        return less(a.first, b.first);
+    });
+
+    for (vs_size_t i = 0; i < items.size(); i++) {
+        items[i] = pairs[i].second;
+    }
+}
+
+static bool sort_lt(VSObject *a, VSObject *b) {
+    VSObject *res = CALL_ATTR(a, ID___lt__, vs_tuple_pack(1, b));
+    if (res->type != T_BOOL) {
+        err("\"__lt__\" of \"%s\" object returned \"%s\" object, expected bool",
+            TYPE_STR[a->type], TYPE_STR[res->type]);
+        terminate(TERM_ERROR);
+    }
+
+    bool lt = BOOL_TO_C_BOOL(res);
+    DECREF(res);
+    return lt;
+}
+
+// sort items by keys. Keys all of int, float, char or str are compared
+// natively, others with their __lt__.
+static void sort_objects(std::vector<VSObject *> &items, std::vector<VSObject *> &keys) {
+    TYPE type = keys.empty() ? T_NONE : keys[0]->type;
+    for (auto key : keys) {
+        if (key->type != type) {
+            type = T_NONE;
+            break;
+        }
+    }
+
+    switch (type) {
+        case T_INT:
+            sort_by<cint_t>(
+                items, keys, [](VSObject *key) { return INT_TO_C_INT(key); },
+                [](cint_t a, cint_t b) { return a < b; });
+            break;
+        case T_FLOAT:
+            sort_by<cfloat_t>(
+                items, keys, [](VSObject *key) { return FLOAT_TO_C_FLOAT(key); },
+                [](cfloat_t a, cfloat_t b) { return a < b; });
+            break;
+        case T_CHAR:
+            sort_by<cchar_t>(
+                items, keys, [](VSObject *key) { return CHAR_TO_C_CHAR(key); },
+                [](cchar_t a, cchar_t b) { return a < b; });
+            break;
+        case T_STR:
+            sort_by<std::string *>(
+                items, keys, [](VSObject *key) { return &STRING_TO_C_STRING(key); },
+                [](std::string *a, std::string *b) { return *a < *b; });
+            break;
+        default:
+            sort_by<VSObject *>(
+                items, keys, [](VSObject *key) { return key; }, sort_lt);
+            break;
+    }
+}
+
+// sort the items of list in place, by the results of key on them if given.
+static void sort_list(VSListObject *list, VSObject *key, const char *funcname) {
+    // take the items, with their refs, out of the list while they are sorted.
+    // __lt__ and key see an empty list, and anything they add to it is an
+    // error, so no item can be freed under the sort.
+    std::vector<VSObject *> items;
+    items.swap(list->items);
+    vs_size_t nitems = items.size();
+
+    std::vector<VSObject *> keys;
+    if (key == NULL) {
+        sort_objects(items, items);
+    } else {
+        ENSURE_TYPE(key, T_FUNC, "as sort key");
+        keys.resize(nitems);
+        for (vs_size_t i = 0; i < nitems; i++) {
+            keys[i] = ((VSFunctionObject *)key)->call(vs_tuple_pack(1, items[i]));
+        }
+        sort_objects(items, keys);
+    }
+
+    for (auto keyobj : keys) {
+        DECREF(keyobj);
+    }
+    if (!list->items.empty()) {
+        for (auto item : items) {
+            DECREF(item);
+        }
+        err("list modified during %s", funcname);
+        terminate(TERM_ERROR);
+    }
+    list->items.swap(items);
+}
+
+VSObject *vs_list_sort(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs > 1) {
+        ERR_NARGS("list.sort()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_LIST, "list.sort()");
+
+    sort_list((VSListObject *)self, nargs == 1 ? args[0] : NULL, "list.sort()");
+    INCREF_RET(VS_NONE);
+}
+
+VSObject *vs_list_sorted(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs > 1) {
+        ERR_NARGS("list.sorted()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_LIST, "list.sorted()");
+
+    VSListObject *list = new VSListObject(0);
+    for (auto item : ((VSListObject *)self)->items) {
+        LIST_APPEND(list, item);
+    }
+    sort_list(list, nargs == 1 ? args[0] : NULL, "list.sorted()");
+    INCREF_RET(list);
+}
+
 VSListObject *vs_list_pack(vs_size_t nitems, ...) {
     VSListObject *list = new VSListObject(nitems);
 
@@ -352,8 +671,12 @@ const str_func_map VSListObject::vs_list_methods = {
     {ID_get, vs_list_get},
     {ID_set, vs_list_set},
     {ID_append, vs_list_append},
+    {ID_extend, vs_list_extend},
     {ID_has_at, vs_list_has_at},
-    {ID_remove_at, vs_list_remove_at}};
+    {ID_remove_at, vs_list_remove_at},
+    {ID_sort, vs_list_sort},
+    {ID_sorted, vs_list_sorted},
+    {ID_slice, vs_list_slice}};
 
 VSListObject::VSListObject(vs_size_t nitems) {
     this->type = T_LIST;
@@ -40,4 +40,39 @@ VSObject *vs_default_eq(VSObject *self, VSObject *const *args, vs_size_t nargs)
     }
 
     INCREF_RET(C_BOOL_TO_BOOL(self == args[0]));
-}
\ No newline at end of file
+}
+static vs_size_t slice_bound(VSObject *boundobj, vs_size_t len, vs_size_t none) {
+    if (boundobj->type == T_NONE) {
+        return none;
+    }
+    if (boundobj->type != T_INT) {
+        err("Can not slice with bound of type \"%s\".", TYPE_STR[boundobj->type]);
+        terminate(TERM_ERROR);
+    }
+
+    cint_t bound = INT_TO_C_INT(boundobj);
+    if (bound < 0) {
+        bound += len;
+    }
+    return bound < 0 ? 0 : (vs_size_t)bound > len ? len : (vs_size_t)bound;
+}
+
+void vs_slice_bounds(VSObject *startobj, VSObject *endobj, vs_size_t len, vs_size_t &start, vs_size_t &end) {
+    start = slice_bound(startobj, len, 0);
+    end = slice_bound(endobj, len, len);
+    if (end < start) {
+        end = start;
+    }
+}
+
+vs_size_t vs_capacity(VSObject *capacityobj, const char *func) {
+    if (capacityobj->type != T_INT) {
+        err("%s() takes an int as capacity, not \"%s\".", func, TYPE_STR[capacityobj->type]);
+        terminate(TERM_ERROR);
+    }
+    if (INT_TO_C_INT(capacityobj) < 0) {
+        err("negative capacity of %s(): %ld", func, INT_TO_C_INT(capacityobj));
+        terminate(TERM_ERROR);
+    }
+    return (vs_size_t)INT_TO_C_INT(capacityobj);
+}
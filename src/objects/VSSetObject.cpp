@@ -14,35 +14,68 @@ NEW_IDENTIFIER(len);
 NEW_IDENTIFIER(append);
 NEW_IDENTIFIER(has);
 NEW_IDENTIFIER(remove);
+NEW_IDENTIFIER(union);
+NEW_IDENTIFIER(intersection);
+NEW_IDENTIFIER(difference);
+NEW_IDENTIFIER(symmetric_difference);
+NEW_IDENTIFIER(issubset);
+NEW_IDENTIFIER(issuperset);
+NEW_IDENTIFIER(isdisjoint);
+NEW_IDENTIFIER(update);
+NEW_IDENTIFIER(intersection_update);
+NEW_IDENTIFIER(difference_update);
+NEW_IDENTIFIER(symmetric_difference_update);
+
+// methods of set that frozenset has too
+#define ENSURE_SET(obj, op)                                                   \
+    if (!IS_SET(obj)) {                                                       \
+        err("Can not apply \"" op "\" on type \"%s\".", TYPE_STR[obj->type]); \
+        terminate(TERM_ERROR);                                                \
+    }
+
+// set or frozenset of the items of obj, NULL if obj has no items to take.
+static VSSetObject *set_of(VSObject *obj, bool frozen) {
+    VSSetObject *set = new VSSetObject(frozen);
+    if (obj->type == T_TUPLE) {
+        set->_set.reserve(TUPLE_LEN(obj));
+        for (vs_size_t i = 0; i < TUPLE_LEN(obj); i++) {
+            SET_APPEND(set, TUPLE_GET(obj, i));
+        }
+    } else if (obj->type == T_LIST) {
+        set->_set.reserve(LIST_LEN(obj));
+        for (vs_size_t i = 0; i < LIST_LEN(obj); i++) {
+            SET_APPEND(set, LIST_GET(obj, i));
+        }
+    } else if (IS_SET(obj)) {
+        set->_set.reserve(SET_LEN(obj));
+        for (auto item : AS_SET(obj)->_set) {
+            set->_set.insert(item);
+            INCREF(item);
+        }
+    } else {
+        delete set;
+        return NULL;
+    }
+    return set;
+}
 
 VSObject *vs_set(VSObject *, VSObject *const *args, vs_size_t nargs) {
     if (nargs == 0) {
         INCREF_RET(new VSSetObject());
     } else if (nargs == 1) {
-        VSObject *obj = args[0];
-        if (obj->type == T_TUPLE) {
-            VSSetObject *set = new VSSetObject();
-            for (vs_size_t i = 0; i < TUPLE_LEN(obj); i++) {
-                SET_APPEND(set, TUPLE_GET(obj, i));
-            }
-            INCREF_RET(set);
-        } else if (obj->type == T_LIST) {
+        // set(capacity) has its buckets for that many items up front
+        if (IS_TYPE(args[0], T_INT)) {
             VSSetObject *set = new VSSetObject();
-            for (vs_size_t i = 0; i < LIST_LEN(obj); i++) {
-                SET_APPEND(set, LIST_GET(obj, i));
-            }
+            set->_set.reserve(vs_capacity(args[0], "set"));
             INCREF_RET(set);
-        } else if (obj->type == T_SET) {
-            VSSetObject *set = new VSSetObject();
-            VSSetObject *old = (VSSetObject *)obj;
-            for (auto item : old->_set) {
-                SET_APPEND(set, item);
-            }
-            INCREF_RET(set);
-        } else {
-            err("can not cast \"%s\" object to set", TYPE_STR[obj->type]);
+        }
+
+        VSSetObject *set = set_of(args[0], false);
+        if (set == NULL) {
+            err("can not cast \"%s\" object to set", TYPE_STR[args[0]->type]);
             INCREF_RET(VS_NONE);
         }
+        INCREF_RET(set);
     }
 
     ERR_NARGS("set()", 1, nargs);
@@ -50,15 +83,73 @@ VSObject *vs_set(VSObject *, VSObject *const *args, vs_size_t nargs) {
     return NULL;
 }
 
+VSObject *vs_frozenset(VSObject *, VSObject *const *args, vs_size_t nargs) {
+    if (nargs == 0) {
+        INCREF_RET(new VSSetObject(true));
+    } else if (nargs == 1) {
+        if (IS_TYPE(args[0], T_FROZENSET)) {
+            INCREF_RET(args[0]);
+        }
+        VSSetObject *set = set_of(args[0], true);
+        if (set == NULL) {
+            err("can not cast \"%s\" object to frozenset", TYPE_STR[args[0]->type]);
+            INCREF_RET(VS_NONE);
+        }
+        INCREF_RET(set);
+    }
+
+    ERR_NARGS("frozenset()", 1, nargs);
+    terminate(TERM_ERROR);
+    return NULL;
+}
+
+// the other operand of a set operation as a set, a new ref. Tuples and lists
+// are taken as the sets of their items.
+static VSSetObject *set_operand(VSObject *obj, const char *op) {
+    if (IS_SET(obj)) {
+        INCREF(obj);
+        return AS_SET(obj);
+    }
+
+    VSSetObject *set = set_of(obj, false);
+    if (set == NULL) {
+        err("Can not apply \"%s\" with \"%s\" object", op, TYPE_STR[obj->type]);
+        terminate(TERM_ERROR);
+    }
+    INCREF(set);
+    return set;
+}
+
+// true if each item of a is in b. Too large an a is not, before any lookup.
+static bool set_issubset(VSSetObject *a, VSSetObject *b) {
+    if (SET_LEN(a) > SET_LEN(b)) {
+        return false;
+    }
+    for (auto item : a->_set) {
+        if (!SET_HAS(b, item)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// erase item at iter from set and drop its ref, which may free it, so only
+// after the erase needs no more of it.
+static void set_erase(VSSetObject *set, decltype(set->_set)::iterator iter) {
+    VSObject *item = *iter;
+    set->_set.erase(iter);
+    DECREF(item);
+}
+
 VSObject *vs_set_str(VSObject *self, VSObject *const *, vs_size_t nargs) {
     if (nargs != 0) {
         ERR_NARGS("set.__str__()", 0, nargs);
         terminate(TERM_ERROR);
     }
 
-    ENSURE_TYPE(self, T_SET, "set.__str__()");
+    ENSURE_SET(self, "set.__str__()");
 
-    std::string set_str = "{";
+    std::string set_str = IS_TYPE(self, T_FROZENSET) ? "frozenset({" : "{";
     VSSetObject *set = (VSSetObject *)self;
     for (auto obj : set->_set) {
         VSObject *str = CALL_ATTR(obj, ID___str__, EMPTY_TUPLE());
@@ -70,7 +161,7 @@ VSObject *vs_set_str(VSObject *self, VSObject *const *, vs_size_t nargs) {
         set_str.pop_back();
         set_str.pop_back();
     }
-    set_str.append("}");
+    set_str.append(IS_TYPE(self, T_FROZENSET) ? "})" : "}");
 
     INCREF_RET(C_STRING_TO_STRING(set_str));
 }
@@ -81,7 +172,7 @@ VSObject *vs_set_bytes(VSObject *self, VSObject *const *, vs_size_t nargs) {
         terminate(TERM_ERROR);
     }
 
-    ENSURE_TYPE(self, T_SET, "set.__bytes__()");
+    ENSURE_SET(self, "set.__bytes__()");
 
     INCREF_RET(VS_NONE);
 }
@@ -92,15 +183,13 @@ VSObject *vs_set_copy(VSObject *self, VSObject *const *, vs_size_t nargs) {
         terminate(TERM_ERROR);
     }
 
-    ENSURE_TYPE(self, T_SET, "set.copy()");
+    ENSURE_SET(self, "set.copy()");
 
-    VSSetObject *set = (VSSetObject *)self;
-    VSSetObject *new_set = new VSSetObject();
-    for (auto item : set->_set) {
-        new_set->_set.insert(item);
-        INCREF(item);
+    // a frozenset never changes, it is its own copy
+    if (IS_TYPE(self, T_FROZENSET)) {
+        INCREF_RET(self);
     }
-    INCREF_RET(AS_OBJECT(new_set));
+    INCREF_RET(AS_OBJECT(set_of(self, false)));
 }
 
 VSObject *vs_set_clear(VSObject *self, VSObject *const *, vs_size_t nargs) {
@@ -125,7 +214,7 @@ VSObject *vs_set_len(VSObject *self, VSObject *const *, vs_size_t nargs) {
         terminate(TERM_ERROR);
     }
 
-    ENSURE_TYPE(self, T_SET, "set.len()");
+    ENSURE_SET(self, "set.len()");
 
     INCREF_RET(
         C_INT_TO_INT(
@@ -155,7 +244,7 @@ VSObject *vs_set_has(VSObject *self, VSObject *const *args, vs_size_t nargs) {
         terminate(TERM_ERROR);
     }
 
-    ENSURE_TYPE(self, T_SET, "set.has()");
+    ENSURE_SET(self, "set.has()");
 
     VSObject *item = args[0];
     VSSetObject *set = (VSSetObject *)self;
@@ -175,12 +264,303 @@ VSObject *vs_set_remove(VSObject *self, VSObject *const *args, vs_size_t nargs)
     VSSetObject *set = (VSSetObject *)self;
     auto iter = set->_set.find(item);
     if (iter != set->_set.end()) {
-        DECREF(*iter);
-        set->_set.erase(iter);
+        set_erase(set, iter);
     }
     INCREF_RET(VS_NONE);
 }
 
+VSObject *vs_set_union(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.union()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_SET(self, "set.union()");
+
+    VSSetObject *set = AS_SET(self);
+    VSSetObject *other = set_operand(args[0], "set.union()");
+    VSSetObject *res = new VSSetObject(IS_TYPE(self, T_FROZENSET));
+    res->_set.reserve(SET_LEN(set) + SET_LEN(other));
+    for (auto item : set->_set) {
+        res->_set.insert(item);
+        INCREF(item);
+    }
+    for (auto item : other->_set) {
+        SET_APPEND(res, item);
+    }
+    DECREF(other);
+    INCREF_RET(res);
+}
+
+VSObject *vs_set_intersection(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.intersection()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_SET(self, "set.intersection()");
+
+    // look the items of the smaller up in the larger
+    VSSetObject *other = set_operand(args[0], "set.intersection()");
+    VSSetObject *smaller = SET_LEN(self) <= SET_LEN(other) ? AS_SET(self) : other;
+    VSSetObject *larger = smaller == self ? other : AS_SET(self);
+    VSSetObject *res = new VSSetObject(IS_TYPE(self, T_FROZENSET));
+    res->_set.reserve(SET_LEN(smaller));
+    for (auto item : smaller->_set) {
+        if (SET_HAS(larger, item)) {
+            res->_set.insert(item);
+            INCREF(item);
+        }
+    }
+    DECREF(other);
+    INCREF_RET(res);
+}
+
+VSObject *vs_set_difference(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.difference()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_SET(self, "set.difference()");
+
+    VSSetObject *set = AS_SET(self);
+    VSSetObject *other = set_operand(args[0], "set.difference()");
+    VSSetObject *res = new VSSetObject(IS_TYPE(self, T_FROZENSET));
+    if (other != set) {
+        res->_set.reserve(SET_LEN(set));
+        for (auto item : set->_set) {
+            if (!SET_HAS(other, item)) {
+                res->_set.insert(item);
+                INCREF(item);
+            }
+        }
+    }
+    DECREF(other);
+    INCREF_RET(res);
+}
+
+VSObject *vs_set_symmetric_difference(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.symmetric_difference()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_SET(self, "set.symmetric_difference()");
+
+    VSSetObject *set = AS_SET(self);
+    VSSetObject *other = set_operand(args[0], "set.symmetric_difference()");
+    VSSetObject *res = new VSSetObject(IS_TYPE(self, T_FROZENSET));
+    if (other != set) {
+        res->_set.reserve(SET_LEN(set) + SET_LEN(other));
+        for (auto item : set->_set) {
+            if (!SET_HAS(other, item)) {
+                res->_set.insert(item);
+                INCREF(item);
+            }
+        }
+        for (auto item : other->_set) {
+            if (!SET_HAS(set, item)) {
+                res->_set.insert(item);
+                INCREF(item);
+            }
+        }
+    }
+    DECREF(other);
+    INCREF_RET(res);
+}
+
+VSObject *vs_set_issubset(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.issubset()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_SET(self, "set.issubset()");
+
+    VSSetObject *other = set_operand(args[0], "set.issubset()");
+    bool res = set_issubset(AS_SET(self), other);
+    DECREF(other);
+    INCREF_RET(C_BOOL_TO_BOOL(res));
+}
+
+VSObject *vs_set_issuperset(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.issuperset()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_SET(self, "set.issuperset()");
+
+    VSSetObject *other = set_operand(args[0], "set.issuperset()");
+    bool res = set_issubset(other, AS_SET(self));
+    DECREF(other);
+    INCREF_RET(C_BOOL_TO_BOOL(res));
+}
+
+VSObject *vs_set_isdisjoint(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.isdisjoint()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_SET(self, "set.isdisjoint()");
+
+    VSSetObject *other = set_operand(args[0], "set.isdisjoint()");
+    VSSetObject *smaller = SET_LEN(self) <= SET_LEN(other) ? AS_SET(self) : other;
+    VSSetObject *larger = smaller == self ? other : AS_SET(self);
+    bool res = true;
+    for (auto item : smaller->_set) {
+        if (SET_HAS(larger, item)) {
+            res = false;
+            break;
+        }
+    }
+    DECREF(other);
+    INCREF_RET(C_BOOL_TO_BOOL(res));
+}
+
+VSObject *vs_set_update(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.update()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_SET, "set.update()");
+
+    VSSetObject *set = AS_SET(self);
+    VSSetObject *other = set_operand(args[0], "set.update()");
+    if (other != set) {
+        set->_set.reserve(SET_LEN(set) + SET_LEN(other));
+        for (auto item : other->_set) {
+            SET_APPEND(set, item);
+        }
+    }
+    DECREF(other);
+    INCREF_RET(VS_NONE);
+}
+
+VSObject *vs_set_intersection_update(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.intersection_update()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_SET, "set.intersection_update()");
+
+    VSSetObject *set = AS_SET(self);
+    VSSetObject *other = set_operand(args[0], "set.intersection_update()");
+    if (SET_LEN(other) < SET_LEN(set)) {
+        // look the items of other up, keep what is found in a new table
+        decltype(set->_set) kept;
+        kept.reserve(SET_LEN(other));
+        for (auto item : other->_set) {
+            auto iter = set->_set.find(item);
+            if (iter != set->_set.end()) {
+                kept.insert(*iter);
+                INCREF(*iter);
+            }
+        }
+        set->_set.swap(kept);
+        for (auto item : kept) {
+            DECREF(item);
+        }
+    } else if (other != set) {
+        for (auto iter = set->_set.begin(); iter != set->_set.end();) {
+            auto next = std::next(iter);
+            if (!SET_HAS(other, *iter)) {
+                set_erase(set, iter);
+            }
+            iter = next;
+        }
+    }
+    DECREF(other);
+    INCREF_RET(VS_NONE);
+}
+
+VSObject *vs_set_difference_update(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.difference_update()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_SET, "set.difference_update()");
+
+    VSSetObject *set = AS_SET(self);
+    VSSetObject *other = set_operand(args[0], "set.difference_update()");
+    if (other == set) {
+        DECREF(vs_set_clear(self, NULL, 0));
+    } else if (SET_LEN(other) < SET_LEN(set)) {
+        for (auto item : other->_set) {
+            auto iter = set->_set.find(item);
+            if (iter != set->_set.end()) {
+                set_erase(set, iter);
+            }
+        }
+    } else {
+        for (auto iter = set->_set.begin(); iter != set->_set.end();) {
+            auto next = std::next(iter);
+            if (SET_HAS(other, *iter)) {
+                set_erase(set, iter);
+            }
+            iter = next;
+        }
+    }
+    DECREF(other);
+    INCREF_RET(VS_NONE);
+}
+
+VSObject *vs_set_symmetric_difference_update(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("set.symmetric_difference_update()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_SET, "set.symmetric_difference_update()");
+
+    VSSetObject *set = AS_SET(self);
+    VSSetObject *other = set_operand(args[0], "set.symmetric_difference_update()");
+    if (other == set) {
+        DECREF(vs_set_clear(self, NULL, 0));
+    } else {
+        set->_set.reserve(SET_LEN(set) + SET_LEN(other));
+        for (auto item : other->_set) {
+            auto iter = set->_set.find(item);
+            if (iter != set->_set.end()) {
+                set_erase(set, iter);
+            } else {
+                set->_set.insert(item);
+                INCREF(item);
+            }
+        }
+    }
+    DECREF(other);
+    INCREF_RET(VS_NONE);
+}
+
+VSObject *vs_frozenset_hash(VSObject *self, VSObject *const *, vs_size_t nargs) {
+    if (nargs != 0) {
+        ERR_NARGS("frozenset.__hash__()", 0, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_FROZENSET, "frozenset.__hash__()");
+
+    INCREF_RET(C_INT_TO_INT((cint_t)AS_SET(self)->hash()));
+}
+
+VSObject *vs_frozenset_eq(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 1) {
+        ERR_NARGS("frozenset.__eq__()", 1, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_FROZENSET, "frozenset.__eq__()");
+
+    VSObject *that = args[0];
+    INCREF_RET(C_BOOL_TO_BOOL(IS_SET(that) && AS_SET(self)->equals(AS_SET(that))));
+}
+
 const str_func_map VSSetObject::vs_set_methods = {
     {ID___hash__, vs_default_hash},
     {ID___eq__, vs_default_eq},
@@ -191,31 +571,90 @@ const str_func_map VSSetObject::vs_set_methods = {
     {ID_len, vs_set_len},
     {ID_append, vs_set_append},
     {ID_has, vs_set_has},
-    {ID_remove, vs_set_remove}
+    {ID_remove, vs_set_remove},
+    {ID_union, vs_set_union},
+    {ID_intersection, vs_set_intersection},
+    {ID_difference, vs_set_difference},
+    {ID_symmetric_difference, vs_set_symmetric_difference},
+    {ID_issubset, vs_set_issubset},
+    {ID_issuperset, vs_set_issuperset},
+    {ID_isdisjoint, vs_set_isdisjoint},
+    {ID_update, vs_set_update},
+    {ID_intersection_update, vs_set_intersection_update},
+    {ID_difference_update, vs_set_difference_update},
+    {ID_symmetric_difference_update, vs_set_symmetric_difference_update}
+};
+
+const str_func_map VSSetObject::vs_frozenset_methods = {
+    {ID___hash__, vs_frozenset_hash},
+    {ID___eq__, vs_frozenset_eq},
+    {ID___str__, vs_set_str},
+    {ID___bytes__, vs_set_bytes},
+    {ID_copy, vs_set_copy},
+    {ID_len, vs_set_len},
+    {ID_has, vs_set_has},
+    {ID_union, vs_set_union},
+    {ID_intersection, vs_set_intersection},
+    {ID_difference, vs_set_difference},
+    {ID_symmetric_difference, vs_set_symmetric_difference},
+    {ID_issubset, vs_set_issubset},
+    {ID_issuperset, vs_set_issuperset},
+    {ID_isdisjoint, vs_set_isdisjoint}
 };
 
-VSSetObject::VSSetObject() {
-    this->type = T_SET;
+VSSetObject::VSSetObject(bool frozen) {
+    this->type = frozen ? T_FROZENSET : T_SET;
     this->_set = std::unordered_set<VSObject *, __set_hash__, __set_equal_to__>();
+    this->hashed = false;
 }
 
 VSSetObject::~VSSetObject() {
-    DECREF(vs_set_clear(this, NULL, 0));
+    for (auto item : this->_set) {
+        DECREF(item);
+    }
+}
+
+std::size_t VSSetObject::hash() {
+    if (!this->hashed) {
+        // xor does not depend on the order of the items, shuffle the bits of
+        // each hash first so that close hashes do not cancel out
+        std::size_t h = SET_LEN(this) * 1927868237UL;
+        auto item_hash = this->_set.hash_function();
+        for (auto item : this->_set) {
+            std::size_t ih = item_hash(item);
+            h ^= (ih ^ (ih << 16) ^ 89869747UL) * 3644798167UL;
+        }
+        this->_hash = h;
+        this->hashed = true;
+    }
+    return this->_hash;
+}
+
+bool VSSetObject::equals(VSSetObject *that) {
+    if (this == that) {
+        return true;
+    }
+    if (SET_LEN(this) != SET_LEN(that) || (this->hashed && that->hashed && this->_hash != that->_hash)) {
+        return false;
+    }
+    return set_issubset(this, that);
 }
 
 bool VSSetObject::hasattr(std::string &attrname) {
-    return vs_set_methods.find(attrname) != vs_set_methods.end();
+    auto &methods = this->type == T_FROZENSET ? vs_frozenset_methods : vs_set_methods;
+    return methods.find(attrname) != methods.end();
 }
 
 VSObject *VSSetObject::getattr(std::string &attrname) {
-    auto iter = vs_set_methods.find(attrname);
-    if (iter == vs_set_methods.end()) {
+    auto &methods = this->type == T_FROZENSET ? vs_frozenset_methods : vs_set_methods;
+    auto iter = methods.find(attrname);
+    if (iter == methods.end()) {
         ERR_NO_ATTR(this, attrname);
         terminate(TERM_ERROR);
     }
 
     VSFunctionObject *attr = new VSNativeFunctionObject(
-        this, C_STRING_TO_STRING(attrname), vs_set_methods.at(attrname));
+        this, C_STRING_TO_STRING(attrname), iter->second);
     INCREF_RET(attr);
 }
 
@@ -2,6 +2,8 @@
 
 #include <errno.h>
 
+#include <algorithm>
+
 #include "error.hpp"
 #include "objects/VSBoolObject.hpp"
 #include "objects/VSCharObject.hpp"
@@ -9,6 +11,7 @@
 #include "objects/VSFunctionObject.hpp"
 #include "objects/VSIntObject.hpp"
 #include "objects/VSListObject.hpp"
+#include "objects/VSStringSearch.hpp"
 #include "objects/VSTupleObject.hpp"
 
 NEW_IDENTIFIER(__hash__);
@@ -36,6 +39,7 @@ NEW_IDENTIFIER(remove);
 NEW_IDENTIFIER(remove_at);
 NEW_IDENTIFIER(split);
 NEW_IDENTIFIER(substr);
+NEW_IDENTIFIER(slice);
 NEW_IDENTIFIER(locate);
 
 VSObject *vs_str(VSObject *, VSObject *const *args, vs_size_t nargs) {
@@ -65,8 +69,7 @@ VSObject *vs_string_hash(VSObject *self, VSObject *const *, vs_size_t nargs) {
 
     ENSURE_TYPE(self, T_STR, "str.__hash__()");
 
-    std::size_t hash = std::hash<std::string>{}(((VSStringObject *)self)->_value);
-    INCREF_RET(C_INT_TO_INT(hash));
+    INCREF_RET(C_INT_TO_INT(AS_STRING(self)->hash()));
 }
 
 VSObject *vs_string_lt(VSObject *self, VSObject *const *args, vs_size_t nargs) {
@@ -79,7 +82,7 @@ VSObject *vs_string_lt(VSObject *self, VSObject *const *args, vs_size_t nargs) {
     ENSURE_TYPE(self, T_STR, "str.__lt__()");
     ENSURE_TYPE(that, T_STR, "str.__lt__()");
 
-    cbool_t res = ((VSStringObject *)self)->_value < ((VSStringObject *)that)->_value;
+    cbool_t res = STRING_VIEW(self) < STRING_VIEW(that);
     INCREF_RET(res ? VS_TRUE : VS_FALSE);
 }
 
@@ -93,7 +96,7 @@ VSObject *vs_string_gt(VSObject *self, VSObject *const *args, vs_size_t nargs) {
     ENSURE_TYPE(self, T_STR, "str.__gt__()");
     ENSURE_TYPE(that, T_STR, "str.__gt__()");
 
-    cbool_t res = ((VSStringObject *)self)->_value > ((VSStringObject *)that)->_value;
+    cbool_t res = STRING_VIEW(self) > STRING_VIEW(that);
     INCREF_RET(res ? VS_TRUE : VS_FALSE);
 }
 
@@ -107,7 +110,7 @@ VSObject *vs_string_le(VSObject *self, VSObject *const *args, vs_size_t nargs) {
     ENSURE_TYPE(self, T_STR, "str.__le__()");
     ENSURE_TYPE(that, T_STR, "str.__le__()");
 
-    cbool_t res = ((VSStringObject *)self)->_value <= ((VSStringObject *)that)->_value;
+    cbool_t res = STRING_VIEW(self) <= STRING_VIEW(that);
     INCREF_RET(res ? VS_TRUE : VS_FALSE);
 }
 
@@ -121,7 +124,7 @@ VSObject *vs_string_ge(VSObject *self, VSObject *const *args, vs_size_t nargs) {
     ENSURE_TYPE(self, T_STR, "str.__ge__()");
     ENSURE_TYPE(that, T_STR, "str.__ge__()");
 
-    cbool_t res = ((VSStringObject *)self)->_value >= ((VSStringObject *)that)->_value;
+    cbool_t res = STRING_VIEW(self) >= STRING_VIEW(that);
     INCREF_RET(res ? VS_TRUE : VS_FALSE);
 }
 
@@ -135,7 +138,7 @@ VSObject *vs_string_eq(VSObject *self, VSObject *const *args, vs_size_t nargs) {
     ENSURE_TYPE(self, T_STR, "str.__eq__()");
     ENSURE_TYPE(that, T_STR, "str.__eq__()");
 
-    cbool_t res = ((VSStringObject *)self)->_value == ((VSStringObject *)that)->_value;
+    cbool_t res = AS_STRING(self)->equals(AS_STRING(that));
     INCREF_RET(res ? VS_TRUE : VS_FALSE);
 }
 
@@ -147,8 +150,7 @@ VSObject *vs_string_str(VSObject *self, VSObject *const *, vs_size_t nargs) {
 
     ENSURE_TYPE(self, T_STR, "str.__str__()");
 
-    std::string &str_val = STRING_TO_C_STRING(self);
-    INCREF_RET(C_STRING_TO_STRING(str_val));
+    INCREF_RET(C_STRING_TO_STRING(std::string(STRING_VIEW(self))));
 }
 
 VSObject *vs_string_bytes(VSObject *self, VSObject *const *, vs_size_t nargs) {
@@ -172,8 +174,7 @@ VSObject *vs_string_add(VSObject *self, VSObject *const *args, vs_size_t nargs)
     ENSURE_TYPE(self, T_STR, "str.__add__()");
     ENSURE_TYPE(that, T_STR, "str.__add__()");
 
-    std::string res = ((VSStringObject *)self)->_value + ((VSStringObject *)that)->_value;
-    INCREF_RET(C_STRING_TO_STRING(res));
+    INCREF_RET(((VSStringObject *)self)->concat((VSStringObject *)that));
 }
 
 VSObject *vs_string_bool(VSObject *self, VSObject *const *, vs_size_t nargs) {
@@ -197,7 +198,7 @@ VSObject *vs_string_char(VSObject *self, VSObject *const *, vs_size_t nargs) {
     ENSURE_TYPE(self, T_STR, "str.__char__()");
 
     VSStringObject *str = (VSStringObject *)self;
-    vs_size_t len = str->_value.length();
+    vs_size_t len = STRING_LEN(str);
     if (len == 0) {
         INCREF_RET(
             C_CHAR_TO_CHAR(
@@ -205,10 +206,10 @@ VSObject *vs_string_char(VSObject *self, VSObject *const *, vs_size_t nargs) {
     } else if (len == 1) {
         INCREF_RET(
             C_CHAR_TO_CHAR(
-                (cchar_t)str->_value[0]));
+                (cchar_t)STRING_GET(str, 0)));
     }
 
-    err("Can not cast string \"%s\" to char", str->_value.c_str());
+    err("Can not cast string \"%s\" to char", str->value().c_str());
     terminate(TERM_ERROR);
     INCREF_RET(VS_NONE);
 }
@@ -235,15 +236,15 @@ VSObject *vs_string_int(VSObject *self, VSObject *const *args, vs_size_t nargs)
 
     char *end = NULL;
     VSStringObject *str = (VSStringObject *)self;
-    cint_t val = std::strtoll(str->_value.c_str(), &end, base);
+    cint_t val = std::strtoll(str->value().c_str(), &end, base);
 
     if (errno == ERANGE) {
-        err("literal out of range of int: \"%s\" in str.__int__()", str->_value.c_str());
+        err("literal out of range of int: \"%s\" in str.__int__()", str->value().c_str());
         terminate(TERM_ERROR);
     }
 
-    if (end - 1 != &(str->_value.back())) {
-        err("invalid literal: \"%s\" in str.__int__()", str->_value.c_str());
+    if (end - 1 != &(str->value().back())) {
+        err("invalid literal: \"%s\" in str.__int__()", str->value().c_str());
         terminate(TERM_ERROR);
     }
 
@@ -260,16 +261,16 @@ VSObject *vs_string_float(VSObject *self, VSObject *const *, vs_size_t nargs) {
 
     char *end = NULL;
     VSStringObject *str = (VSStringObject *)self;
-    cfloat_t val = std::strtold(str->_value.c_str(), &end);
+    cfloat_t val = std::strtold(str->value().c_str(), &end);
 
     if (errno == ERANGE) {
         errno = 0;
-        err("literal out of range of float: \"%s\" in str.__float__()", str->_value.c_str());
+        err("literal out of range of float: \"%s\" in str.__float__()", str->value().c_str());
         terminate(TERM_ERROR);
     }
 
-    if (end - 1 != &(str->_value.back())) {
-        err("invalid literal: \"%s\" in str.__float__()", str->_value.c_str());
+    if (end - 1 != &(str->value().back())) {
+        err("invalid literal: \"%s\" in str.__float__()", str->value().c_str());
         terminate(TERM_ERROR);
     }
 
@@ -284,7 +285,7 @@ VSObject *vs_string_copy(VSObject *self, VSObject *const *, vs_size_t nargs) {
 
     ENSURE_TYPE(self, T_STR, "str.copy()");
 
-    VSStringObject *new_str = new VSStringObject(STRING_TO_C_STRING(self));
+    VSStringObject *new_str = new VSStringObject(std::string(STRING_VIEW(self)));
     INCREF_RET(new_str);
 }
 
@@ -296,7 +297,7 @@ VSObject *vs_string_clear(VSObject *self, VSObject *const *, vs_size_t nargs) {
 
     ENSURE_TYPE(self, T_STR, "str.clear()");
 
-    ((VSStringObject *)self)->_value.clear();
+    STRING_TO_C_STRING(self).clear();
     INCREF_RET(VS_NONE);
 }
 
@@ -310,7 +311,7 @@ VSObject *vs_string_len(VSObject *self, VSObject *const *, vs_size_t nargs) {
 
     INCREF_RET(
         C_INT_TO_INT(
-            ((VSStringObject *)self)->_value.length()));
+            STRING_LEN(self)));
 }
 
 VSObject *vs_string_get(VSObject *self, VSObject *const *args, vs_size_t nargs) {
@@ -326,12 +327,12 @@ VSObject *vs_string_get(VSObject *self, VSObject *const *args, vs_size_t nargs)
     VSStringObject *str = (VSStringObject *)self;
     vs_size_t idx = (vs_size_t)INT_TO_C_INT(idxobj);
 
-    if (idx >= str->_value.size()) {
-        INDEX_OUT_OF_BOUND(idx, str->_value.size());
+    if (idx >= STRING_LEN(str)) {
+        INDEX_OUT_OF_BOUND(idx, STRING_LEN(str));
         terminate(TERM_ERROR);
     }
 
-    INCREF_RET(C_CHAR_TO_CHAR(str->_value.at(idx)));
+    INCREF_RET(C_CHAR_TO_CHAR(STRING_GET(str, idx)));
 }
 
 VSObject *vs_string_set(VSObject *self, VSObject *const *args, vs_size_t nargs) {
@@ -350,12 +351,12 @@ VSObject *vs_string_set(VSObject *self, VSObject *const *args, vs_size_t nargs)
     vs_size_t idx = (vs_size_t)INT_TO_C_INT(idxobj);
     cchar_t char_val = CHAR_TO_C_CHAR(charobj);
 
-    if (idx >= str->_value.size()) {
-        INDEX_OUT_OF_BOUND(idx, str->_value.size());
+    if (idx >= STRING_LEN(str)) {
+        INDEX_OUT_OF_BOUND(idx, STRING_LEN(str));
         terminate(TERM_ERROR);
     }
 
-    str->_value[idx] = char_val;
+    STRING_SET(str, idx, char_val);
     INCREF_RET(VS_NONE);
 }
 
@@ -372,7 +373,7 @@ VSObject *vs_string_append(VSObject *self, VSObject *const *args, vs_size_t narg
     VSStringObject *str = (VSStringObject *)self;
     char char_val = CHAR_TO_C_CHAR(charobj);
 
-    str->_value.push_back(char_val);
+    STRING_APPEND(str, char_val);
     INCREF_RET(VS_NONE);
 }
 
@@ -389,7 +390,7 @@ VSObject *vs_string_has(VSObject *self, VSObject *const *args, vs_size_t nargs)
     VSStringObject *str = (VSStringObject *)self;
     char char_val = CHAR_TO_C_CHAR(charobj);
 
-    if (str->_value.find(char_val) != str->_value.npos) {
+    if (vs_str_find(STRING_VIEW(str), std::string_view(&char_val, 1)) != std::string_view::npos) {
         INCREF_RET(VS_TRUE);
     }
     INCREF_RET(VS_FALSE);
@@ -408,7 +409,7 @@ VSObject *vs_string_has_at(VSObject *self, VSObject *const *args, vs_size_t narg
     VSStringObject *str = (VSStringObject *)self;
     vs_size_t idx = (vs_size_t)INT_TO_C_INT(idxobj);
 
-    INCREF_RET(idx < str->_value.size() ? VS_FALSE : VS_TRUE);
+    INCREF_RET(idx < STRING_LEN(str) ? VS_FALSE : VS_TRUE);
 }
 
 VSObject *vs_string_remove(VSObject *self, VSObject *const *args, vs_size_t nargs) {
@@ -424,10 +425,11 @@ VSObject *vs_string_remove(VSObject *self, VSObject *const *args, vs_size_t narg
     VSStringObject *str = (VSStringObject *)self;
     char char_val = CHAR_TO_C_CHAR(charobj);
 
-    std::size_t idx = str->_value.find_first_of(char_val);
-    while (idx != str->_value.npos) {
-        str->_value.erase(idx, 1);
-        idx = str->_value.find_first_of(char_val, idx);
+    // chars after the first char_val move back over those removed, once
+    std::size_t idx = vs_str_find(STRING_VIEW(str), std::string_view(&char_val, 1));
+    if (idx != std::string_view::npos) {
+        std::string &value = str->value();
+        value.erase(std::remove(value.begin() + idx, value.end(), char_val), value.end());
     }
     INCREF_RET(VS_NONE);
 }
@@ -445,12 +447,12 @@ VSObject *vs_string_remove_at(VSObject *self, VSObject *const *args, vs_size_t n
     VSStringObject *str = (VSStringObject *)self;
     vs_size_t idx = (vs_size_t)INT_TO_C_INT(idxobj);
 
-    if (idx >= str->_value.size()) {
-        INDEX_OUT_OF_BOUND(idx, str->_value.size());
+    if (idx >= STRING_LEN(str)) {
+        INDEX_OUT_OF_BOUND(idx, STRING_LEN(str));
         terminate(TERM_ERROR);
     }
 
-    str->_value.erase(idx, 1);
+    str->value().erase(idx, 1);
     INCREF_RET(VS_NONE);
 }
 
@@ -464,22 +466,27 @@ VSObject *vs_string_split(VSObject *self, VSObject *const *args, vs_size_t nargs
     ENSURE_TYPE(self, T_STR, "str.split()");
     ENSURE_TYPE(sepobj, T_STR, "as seperator of str.split()");
 
-    std::string &str = ((VSStringObject *)self)->_value;
-    std::string &sep = ((VSStringObject *)sepobj)->_value;
-
-    std::size_t sep_len = sep.length();
-    std::size_t start = 0, end = str.find(sep, start);
+    std::string_view str = STRING_VIEW(self);
+    std::string_view sep = STRING_VIEW(sepobj);
+    if (sep.empty()) {
+        err("empty seperator of str.split()");
+        terminate(TERM_ERROR);
+    }
 
+    // pieces go straight into the items, searched for in one pass
     VSListObject *res = new VSListObject(0);
-    while (end != str.npos)
-    {
-        LIST_APPEND(res, C_STRING_TO_STRING(str.substr(start, end - start)));
-        start = end + sep_len;
-        end = str.find(sep, start);
+    std::vector<VSObject *> &items = res->items;
+    std::size_t start = 0, end = vs_str_find(str, sep);
+    while (end != std::string_view::npos) {
+        items.push_back(new VSStringObject(std::string(str.substr(start, end - start))));
+        start = end + sep.length();
+        end = vs_str_find(str, sep, start);
     }
-    
     if (start < str.length()) {
-        LIST_APPEND(res, C_STRING_TO_STRING(str.substr(start, str.length() - start)));
+        items.push_back(new VSStringObject(std::string(str.substr(start))));
+    }
+    for (auto item : items) {
+        INCREF(item);
     }
 
     INCREF_RET(res);
@@ -497,11 +504,11 @@ VSObject *vs_string_substr(VSObject *self, VSObject *const *args, vs_size_t narg
     ENSURE_TYPE(startobj, T_INT, "as start pos of str.substr()");
     ENSURE_TYPE(lengthobj, T_INT, "as length of str.substr()");
 
-    std::string &str = ((VSStringObject *)self)->_value;
+    VSStringObject *str = (VSStringObject *)self;
     cint_t start = ((VSIntObject *)startobj)->_value;
     cint_t length = ((VSIntObject *)lengthobj)->_value;
 
-    if (start < 0 || ((size_t)start) >= str.length()) {
+    if (start < 0 || ((size_t)start) >= STRING_LEN(str)) {
         err("invalid substr start pos: %lld in str.substr()", start);
         terminate(TERM_ERROR);
     }
@@ -511,7 +518,21 @@ VSObject *vs_string_substr(VSObject *self, VSObject *const *args, vs_size_t narg
         terminate(TERM_ERROR);
     }
 
-    INCREF_RET(C_STRING_TO_STRING(str.substr(start, length)));
+    INCREF_RET(str->slice(start, std::min((vs_size_t)(start + length), (vs_size_t)STRING_LEN(str))));
+}
+
+VSObject *vs_string_slice(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 2) {
+        ERR_NARGS("str.slice()", 2, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_STR, "str.slice()");
+
+    VSStringObject *str = (VSStringObject *)self;
+    vs_size_t start, end;
+    vs_slice_bounds(args[0], args[1], STRING_LEN(str), start, end);
+    INCREF_RET(str->slice(start, end));
 }
 
 VSObject *vs_string_locate(VSObject *self, VSObject *const *args, vs_size_t nargs) {
@@ -524,13 +545,12 @@ VSObject *vs_string_locate(VSObject *self, VSObject *const *args, vs_size_t narg
     ENSURE_TYPE(self, T_STR, "str.locate()");
 
     cint_t pos = -1;
-    std::string &str = ((VSStringObject *)self)->_value;
+    std::string_view str = STRING_VIEW(self);
     if (contentobj->type == T_CHAR) {
         cchar_t char_val = ((VSCharObject *)contentobj)->_value;
-        pos = str.find(char_val);
+        pos = vs_str_find(str, std::string_view(&char_val, 1));
     } else if (contentobj->type == T_STR) {
-        std::string &str_val = ((VSStringObject *)contentobj)->_value;
-        pos = str.find(str_val);
+        pos = vs_str_find(str, STRING_VIEW(contentobj));
     } else {
         err("Can not apply \"as string content\" on type \"%s\".", TYPE_STR[contentobj->type]); 
         terminate(TERM_ERROR);   
@@ -566,17 +586,103 @@ const str_func_map VSStringObject::vs_str_methods = {
     {ID_remove_at, vs_string_remove_at},
     {ID_split, vs_string_split},
     {ID_substr, vs_string_substr},
+    {ID_slice, vs_string_slice},
     {ID_locate, vs_string_locate}
 };
 
 VSStringObject::VSStringObject(std::string value) {
     this->type = T_STR;
-    this->_value = value;
+    this->_value = std::move(value);
+    this->start = 0;
+    this->length = 0;
+    this->hashed = false;
+}
+
+VSStringObject::VSStringObject(std::shared_ptr<std::string> buffer, vs_size_t start, vs_size_t length) {
+    this->type = T_STR;
+    this->buffer = buffer;
+    this->start = start;
+    this->length = length;
+    this->hashed = false;
 }
 
 VSStringObject::~VSStringObject() {
 }
 
+std::string &VSStringObject::value() {
+    this->hashed = false;
+    if (this->buffer != NULL) {
+        this->_value.assign(*this->buffer, this->start, this->length);
+        this->buffer.reset();
+    }
+    return this->_value;
+}
+
+std::string_view VSStringObject::view() {
+    if (this->buffer != NULL) {
+        return std::string_view(this->buffer->data() + this->start, this->length);
+    }
+    return this->_value;
+}
+
+VSStringObject *VSStringObject::slice(vs_size_t start, vs_size_t end) {
+    if (this->buffer != NULL) {
+        return new VSStringObject(this->buffer, this->start + start, end - start);
+    }
+
+    // the chars of the slice are copied once, its slices share them
+    auto buffer = std::make_shared<std::string>(this->_value, start, end - start);
+    return new VSStringObject(buffer, 0, end - start);
+}
+
+VSStringObject *VSStringObject::concat(VSStringObject *that) {
+    std::string_view tail = that->view();
+    if (this->buffer == NULL || this->start + this->length != this->buffer->length()) {
+        // the chars are copied once, later concatenations append to them
+        auto buffer = std::make_shared<std::string>(this->view());
+        buffer->append(tail);
+        return new VSStringObject(buffer, 0, buffer->length());
+    }
+
+    // tail may be in the buffer, which append handles
+    this->buffer->append(tail.data(), tail.length());
+    return new VSStringObject(this->buffer, this->start, this->length + tail.length());
+}
+
+void VSStringObject::extend(VSStringObject *that) {
+    this->hashed = false;
+    if (this->buffer != NULL && this->start + this->length == this->buffer->length()) {
+        std::string_view tail = that->view();
+        this->buffer->append(tail.data(), tail.length());
+        this->length += tail.length();
+        return;
+    }
+
+    std::string &value = this->value();
+    std::string_view tail = that->view();
+    value.append(tail.data(), tail.length());
+}
+
+std::size_t VSStringObject::hash() {
+    if (!this->hashed) {
+        this->_hash = std::hash<std::string_view>{}(this->view());
+        this->hashed = true;
+    }
+    return this->_hash;
+}
+
+bool VSStringObject::equals(VSStringObject *that) {
+    if (this == that) {
+        return true;
+    }
+
+    std::string_view a = this->view(), b = that->view();
+    if (a.length() != b.length() || (this->hashed && that->hashed && this->_hash != that->_hash)) {
+        return false;
+    }
+    return a == b;
+}
+
 bool VSStringObject::hasattr(std::string &attrname) {
     return vs_str_methods.find(attrname) != vs_str_methods.end();
 }
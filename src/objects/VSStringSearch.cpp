@@ -0,0 +1,99 @@
+#include "objects/VSStringSearch.hpp"
+
+#include <string.h>
+
+#if defined(__x86_64__)
+#include <emmintrin.h>
+#endif
+
+// candidates at i have the first and last chars of needle, check the rest.
+static inline bool match_at(const char *haystack, std::size_t i, const char *needle, std::size_t k) {
+    return memcmp(haystack + i + 1, needle + 1, k - 2) == 0;
+}
+
+static std::size_t scalar_filter(const char *haystack, std::size_t n, const char *needle, std::size_t k, std::size_t i) {
+    char first = needle[0], last = needle[k - 1];
+    for (; i + k <= n; i++) {
+        if (haystack[i] == first && haystack[i + k - 1] == last && match_at(haystack, i, needle, k)) {
+            return i;
+        }
+    }
+    return std::string_view::npos;
+}
+
+#if defined(__x86_64__)
+
+// compare 16 positions at a time against the first and last chars of needle,
+// only positions matching both are compared in full.
+std::size_t vs_str_find_filter(const char *haystack, std::size_t n, const char *needle, std::size_t k) {
+    const __m128i first = _mm_set1_epi8(needle[0]);
+    const __m128i last = _mm_set1_epi8(needle[k - 1]);
+
+    std::size_t i = 0;
+    for (; i + k - 1 + 16 <= n; i += 16) {
+        __m128i block_first = _mm_loadu_si128((const __m128i *)(haystack + i));
+        __m128i block_last = _mm_loadu_si128((const __m128i *)(haystack + i + k - 1));
+        __m128i eq = _mm_and_si128(_mm_cmpeq_epi8(block_first, first), _mm_cmpeq_epi8(block_last, last));
+        unsigned mask = _mm_movemask_epi8(eq);
+        while (mask != 0) {
+            std::size_t pos = i + __builtin_ctz(mask);
+            if (match_at(haystack, pos, needle, k)) {
+                return pos;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return scalar_filter(haystack, n, needle, k, i);
+}
+
+#else
+
+std::size_t vs_str_find_filter(const char *haystack, std::size_t n, const char *needle, std::size_t k) {
+    return scalar_filter(haystack, n, needle, k, 0);
+}
+
+#endif
+
+// skip by the distance from the char under the end of needle to its last
+// occurrence in needle, which long needles make long.
+std::size_t vs_str_find_horspool(const char *haystack, std::size_t n, const char *needle, std::size_t k) {
+    std::size_t skip[256];
+    for (std::size_t c = 0; c < 256; c++) {
+        skip[c] = k;
+    }
+    for (std::size_t i = 0; i < k - 1; i++) {
+        skip[(unsigned char)needle[i]] = k - 1 - i;
+    }
+
+    char last = needle[k - 1];
+    for (std::size_t i = 0; i + k <= n;) {
+        char c = haystack[i + k - 1];
+        if (c == last && memcmp(haystack + i, needle, k - 1) == 0) {
+            return i;
+        }
+        i += skip[(unsigned char)c];
+    }
+    return std::string_view::npos;
+}
+
+std::size_t vs_str_find(std::string_view haystack, std::string_view needle, std::size_t from) {
+    std::size_t n = haystack.length(), k = needle.length();
+    if (from > n || k > n - from) {
+        return std::string_view::npos;
+    }
+    if (k == 0) {
+        return from;
+    }
+
+    const char *start = haystack.data() + from;
+    std::size_t pos;
+    if (k == 1) {
+        const char *found = (const char *)memchr(start, needle[0], n - from);
+        return found == NULL ? std::string_view::npos : found - haystack.data();
+    } else if (k < VS_SEARCH_LONG_NEEDLE) {
+        pos = vs_str_find_filter(start, n - from, needle.data(), k);
+    } else {
+        pos = vs_str_find_horspool(start, n - from, needle.data(), k);
+    }
+    return pos == std::string_view::npos ? pos : pos + from;
+}
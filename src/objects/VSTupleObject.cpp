@@ -21,6 +21,7 @@ NEW_IDENTIFIER(copy);
 NEW_IDENTIFIER(len);
 NEW_IDENTIFIER(get);
 NEW_IDENTIFIER(has_at);
+NEW_IDENTIFIER(slice);
 
 VSTupleObject *VSTupleObject::_EMPTY_TUPLE = NULL;
 
@@ -33,7 +34,7 @@ VSObject *vs_tuple(VSObject *, VSObject *const *args, vs_size_t nargs) {
             INCREF_RET(obj);
         } else if (obj->type == T_LIST) {
             return vs_list_to_tuple(obj);
-        } else if (obj->type == T_SET) {
+        } else if (IS_SET(obj)) {
             int i = 0;
             VSSetObject *set = (VSSetObject *)obj;
             VSTupleObject *tuple = new VSTupleObject(set->_set.size());
@@ -169,6 +170,26 @@ VSObject *vs_tuple_get(VSObject *self, VSObject *const *args, vs_size_t nargs) {
     INCREF_RET(tuple->items[idx]);
 }
 
+VSObject *vs_tuple_slice(VSObject *self, VSObject *const *args, vs_size_t nargs) {
+    if (nargs != 2) {
+        ERR_NARGS("tuple.slice()", 2, nargs);
+        terminate(TERM_ERROR);
+    }
+
+    ENSURE_TYPE(self, T_TUPLE, "tuple.slice()");
+
+    VSTupleObject *tuple = (VSTupleObject *)self;
+    vs_size_t start, end;
+    vs_slice_bounds(args[0], args[1], tuple->nitems, start, end);
+    if (start == end) {
+        return EMPTY_TUPLE();
+    }
+
+    // slices of a slice share the items of the tuple it is taken from
+    VSTupleObject *base = tuple->base == NULL ? tuple : tuple->base;
+    INCREF_RET(new VSTupleObject(base, tuple->items - base->items + start, end - start));
+}
+
 // TODO: implement tuple.__has__()
 VSObject *vs_tuple_has(VSObject *self, VSObject *const *, vs_size_t nargs) {
     if (nargs != 1) {
@@ -256,11 +277,13 @@ const str_func_map VSTupleObject::vs_tuple_methods = {
     {ID_copy, vs_tuple_copy},
     {ID_len, vs_tuple_len},
     {ID_get, vs_tuple_get},
-    {ID_has_at, vs_tuple_has_at}};
+    {ID_has_at, vs_tuple_has_at},
+    {ID_slice, vs_tuple_slice}};
 
 VSTupleObject::VSTupleObject(vs_size_t nitems) {
     this->type = T_TUPLE;
     this->nitems = nitems;
+    this->base = NULL;
 
     size_t size = sizeof(VSObject *) * nitems;
     this->items = (VSObject **)malloc(size);
@@ -271,7 +294,20 @@ VSTupleObject::VSTupleObject(vs_size_t nitems) {
     memset(this->items, 0, size);
 }
 
+VSTupleObject::VSTupleObject(VSTupleObject *base, vs_size_t start, vs_size_t nitems) {
+    this->type = T_TUPLE;
+    this->nitems = nitems;
+    this->items = base->items + start;
+    this->base = base;
+    INCREF(base);
+}
+
 VSTupleObject::~VSTupleObject() {
+    if (this->base != NULL) {
+        DECREF(this->base);
+        return;
+    }
+
     for (vs_size_t i = 0; i < this->nitems; i++) {
         DECREF(this->items[i]);
     }
@@ -0,0 +1,408 @@
+#include "runtime/VSJit.hpp"
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <vector>
+
+#include "runtime/VSAssembler.hpp"
+#include "runtime/VSOps.hpp"
+#include "runtime/VSTrace.hpp"
+
+bool vs_jit_enabled = true;
+
+static FILE *perf_map = NULL;
+
+void vs_jit_perf_map(bool enabled) {
+    if (!enabled || perf_map != NULL) {
+        return;
+    }
+
+    char path[64];
+    snprintf(path, sizeof(path), "/tmp/perf-%d.map", getpid());
+    perf_map = fopen(path, "w");
+    if (perf_map == NULL) {
+        warn("unable to open perf map file: %s", path);
+    }
+}
+
+#if defined(__x86_64__) && defined(__linux__)
+
+#include <sys/mman.h>
+
+// state of the code being run, the machine code keeps it in rbx.
+struct VSJitFrame {
+    cpt_stack_t *stack;
+    VSCodeObject *code;
+    VSTupleObject *locals;
+    VSTupleObject *freevars;
+    VSTupleObject *cellvars;
+    vs_size_t nlocals;
+    vs_size_t nfreevars;
+    vs_size_t ncellvars;
+    vs_addr_t pc;
+};
+
+typedef void (*jit_op_t)(VSJitFrame *frame, vs_addr_t operand);
+typedef bool (*jit_entry_t)(VSJitFrame *frame, vs_addr_t pc);
+
+// the ops called by the templates, one per opcode.
+#define JIT_BINARY_OP(name)                                  \
+    static void jit_##name(VSJitFrame *frame, vs_addr_t) {   \
+        vs_op_binary(*frame->stack, ID___##name##__);        \
+    }
+
+JIT_BINARY_OP(sub)
+JIT_BINARY_OP(mul)
+JIT_BINARY_OP(div)
+JIT_BINARY_OP(mod)
+JIT_BINARY_OP(lt)
+JIT_BINARY_OP(gt)
+JIT_BINARY_OP(le)
+JIT_BINARY_OP(ge)
+JIT_BINARY_OP(eq)
+JIT_BINARY_OP(and)
+JIT_BINARY_OP(xor)
+JIT_BINARY_OP(or)
+
+// operand is the dest of vs_op_add, found when the code is compiled.
+static void jit_add(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_add(*frame->stack, frame->locals, frame->nlocals, operand);
+}
+
+static void jit_pop(VSJitFrame *frame, vs_addr_t) {
+    vs_op_pop(*frame->stack);
+}
+
+static void jit_neq(VSJitFrame *frame, vs_addr_t) {
+    vs_op_neq(*frame->stack);
+}
+
+static void jit_not(VSJitFrame *frame, vs_addr_t) {
+    vs_op_unary(*frame->stack, ID___not__);
+}
+
+static void jit_neg(VSJitFrame *frame, vs_addr_t) {
+    vs_op_unary(*frame->stack, ID___neg__);
+}
+
+static void jit_build_tuple(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_build_tuple(*frame->stack, operand);
+}
+
+static void jit_build_list(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_build_list(*frame->stack, operand);
+}
+
+static void jit_build_dict(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_build_dict(*frame->stack, operand);
+}
+
+static void jit_build_set(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_build_set(*frame->stack, operand);
+}
+
+static void jit_index_load(VSJitFrame *frame, vs_addr_t) {
+    vs_op_index_load(*frame->stack);
+}
+
+static void jit_index_store(VSJitFrame *frame, vs_addr_t) {
+    vs_op_index_store(*frame->stack);
+}
+
+static void jit_slice(VSJitFrame *frame, vs_addr_t) {
+    vs_op_slice(*frame->stack);
+}
+
+static void jit_load_local(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_load_var(*frame->stack, frame->locals, frame->nlocals, operand, "local");
+}
+
+static void jit_load_free(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_load_var(*frame->stack, frame->freevars, frame->nfreevars, operand, "free");
+}
+
+static void jit_load_cell(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_load_cell(*frame->stack, frame->cellvars, frame->ncellvars, operand, "cell");
+}
+
+static void jit_load_local_cell(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_load_cell(*frame->stack, frame->locals, frame->nlocals, operand, "local");
+}
+
+static void jit_load_free_cell(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_load_cell(*frame->stack, frame->freevars, frame->nfreevars, operand, "free");
+}
+
+static void jit_load_attr(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_load_attr(*frame->stack, frame->code, operand);
+}
+
+static void jit_store_local(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_store_var(*frame->stack, frame->locals, frame->nlocals, operand, "local");
+}
+
+static void jit_store_free(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_store_var(*frame->stack, frame->freevars, frame->nfreevars, operand, "free");
+}
+
+static void jit_store_cell(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_store_cell(*frame->stack, frame->cellvars, frame->ncellvars, operand);
+}
+
+static void jit_store_attr(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_store_attr(*frame->stack, frame->code, operand);
+}
+
+static void jit_load_const(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_load_const(*frame->stack, frame->code, operand);
+}
+
+static void jit_load_builtin(VSJitFrame *frame, vs_addr_t operand) {
+    vs_op_load_builtin(*frame->stack, operand);
+}
+
+static void jit_build_func(VSJitFrame *frame, vs_addr_t) {
+    vs_op_build_func(*frame->stack);
+}
+
+static void jit_call_func(VSJitFrame *frame, vs_addr_t) {
+    vs_op_call_func(*frame->stack);
+}
+
+static bool jit_cond(VSJitFrame *frame, vs_addr_t) {
+    return vs_op_cond(*frame->stack);
+}
+
+static bool jit_tail_call(VSJitFrame *frame, vs_addr_t) {
+    return vs_op_tail_call(*frame->stack);
+}
+
+static bool jit_back_edge(VSJitFrame *frame, vs_addr_t target) {
+    return vs_trace_hot(frame->code, target);
+}
+
+// op called by the template of opcode, NULL if it has a template of its own
+// or none, which bails out to the interpreter.
+static jit_op_t jit_op(OPCODE opcode) {
+    switch (opcode) {
+        case OP_POP: return jit_pop;
+        case OP_ADD: return jit_add;
+        case OP_SUB: return jit_sub;
+        case OP_MUL: return jit_mul;
+        case OP_DIV: return jit_div;
+        case OP_MOD: return jit_mod;
+        case OP_LT: return jit_lt;
+        case OP_GT: return jit_gt;
+        case OP_LE: return jit_le;
+        case OP_GE: return jit_ge;
+        case OP_EQ: return jit_eq;
+        case OP_NEQ: return jit_neq;
+        case OP_AND: return jit_and;
+        case OP_XOR: return jit_xor;
+        case OP_OR: return jit_or;
+        case OP_NOT: return jit_not;
+        case OP_NEG: return jit_neg;
+        case OP_BUILD_TUPLE: return jit_build_tuple;
+        case OP_BUILD_LIST: return jit_build_list;
+        case OP_BUILD_DICT: return jit_build_dict;
+        case OP_BUILD_SET: return jit_build_set;
+        case OP_INDEX_LOAD: return jit_index_load;
+        case OP_INDEX_STORE: return jit_index_store;
+        case OP_SLICE: return jit_slice;
+        case OP_LOAD_LOCAL: return jit_load_local;
+        case OP_LOAD_FREE: return jit_load_free;
+        case OP_LOAD_CELL: return jit_load_cell;
+        case OP_LOAD_LOCAL_CELL: return jit_load_local_cell;
+        case OP_LOAD_FREE_CELL: return jit_load_free_cell;
+        case OP_LOAD_ATTR: return jit_load_attr;
+        case OP_STORE_LOCAL: return jit_store_local;
+        case OP_STORE_FREE: return jit_store_free;
+        case OP_STORE_CELL: return jit_store_cell;
+        case OP_STORE_ATTR: return jit_store_attr;
+        case OP_LOAD_CONST: return jit_load_const;
+        case OP_LOAD_BUILTIN: return jit_load_builtin;
+        case OP_BUILD_FUNC: return jit_build_func;
+        case OP_CALL_FUNC: return jit_call_func;
+        default: return NULL;
+    }
+}
+
+// rdi = frame, rsi = operand, call op
+static void emit_op(VSAssembler &as, void *op, vs_addr_t operand) {
+    as.mov(X86_RDI, X86_RBX);
+    as.mov_imm(X86_RSI, operand);
+    as.call(op);
+}
+
+// frame->pc = pc, return done
+static void emit_leave(VSAssembler &as, vs_addr_t pc, bool done) {
+    as.store_imm(X86_RBX, offsetof(VSJitFrame, pc), pc);
+    as.mov_imm(X86_RAX, done);
+    as.pop(X86_RBX);
+    as.ret();
+}
+
+static bool vs_jit_enter(
+    cpt_stack_t &stack, vs_addr_t &pc, VSCodeObject *code, VSTupleObject *locals,
+    VSTupleObject *freevars, VSTupleObject *cellvars) {
+    if (pc >= code->ninsts) {
+        return true;
+    }
+
+    VSJitFrame frame;
+    frame.stack = &stack;
+    frame.code = code;
+    frame.locals = locals;
+    frame.freevars = freevars;
+    frame.cellvars = cellvars;
+    frame.nlocals = locals == NULL ? 0 : TUPLE_LEN(locals);
+    frame.nfreevars = freevars == NULL ? 0 : TUPLE_LEN(freevars);
+    frame.ncellvars = cellvars == NULL ? 0 : TUPLE_LEN(cellvars);
+    frame.pc = pc;
+
+    bool done = ((jit_entry_t)code->jit->entry)(&frame, pc);
+    pc = frame.pc;
+    return done;
+}
+
+bool vs_jit_compile(VSCodeObject *code) {
+    if (code->jit != NULL) {
+        return true;
+    }
+    // pcs are stored as sign extended imm32.
+    if (code->lazy != NULL || code->ninsts >= INT32_MAX) {
+        return false;
+    }
+
+    // a label per instruction and one for the end.
+    VSAssembler as;
+    for (vs_addr_t pc = 0; pc <= code->ninsts; pc++) {
+        as.label();
+    }
+
+    // push rbx; mov rbx, rdi; lea rax, [rip + table]; jmp [rax + rsi * 8]
+    as.push(X86_RBX);
+    as.mov(X86_RBX, X86_RDI);
+    as.bytes({0x48, 0x8d, 0x05});
+    vs_size_t table_disp = as.size();
+    as.imm32(0);
+    as.bytes({0xff, 0x24, 0xf0});
+
+    for (vs_addr_t pc = 0; pc < code->ninsts; pc++) {
+        VSInst &inst = code->code[pc];
+        as.bind(pc);
+        jit_op_t op = jit_op(inst.opcode);
+        if (op != NULL) {
+            emit_op(as, (void *)op, inst.opcode == OP_ADD ? vs_add_dest(code, pc) : inst.operand);
+            continue;
+        }
+
+        switch (inst.opcode) {
+            case OP_NOP:
+                break;
+            case OP_JMP:
+                // the interpreter reports invalid targets.
+                if (inst.operand >= code->ninsts) {
+                    emit_leave(as, pc, false);
+                } else if (inst.operand <= pc) {
+                    // leave hot loops to the interpreter, which runs their traces.
+                    emit_op(as, (void *)jit_back_edge, inst.operand);
+                    as.test_al();
+                    as.jump(X86_CC_E, inst.operand);
+                    emit_leave(as, pc, false);
+                } else {
+                    as.jump(-1, inst.operand);
+                }
+                break;
+            case OP_JIF:
+                if (inst.operand > code->ninsts) {
+                    emit_leave(as, pc, false);
+                } else {
+                    emit_op(as, (void *)jit_cond, 0);
+                    as.test_al();
+                    as.jump(X86_CC_NE, inst.operand);
+                }
+                break;
+            case OP_TAIL_CALL: {
+                vs_size_t call = as.label();
+                emit_op(as, (void *)jit_tail_call, 0);
+                as.test_al();
+                as.jump(X86_CC_E, call);
+                emit_leave(as, pc, true);
+                as.bind(call);
+                emit_op(as, (void *)jit_call_func, 0);
+                break;
+            }
+            case OP_RET:
+                emit_leave(as, pc, true);
+                break;
+            default:
+                emit_leave(as, pc, false);
+                break;
+        }
+    }
+    as.bind(code->ninsts);
+    emit_leave(as, code->ninsts, true);
+    as.link();
+
+    vs_size_t table = (as.size() + 7) & ~(vs_size_t)7;
+    as.patch(table_disp, table - (table_disp + 4));
+    vs_size_t size = table + sizeof(void *) * (code->ninsts + 1);
+    char *mem = vs_jit_alloc(size);
+    memcpy(mem, as.buf.data(), as.size());
+    for (vs_addr_t pc = 0; pc <= code->ninsts; pc++) {
+        ((char **)(mem + table))[pc] = mem + as.labels[pc];
+    }
+    vs_jit_seal(mem, size, table, "vs::" + STRING_TO_C_STRING(code->name));
+
+    VSJitCode *jit = new VSJitCode();
+    jit->mem = mem;
+    jit->size = size;
+    jit->entry = mem;
+    code->jit = jit;
+    code->native = vs_jit_enter;
+    return true;
+}
+
+char *vs_jit_alloc(vs_size_t size) {
+    char *mem = (char *)mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mem == MAP_FAILED) {
+        err("unable to mmap memory of size: %llu\n", size);
+        terminate(TERM_ERROR);
+    }
+    return mem;
+}
+
+void vs_jit_seal(char *mem, vs_size_t size, vs_size_t code_size, std::string name) {
+    if (mprotect(mem, size, PROT_READ | PROT_EXEC) != 0) {
+        err("unable to make jit code executable\n");
+        terminate(TERM_ERROR);
+    }
+
+    if (perf_map != NULL) {
+        fprintf(perf_map, "%lx %llx %s\n", (uintptr_t)mem, code_size, name.c_str());
+        fflush(perf_map);
+    }
+}
+
+void vs_jit_free(VSJitCode *jit) {
+    if (jit == NULL) {
+        return;
+    }
+
+    munmap(jit->mem, jit->size);
+    delete jit;
+}
+#else
+
+bool vs_jit_compile(VSCodeObject *) {
+    return false;
+}
+
+void vs_jit_free(VSJitCode *) {
+}
+
+#endif
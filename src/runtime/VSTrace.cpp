@@ -0,0 +1,680 @@
+#include "runtime/VSTrace.hpp"
+
+#include <string.h>
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <unordered_map>
+#include <vector>
+
+#include "runtime/VSAssembler.hpp"
+#include "runtime/VSJit.hpp"
+#include "runtime/VSOps.hpp"
+
+// entry guard failures after which a loop is no longer run with its trace.
+#define MAX_TRACE_FAILURES 100
+
+typedef enum {
+    TV_INT,
+    TV_BOOL,
+    // borrowed from a local, which the trace never stores to.
+    TV_OBJ
+} TraceValueKind;
+
+typedef enum {
+    TR_MOV,
+    TR_CONST,
+    TR_ADD,
+    TR_SUB,
+    TR_MUL,
+    TR_CMP,
+    TR_GUARD,
+    TR_INDEX_LOAD,
+    TR_INDEX_STORE
+} TraceOpcode;
+
+// an operation on slots, the values of the trace.
+struct TraceIns {
+    TraceOpcode op;
+    int dst;
+    int a;
+    int b;
+    int c;
+    // constant, condition code or expected condition.
+    int64_t imm;
+    int exit;
+};
+
+struct TraceValue {
+    int slot;
+    TraceValueKind kind;
+};
+
+struct TraceLocal {
+    vs_addr_t idx;
+    TraceValueKind kind;
+    // read before it is written, so loaded on entry.
+    bool loaded;
+    bool stored;
+    int slot;
+};
+
+// where a trace leaves to the interpreter.
+struct TraceExit {
+    vs_addr_t pc;
+    // compute stack, from the bottom.
+    std::vector<TraceValue> stack;
+    // the locals stored before it in an iteration.
+    std::vector<bool> stored;
+};
+
+class VSTrace {
+public:
+    vs_addr_t header;
+    std::vector<TraceLocal> locals;
+    std::vector<TraceIns> ins;
+    std::vector<TraceExit> exits;
+    int nslots;
+    // set once the trace has looped, the stored locals are dirty then.
+    int looped_slot;
+
+    char *mem;
+    vs_size_t size;
+
+    ~VSTrace() {
+        if (this->mem != NULL) {
+            munmap(this->mem, this->size);
+        }
+    }
+};
+
+struct TraceLoop {
+    vs_size_t hotness;
+    vs_size_t failures;
+    bool blacklisted;
+    VSTrace *trace;
+};
+
+class VSTraceCache {
+public:
+    std::unordered_map<vs_addr_t, TraceLoop> loops;
+
+    ~VSTraceCache() {
+        for (auto &loop : this->loops) {
+            delete loop.second.trace;
+        }
+    }
+};
+
+typedef int (*trace_entry_t)(int64_t *slots);
+
+static TraceLoop &trace_loop_of(VSCodeObject *code, vs_addr_t header) {
+    if (code->traces == NULL) {
+        code->traces = new VSTraceCache();
+    }
+    auto iter = code->traces->loops.find(header);
+    if (iter == code->traces->loops.end()) {
+        iter = code->traces->loops.insert({header, TraceLoop{0, 0, false, NULL}}).first;
+    }
+    return iter->second;
+}
+
+// records a trace while interpreting one iteration of a loop.
+class TraceRecorder {
+public:
+    VSTrace *trace;
+    std::vector<TraceValue> vstack;
+    std::unordered_map<vs_addr_t, int> local_of;
+    std::vector<bool> stored;
+
+    TraceRecorder(vs_addr_t header) {
+        this->trace = new VSTrace();
+        this->trace->header = header;
+        this->trace->nslots = 0;
+        this->trace->mem = NULL;
+        this->trace->size = 0;
+    }
+
+    int new_slot() {
+        return this->trace->nslots++;
+    }
+
+    TraceLocal *local(vs_addr_t idx) {
+        auto iter = this->local_of.find(idx);
+        return iter == this->local_of.end() ? NULL : &this->trace->locals[iter->second];
+    }
+
+    TraceLocal *add_local(vs_addr_t idx, TraceValueKind kind, bool loaded) {
+        this->local_of[idx] = this->trace->locals.size();
+        this->trace->locals.push_back(TraceLocal{idx, kind, loaded, false, new_slot()});
+        this->stored.push_back(false);
+        return &this->trace->locals.back();
+    }
+
+    void emit(TraceOpcode op, int dst, int a, int b, int c, int64_t imm, int exit) {
+        this->trace->ins.push_back(TraceIns{op, dst, a, b, c, imm, exit});
+    }
+
+    // exit to pc with the current compute stack.
+    int exit(vs_addr_t pc) {
+        this->trace->exits.push_back(TraceExit{pc, this->vstack, this->stored});
+        return this->trace->exits.size() - 1;
+    }
+
+    bool top_is(vs_size_t n, TraceValueKind kind) {
+        return this->vstack.size() >= n && this->vstack[this->vstack.size() - n].kind == kind;
+    }
+
+    TraceValue pop() {
+        TraceValue value = this->vstack.back();
+        this->vstack.pop_back();
+        return value;
+    }
+
+    void push(int slot, TraceValueKind kind) {
+        this->vstack.push_back(TraceValue{slot, kind});
+    }
+
+    bool record(cpt_stack_t &stack, vs_addr_t &pc, VSCodeObject *code, VSTupleObject *locals);
+};
+
+static int cmp_cc(OPCODE opcode) {
+    switch (opcode) {
+        case OP_LT: return X86_CC_L;
+        case OP_GT: return X86_CC_G;
+        case OP_LE: return X86_CC_LE;
+        case OP_GE: return X86_CC_GE;
+        case OP_EQ: return X86_CC_E;
+        default: return X86_CC_NE;
+    }
+}
+
+static std::string &binary_method(OPCODE opcode) {
+    switch (opcode) {
+        case OP_ADD: return ID___add__;
+        case OP_SUB: return ID___sub__;
+        case OP_MUL: return ID___mul__;
+        case OP_LT: return ID___lt__;
+        case OP_GT: return ID___gt__;
+        case OP_LE: return ID___le__;
+        case OP_GE: return ID___ge__;
+        default: return ID___eq__;
+    }
+}
+
+// interpret from the loop header at pc until the loop jumps back to it, and
+// record what is done. Every instruction is run as the interpreter runs it,
+// so when the recording is given up, pc is where the interpreter goes on.
+bool TraceRecorder::record(cpt_stack_t &stack, vs_addr_t &pc, VSCodeObject *code, VSTupleObject *locals) {
+    vs_size_t nlocals = locals == NULL ? 0 : TUPLE_LEN(locals);
+    vs_size_t length = 0;
+
+    while (pc < code->ninsts && length++ < VS_TRACE_MAX_LENGTH) {
+        VSInst &inst = code->code[pc];
+        switch (inst.opcode) {
+            case OP_LOAD_LOCAL: {
+                if (inst.operand >= nlocals) {
+                    return false;
+                }
+                VSObject *value = VS_CELL_GET(TUPLE_GET(locals, inst.operand));
+                TraceLocal *local = this->local(inst.operand);
+                if (local == NULL) {
+                    if (value != NULL && value->type == T_INT) {
+                        local = add_local(inst.operand, TV_INT, true);
+                    } else if (value != NULL && value->type == T_LIST) {
+                        local = add_local(inst.operand, TV_OBJ, true);
+                    } else {
+                        return false;
+                    }
+                }
+
+                if (local->kind == TV_INT) {
+                    int slot = new_slot();
+                    emit(TR_MOV, slot, local->slot, 0, 0, 0, 0);
+                    push(slot, TV_INT);
+                } else {
+                    push(local->slot, TV_OBJ);
+                }
+                vs_op_load_var(stack, locals, nlocals, inst.operand, "local");
+                break;
+            }
+            case OP_STORE_LOCAL: {
+                if (!top_is(1, TV_INT) || inst.operand >= nlocals || !AS_CELL(TUPLE_GET(locals, inst.operand))->mut) {
+                    return false;
+                }
+                TraceLocal *local = this->local(inst.operand);
+                if (local == NULL) {
+                    local = add_local(inst.operand, TV_INT, false);
+                } else if (local->kind != TV_INT) {
+                    return false;
+                }
+
+                emit(TR_MOV, local->slot, pop().slot, 0, 0, 0, 0);
+                local->stored = true;
+                this->stored[this->local_of[inst.operand]] = true;
+                vs_op_store_var(stack, locals, nlocals, inst.operand, "local");
+                break;
+            }
+            case OP_LOAD_CONST: {
+                if (inst.operand >= code->nconsts) {
+                    return false;
+                }
+                VSObject *value = LIST_GET(code->consts, inst.operand);
+                if (value->type != T_INT) {
+                    return false;
+                }
+
+                int slot = new_slot();
+                emit(TR_CONST, slot, 0, 0, 0, INT_TO_C_INT(value), 0);
+                push(slot, TV_INT);
+                vs_op_load_const(stack, code, inst.operand);
+                break;
+            }
+            case OP_POP:
+                if (this->vstack.empty()) {
+                    return false;
+                }
+                pop();
+                vs_op_pop(stack);
+                break;
+            case OP_ADD:
+            case OP_SUB:
+            case OP_MUL:
+            case OP_LT:
+            case OP_GT:
+            case OP_LE:
+            case OP_GE:
+            case OP_EQ:
+            case OP_NEQ: {
+                if (!top_is(1, TV_INT) || !top_is(2, TV_INT)) {
+                    return false;
+                }
+                int l_val = pop().slot;
+                int r_val = pop().slot;
+                int slot = new_slot();
+                if (inst.opcode == OP_ADD || inst.opcode == OP_SUB || inst.opcode == OP_MUL) {
+                    TraceOpcode op = inst.opcode == OP_ADD ? TR_ADD : inst.opcode == OP_SUB ? TR_SUB : TR_MUL;
+                    emit(op, slot, l_val, r_val, 0, 0, 0);
+                    push(slot, TV_INT);
+                } else {
+                    emit(TR_CMP, slot, l_val, r_val, 0, cmp_cc(inst.opcode), 0);
+                    push(slot, TV_BOOL);
+                }
+
+                if (inst.opcode == OP_NEQ) {
+                    vs_op_neq(stack);
+                } else {
+                    vs_op_binary(stack, binary_method(inst.opcode));
+                }
+                break;
+            }
+            case OP_JIF: {
+                if (!top_is(1, TV_BOOL) || inst.operand <= pc) {
+                    return false;
+                }
+                int cond = pop().slot;
+                bool taken = vs_op_cond(stack);
+                int exit = this->exit(taken ? pc + 1 : inst.operand);
+                emit(TR_GUARD, 0, cond, 0, 0, taken, exit);
+                pc = taken ? inst.operand : pc + 1;
+                continue;
+            }
+            case OP_JMP:
+                if (inst.operand == this->trace->header) {
+                    if (!this->vstack.empty()) {
+                        return false;
+                    }
+                    pc = inst.operand;
+                    return true;
+                }
+                if (inst.operand <= pc || inst.operand >= code->ninsts) {
+                    return false;
+                }
+                pc = inst.operand;
+                continue;
+            case OP_INDEX_LOAD: {
+                if (!top_is(1, TV_OBJ) || !top_is(2, TV_INT)) {
+                    return false;
+                }
+                int exit = this->exit(pc);
+                int list = pop().slot;
+                int idx = pop().slot;
+                vs_op_index_load(stack);
+                // only lists of ints are traced, the load is done anyway.
+                if (STACK_TOP(stack)->type != T_INT) {
+                    pc++;
+                    return false;
+                }
+
+                int slot = new_slot();
+                emit(TR_INDEX_LOAD, slot, list, idx, 0, 0, exit);
+                push(slot, TV_INT);
+                break;
+            }
+            case OP_INDEX_STORE: {
+                if (!top_is(1, TV_OBJ) || !top_is(2, TV_INT) || !top_is(3, TV_INT)) {
+                    return false;
+                }
+                int exit = this->exit(pc);
+                int list = pop().slot;
+                int idx = pop().slot;
+                int value = pop().slot;
+                emit(TR_INDEX_STORE, 0, list, idx, value, 0, exit);
+                vs_op_index_store(stack);
+                break;
+            }
+            case OP_NOP:
+                break;
+            default:
+                return false;
+        }
+        pc++;
+    }
+    return false;
+}
+
+#if defined(__x86_64__) && defined(__linux__)
+
+// the slow parts of the trace, which return false to leave it.
+static bool trace_list_get_int(VSObject *obj, int64_t idx, int64_t *value) {
+    VSListObject *list = (VSListObject *)obj;
+    if ((vs_size_t)idx >= list->items.size()) {
+        return false;
+    }
+
+    VSObject *item = list->items[idx];
+    if (item->type != T_INT) {
+        return false;
+    }
+    *value = INT_TO_C_INT(item);
+    return true;
+}
+
+static bool trace_list_set_int(VSObject *obj, int64_t idx, int64_t value) {
+    VSListObject *list = (VSListObject *)obj;
+    if ((vs_size_t)idx >= list->items.size()) {
+        return false;
+    }
+
+    DECREF(list->items[idx]);
+    list->items[idx] = C_INT_TO_INT(value);
+    INCREF(list->items[idx]);
+    return true;
+}
+
+// machine code of a trace, rbx points to its slots. The int locals used the
+// most live in the callee saved registers while it loops.
+class TraceCompiler {
+public:
+    VSTrace *trace;
+    VSAssembler as;
+    std::vector<int> reg_of;
+
+    TraceCompiler(VSTrace *trace) {
+        this->trace = trace;
+        this->reg_of = std::vector<int>(trace->nslots + 1, -1);
+
+        std::vector<int> uses(trace->nslots, 0);
+        for (auto &ins : trace->ins) {
+            uses[ins.dst]++;
+            uses[ins.a]++;
+            uses[ins.b]++;
+            uses[ins.c]++;
+        }
+        std::vector<TraceLocal *> candidates;
+        for (auto &local : trace->locals) {
+            if (local.kind == TV_INT) {
+                candidates.push_back(&local);
+            }
+        }
+        std::sort(candidates.begin(), candidates.end(), [&uses](TraceLocal *a, TraceLocal *b) {
+            return uses[a->slot] > uses[b->slot];
+        });
+        static const int regs[] = {X86_R12, X86_R13, X86_R14, X86_R15};
+        for (vs_size_t i = 0; i < candidates.size() && i < 4; i++) {
+            this->reg_of[candidates[i]->slot] = regs[i];
+        }
+    }
+
+    int32_t disp(int slot) {
+        return slot * sizeof(int64_t);
+    }
+
+    void load(int reg, int slot) {
+        if (reg_of[slot] >= 0) {
+            as.mov(reg, reg_of[slot]);
+        } else {
+            as.load(reg, X86_RBX, disp(slot));
+        }
+    }
+
+    void store(int slot, int reg) {
+        if (reg_of[slot] >= 0) {
+            as.mov(reg_of[slot], reg);
+        } else {
+            as.store(X86_RBX, disp(slot), reg);
+        }
+    }
+
+    void compile();
+};
+
+void TraceCompiler::compile() {
+    static const int saved[] = {X86_RBX, X86_R12, X86_R13, X86_R14, X86_R15};
+    std::vector<vs_size_t> exits;
+    for (vs_size_t i = 0; i < trace->exits.size(); i++) {
+        exits.push_back(as.label());
+    }
+    vs_size_t loop = as.label();
+    vs_size_t leave = as.label();
+
+    // the five pushes keep the stack aligned for the calls.
+    for (int reg : saved) {
+        as.push(reg);
+    }
+    as.mov(X86_RBX, X86_RDI);
+    for (auto &local : trace->locals) {
+        if (reg_of[local.slot] >= 0) {
+            as.load(reg_of[local.slot], X86_RBX, disp(local.slot));
+        }
+    }
+    as.store_imm(X86_RBX, disp(trace->looped_slot), 0);
+
+    as.bind(loop);
+    for (auto &ins : trace->ins) {
+        switch (ins.op) {
+            case TR_MOV:
+                load(X86_RAX, ins.a);
+                store(ins.dst, X86_RAX);
+                break;
+            case TR_CONST:
+                as.mov_imm(X86_RAX, ins.imm);
+                store(ins.dst, X86_RAX);
+                break;
+            case TR_ADD:
+            case TR_SUB:
+            case TR_MUL:
+                load(X86_RAX, ins.a);
+                load(X86_RCX, ins.b);
+                if (ins.op == TR_MUL) {
+                    as.imul(X86_RAX, X86_RCX);
+                } else {
+                    as.alu(ins.op == TR_ADD ? 0x01 : 0x29, X86_RAX, X86_RCX);
+                }
+                store(ins.dst, X86_RAX);
+                break;
+            case TR_CMP:
+                load(X86_RAX, ins.a);
+                load(X86_RCX, ins.b);
+                as.alu(0x39, X86_RAX, X86_RCX);
+                as.setcc(ins.imm);
+                store(ins.dst, X86_RAX);
+                break;
+            case TR_GUARD:
+                load(X86_RAX, ins.a);
+                as.alu(0x85, X86_RAX, X86_RAX);
+                as.jump(ins.imm ? X86_CC_E : X86_CC_NE, exits[ins.exit]);
+                break;
+            case TR_INDEX_LOAD:
+                load(X86_RDI, ins.a);
+                load(X86_RSI, ins.b);
+                as.lea(X86_RDX, X86_RBX, disp(ins.dst));
+                as.call((void *)trace_list_get_int);
+                as.test_al();
+                as.jump(X86_CC_E, exits[ins.exit]);
+                break;
+            case TR_INDEX_STORE:
+                load(X86_RDI, ins.a);
+                load(X86_RSI, ins.b);
+                load(X86_RDX, ins.c);
+                as.call((void *)trace_list_set_int);
+                as.test_al();
+                as.jump(X86_CC_E, exits[ins.exit]);
+                break;
+        }
+    }
+    as.store_imm(X86_RBX, disp(trace->looped_slot), 1);
+    as.jump(-1, loop);
+
+    // return the exit taken, with the locals in registers written back.
+    for (vs_size_t i = 0; i < exits.size(); i++) {
+        as.bind(exits[i]);
+        as.mov_imm(X86_RAX, i);
+        as.jump(-1, leave);
+    }
+    as.bind(leave);
+    for (auto &local : trace->locals) {
+        if (reg_of[local.slot] >= 0) {
+            as.store(X86_RBX, disp(local.slot), reg_of[local.slot]);
+        }
+    }
+    for (int i = 4; i >= 0; i--) {
+        as.pop(saved[i]);
+    }
+    as.ret();
+    as.link();
+
+    trace->size = as.size();
+    trace->mem = vs_jit_alloc(trace->size);
+    memcpy(trace->mem, as.buf.data(), as.size());
+}
+
+static void trace_compile(VSTrace *trace, VSCodeObject *code) {
+    trace->looped_slot = trace->nslots++;
+    TraceCompiler compiler(trace);
+    compiler.compile();
+    vs_jit_seal(trace->mem, trace->size, trace->size,
+                "vs::trace::" + STRING_TO_C_STRING(code->name) + "@" + std::to_string(trace->header));
+}
+
+static VSObject *trace_box(TraceValue value, int64_t *slots) {
+    switch (value.kind) {
+        case TV_INT:
+            return C_INT_TO_INT(slots[value.slot]);
+        case TV_BOOL:
+            return C_BOOL_TO_BOOL(slots[value.slot]);
+        default:
+            return (VSObject *)slots[value.slot];
+    }
+}
+
+// run the trace if the locals have the types it was recorded with.
+static bool trace_run(TraceLoop &loop, cpt_stack_t &stack, vs_addr_t &pc, VSTupleObject *locals) {
+    VSTrace *trace = loop.trace;
+    vs_size_t nlocals = locals == NULL ? 0 : TUPLE_LEN(locals);
+    std::vector<int64_t> slots(trace->nslots);
+    for (auto &local : trace->locals) {
+        if (local.idx >= nlocals) {
+            return false;
+        }
+        VSObject *cell = TUPLE_GET(locals, local.idx);
+        VSObject *value = VS_CELL_GET(cell);
+        if (local.stored && !AS_CELL(cell)->mut) {
+            loop.failures++;
+            return false;
+        }
+        if (!local.loaded) {
+            continue;
+        }
+        if (value == NULL || value->type != (local.kind == TV_INT ? T_INT : T_LIST)) {
+            loop.failures++;
+            return false;
+        }
+        slots[local.slot] = local.kind == TV_INT ? INT_TO_C_INT(value) : (int64_t)value;
+    }
+
+    TraceExit &exit = trace->exits[((trace_entry_t)trace->mem)(slots.data())];
+    bool looped = slots[trace->looped_slot];
+    for (vs_size_t i = 0; i < trace->locals.size(); i++) {
+        TraceLocal &local = trace->locals[i];
+        if (local.stored && (looped || exit.stored[i])) {
+            VSObject *cell = TUPLE_GET(locals, local.idx);
+            VSObject *value = C_INT_TO_INT(slots[local.slot]);
+            VS_CELL_SET(cell, value);
+        }
+    }
+    for (auto &value : exit.stack) {
+        STACK_PUSH_INCREF(stack, trace_box(value, slots.data()));
+    }
+    pc = exit.pc;
+    return true;
+}
+
+bool vs_trace_hot(VSCodeObject *code, vs_addr_t header) {
+    if (!vs_jit_enabled) {
+        return false;
+    }
+
+    TraceLoop &loop = trace_loop_of(code, header);
+    if (loop.blacklisted) {
+        return false;
+    }
+    return loop.trace != NULL || ++loop.hotness >= VS_TRACE_THRESHOLD;
+}
+
+bool vs_trace_loop(cpt_stack_t &stack, vs_addr_t &pc, VSCodeObject *code, VSTupleObject *locals) {
+    if (!vs_jit_enabled) {
+        return false;
+    }
+
+    TraceLoop &loop = trace_loop_of(code, pc);
+    if (loop.blacklisted) {
+        return false;
+    }
+    if (loop.trace != NULL) {
+        if (trace_run(loop, stack, pc, locals)) {
+            return true;
+        }
+        loop.blacklisted = loop.failures >= MAX_TRACE_FAILURES;
+        return false;
+    }
+    if (++loop.hotness < VS_TRACE_THRESHOLD) {
+        return false;
+    }
+
+    TraceRecorder recorder(pc);
+    if (recorder.record(stack, pc, code, locals) && !recorder.trace->exits.empty()) {
+        trace_compile(recorder.trace, code);
+        loop.trace = recorder.trace;
+    } else {
+        delete recorder.trace;
+        loop.blacklisted = true;
+    }
+    return true;
+}
+
+#else
+
+bool vs_trace_hot(VSCodeObject *, vs_addr_t) {
+    return false;
+}
+
+bool vs_trace_loop(cpt_stack_t &, vs_addr_t &, VSCodeObject *, VSTupleObject *) {
+    return false;
+}
+
+#endif
+
+void vs_trace_free(VSTraceCache *traces) {
+    delete traces;
+}
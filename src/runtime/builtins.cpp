@@ -1,6 +1,7 @@
 #include "runtime/builtins.hpp"
 
 #include "error.hpp"
+#include "objects/VSArrayObject.hpp"
 #include "objects/VSBaseObject.hpp"
 #include "objects/VSBoolObject.hpp"
 #include "objects/VSCharObject.hpp"
@@ -28,7 +29,7 @@ static void vs_print_impl(VSObject *obj) {
         terminate(TERM_ERROR);
     }
 
-    std::string &str = ((VSStringObject *)objstr)->_value;
+    std::string &str = STRING_TO_C_STRING(objstr);
     printf("%s", str.c_str());
 
     DECREF_EX(objstr);
@@ -141,12 +142,16 @@ name_addr_map _builtin_addrs_struct = {
     {"setattr", 15},
     {"removeattr", 16},
     {"stdin", 17},
-    {"stdout", 18}};
+    {"stdout", 18},
+    {"intarray", 19},
+    {"floatarray", 20},
+    {"bytearray", 21},
+    {"frozenset", 22}};
 
 name_addr_map *builtin_addrs = &_builtin_addrs_struct;
 
 VSTupleObject *builtins = vs_tuple_pack(
-    19,
+    23,
     AS_OBJECT(new VSNativeFunctionObject(NULL, C_STRING_TO_STRING("input"), vs_input)),
     AS_OBJECT(new VSNativeFunctionObject(NULL, C_STRING_TO_STRING("print"), vs_print)),
     AS_OBJECT(new VSNativeFunctionObject(NULL, C_STRING_TO_STRING("open"), vs_open)),
@@ -165,7 +170,11 @@ VSTupleObject *builtins = vs_tuple_pack(
     AS_OBJECT(new VSNativeFunctionObject(NULL, C_STRING_TO_STRING("setattr"), vs_setattr)),
     AS_OBJECT(new VSNativeFunctionObject(NULL, C_STRING_TO_STRING("removeattr"), vs_removeattr)),
     AS_OBJECT(VS_STDIN),
-    AS_OBJECT(VS_STDOUT)
+    AS_OBJECT(VS_STDOUT),
+    AS_OBJECT(new VSNativeFunctionObject(NULL, C_STRING_TO_STRING("intarray"), vs_intarray)),
+    AS_OBJECT(new VSNativeFunctionObject(NULL, C_STRING_TO_STRING("floatarray"), vs_floatarray)),
+    AS_OBJECT(new VSNativeFunctionObject(NULL, C_STRING_TO_STRING("bytearray"), vs_bytearray)),
+    AS_OBJECT(new VSNativeFunctionObject(NULL, C_STRING_TO_STRING("frozenset"), vs_frozenset))
 );
 
 vs_size_t nbuiltins = TUPLE_LEN(builtins);
@@ -0,0 +1,150 @@
+// methods of int arrays running vectorized kernels against the scalar VScript
+// loops they replace, and the kernels themselves at each simd level.
+// usage: bench_array [number of items]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "compiler/VSCompiler.hpp"
+#include "objects/VSArrayKernels.hpp"
+#include "objects/VSArrayObject.hpp"
+#include "objects/VSFunctionObject.hpp"
+#include "objects/VSIntObject.hpp"
+#include "objects/VSFrameObject.hpp"
+#include "objects/VSTupleObject.hpp"
+#include "runtime/VSInterpreter.hpp"
+#include "runtime/builtins.hpp"
+
+#define DEFAULT_NITEMS 1000000
+#define NROUNDS 5
+
+// an op, as a VScript loop over the arrays a and b and as the method of a
+// doing the same, called with no args, the int arg or b.
+enum { NO_ARG, INT_ARG, ARRAY_ARG };
+
+struct BenchOp {
+    const char *name;
+    const char *loop;
+    const char *method;
+    int args;
+    cint_t arg;
+};
+
+static const BenchOp ops[] = {
+    {"sum", "var s = 0; for (var i = 0; i < n; i += 1) { s += a[i]; }", "sum", NO_ARG, 0},
+    {"min", "var m = a[0]; for (var i = 1; i < n; i += 1) { if (a[i] < m) { m = a[i]; } }", "min", NO_ARG, 0},
+    {"scale", "var c = intarray(n); for (var i = 0; i < n; i += 1) { c[i] = a[i] * 3; }", "scale", INT_ARG, 3},
+    {"add", "var c = intarray(n); for (var i = 0; i < n; i += 1) { c[i] = a[i] + b[i]; }", "add", ARRAY_ARG, 0},
+    {"mask", "var c = bytearray(n); for (var i = 0; i < n; i += 1) { if (a[i] > 0) { c[i] = 1; } }", "gt", INT_ARG, 0},
+    {"cumsum", "var s = 0; var c = intarray(n); for (var i = 0; i < n; i += 1) { s += a[i]; c[i] = s; }", "cumsum", NO_ARG, 0}};
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// seconds to compile and run source.
+static double run(std::string source) {
+    char path[] = "/tmp/bench_array_XXXXXX";
+    int fd = mkstemp(path);
+    FILE *file = fdopen(fd, "w");
+    fputs(source.c_str(), file);
+    fclose(file);
+
+    double start = now();
+    VSCompiler *compiler = new VSCompiler(builtin_addrs, VS_OPT_AST, NULL, 1, false);
+    VSCodeObject *program = compiler->compile(path);
+    VSFrameObject *frame = new VSFrameObject(program, NULL, new VSTupleObject(program->ncellvars), NULL, NULL);
+    auto stack = std::stack<VSObject *>();
+    INTERPRETER.eval(stack, frame);
+    double elapsed = now() - start;
+
+    remove(path);
+    return elapsed;
+}
+
+// best seconds of kernel over NROUNDS.
+template <typename Kernel>
+static double best_of(Kernel kernel) {
+    double best = 0;
+    for (int round = 0; round < NROUNDS; round++) {
+        double start = now();
+        kernel();
+        double elapsed = now() - start;
+        best = round == 0 || elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    vs_size_t nitems = argc > 1 ? atol(argv[1]) : DEFAULT_NITEMS;
+    printf("items: %llu, simd level: %d\n", nitems, vs_simd_level());
+
+    std::string setup = "var n = " + std::to_string(nitems) + ";\n"
+        "var a = intarray(n);\n"
+        "var b = intarray(n);\n"
+        "for (var i = 0; i < n; i += 1) { a[i] = (i * 7919) % 10007 - 5000; b[i] = i % 100; }\n";
+    double setup_time = run(setup);
+
+    std::vector<cint_t> a(nitems), b(nitems), c(nitems);
+    std::vector<cbyte_t> mask(nitems);
+    for (vs_size_t i = 0; i < nitems; i++) {
+        a[i] = (cint_t)(i * 7919) % 10007 - 5000;
+        b[i] = i % 100;
+    }
+
+    VSIntArrayObject *array_a = NEW_REF(VSIntArrayObject *, new VSIntArrayObject(0));
+    VSIntArrayObject *array_b = NEW_REF(VSIntArrayObject *, new VSIntArrayObject(0));
+    array_a->items = a;
+    array_b->items = b;
+
+    printf("%-8s %12s %12s\n", "op", "loop (ms)", "method (ms)");
+    for (auto &op : ops) {
+        double loop = run(setup + op.loop + "\n") - setup_time;
+
+        std::string method = op.method;
+        double best = best_of([&]() {
+            VSTupleObject *args = op.args == NO_ARG  ? EMPTY_TUPLE()
+                                  : op.args == INT_ARG ? vs_tuple_pack(1, C_INT_TO_INT(op.arg))
+                                                       : vs_tuple_pack(1, array_b);
+            VSObject *res = CALL_ATTR(array_a, method, args);
+            DECREF(res);
+        });
+        printf("%-8s %12.1f %12.3f\n", op.name, loop * 1000, best * 1000);
+    }
+
+    printf("\n%-8s %12s %12s %12s\n", "kernel", "scalar (ms)", "sse2 (ms)", "avx2 (ms)");
+    const char *names[] = {"sum", "min", "scale", "add", "mask", "cumsum"};
+    for (int op = 0; op < 6; op++) {
+        printf("%-8s", names[op]);
+        for (int level = VS_SIMD_NONE; level <= VS_SIMD_AVX2; level++) {
+            if (level > vs_simd_level()) {
+                printf(" %12s", "-");
+                continue;
+            }
+            vs_array_kernels_select(level);
+            VSArrayKernels &k = vs_array_kernels;
+            volatile cint_t sink = 0;
+            double best = best_of([&]() {
+                switch (op) {
+                    case 0: sink = k.sum_int(a.data(), nitems); break;
+                    case 1: sink = k.min_int(a.data(), nitems); break;
+                    case 2: k.scale_int(c.data(), a.data(), nitems, 3); break;
+                    case 3: k.add_int(c.data(), a.data(), b.data(), nitems); break;
+                    case 4: k.cmp_int(mask.data(), a.data(), nitems, 0, VS_CMP_GT); break;
+                    case 5: k.cumsum_int(c.data(), a.data(), nitems); break;
+                }
+            });
+            (void)sink;
+            printf(" %12.3f", best * 1000);
+        }
+        printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,182 @@
+// recompiles an edited script through one compiler, as a host reloading it
+// does, at each opt level, eager and lazy. Checks that only the edited
+// functions are compiled again, that reused code is not optimized again, and
+// that the program prints what the edited source computes. Compile time is
+// the parse of the whole text plus the edited bodies.
+// usage: bench_recompile [number of functions]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <set>
+#include <stack>
+#include <string>
+#include <vector>
+
+#include "compiler/VSCompiler.hpp"
+#include "objects/VSFrameObject.hpp"
+#include "objects/VSTupleObject.hpp"
+#include "runtime/VSInterpreter.hpp"
+#include "runtime/builtins.hpp"
+
+#define DEFAULT_NFUNCS 200
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// function k at version v returns 10 * x * (k + v) + 45, main prints the sum
+// over all functions called with 1. Main calls them through a list, so its
+// code stays small and the time goes to the bodies.
+static std::string source(std::vector<int> &versions) {
+    std::string source;
+    for (size_t k = 0; k < versions.size(); k++) {
+        std::string c = std::to_string(k + versions[k]);
+        source += "func f" + std::to_string(k) + "(x) {\n"
+            "    var s = 0;\n"
+            "    for (var i = 0; i < 10; i += 1) {\n"
+            "        if (i % 2 == 0) {\n"
+            "            s += x * " + c + " + i;\n"
+            "        } else {\n"
+            "            s += i + " + c + " * x;\n"
+            "        }\n"
+            "    }\n"
+            "    val items = [s, s + 1, s + 2];\n"
+            "    return items[0];\n"
+            "}\n";
+    }
+    source += "val funcs = [";
+    for (size_t k = 0; k < versions.size(); k++) {
+        source += (k == 0 ? "f" : ", f") + std::to_string(k);
+    }
+    return source + "];\n"
+        "var total = 0;\n"
+        "for (var k = 0; k < funcs.len(); k += 1) {\n"
+        "    total += funcs[k](1);\n"
+        "}\n"
+        "print(total);\n";
+}
+
+static std::string expected(std::vector<int> &versions) {
+    long long total = 0;
+    for (size_t k = 0; k < versions.size(); k++) {
+        total += 10 * (k + versions[k]) + 45;
+    }
+    return std::to_string(total) + " \n";
+}
+
+// what program prints, written to a temporary file in place of stdout.
+static std::string run(VSCodeObject *program) {
+    fflush(stdout);
+    FILE *out = tmpfile();
+    int saved = dup(STDOUT_FILENO);
+    dup2(fileno(out), STDOUT_FILENO);
+
+    VSFrameObject *frame = new VSFrameObject(program, NULL, new VSTupleObject(program->ncellvars), NULL, NULL);
+    auto stack = std::stack<VSObject *>();
+    INTERPRETER.eval(stack, frame);
+
+    fflush(stdout);
+    dup2(saved, STDOUT_FILENO);
+    close(saved);
+
+    std::string printed;
+    char buf[256];
+    rewind(out);
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), out)) > 0;) {
+        printed.append(buf, n);
+    }
+    fclose(out);
+    return printed;
+}
+
+// names of the functions optimized since the last call, read from the ir dump.
+static std::set<std::string> optimized(FILE *dump) {
+    std::set<std::string> names;
+    char *line = NULL;
+    size_t size = 0;
+    rewind(dump);
+    while (getline(&line, &size, dump) != -1) {
+        std::string name = line;
+        if (name.size() > 2 && name[0] != ' ' && name.compare(0, 2, "bb") != 0) {
+            names.insert(name.substr(0, name.size() - 2));
+        }
+    }
+    free(line);
+    rewind(dump);
+    if (ftruncate(fileno(dump), 0) != 0) {
+        perror("ftruncate");
+        exit(-1);
+    }
+    return names;
+}
+
+static void fail(const char *mode, int nedits, const char *what) {
+    fprintf(stderr, "%s, %d edited: %s\n", mode, nedits, what);
+    exit(-1);
+}
+
+int main(int argc, char **argv) {
+    int nfuncs = argc > 1 ? atoi(argv[1]) : DEFAULT_NFUNCS;
+    const int edits[] = {0, 1, 10, nfuncs / 2, nfuncs};
+    printf("functions: %d\n", nfuncs);
+    printf("%-8s %8s %12s %8s %12s\n", "mode", "edited", "compile (ms)", "reused", "recompiled");
+
+    for (int opt_level = VS_OPT_NONE; opt_level <= VS_OPT_SSA; opt_level++) {
+        for (int lazy = 0; lazy <= 1; lazy++) {
+            char mode[16];
+            snprintf(mode, sizeof(mode), "-O%d%s", opt_level, lazy ? " -l" : "");
+
+            FILE *dump = tmpfile();
+            VSCompiler *compiler = new VSCompiler(builtin_addrs, opt_level, dump, 4, lazy);
+            std::vector<int> versions(nfuncs, 0);
+            // the first compilation has nothing to reuse.
+            int nedits = nfuncs;
+            for (int round = -1; round < (int)(sizeof(edits) / sizeof(edits[0])); round++) {
+                if (round >= 0) {
+                    nedits = edits[round];
+                    for (int k = 0; k < nedits; k++) {
+                        versions[k]++;
+                    }
+                }
+
+                std::string text = source(versions);
+                double start = now();
+                VSCodeObject *program = compiler->compile_source(text);
+                double elapsed = now() - start;
+
+                if (compiler->nrecompiled != (vs_size_t)nedits || compiler->nreused != (vs_size_t)(nfuncs - nedits)) {
+                    fail(mode, nedits, "wrong number of reused functions");
+                }
+
+                // deferred bodies are optimized when generated, without a dump.
+                std::set<std::string> names = optimized(dump);
+                if (opt_level >= VS_OPT_SSA) {
+                    std::set<std::string> expected_names = {"__main__"};
+                    for (int k = 0; k < nedits && !lazy; k++) {
+                        expected_names.insert("f" + std::to_string(k));
+                    }
+                    if (names != expected_names) {
+                        fail(mode, nedits, "optimized other functions than the edited ones");
+                    }
+                } else if (!names.empty()) {
+                    fail(mode, nedits, "optimized below -O2");
+                }
+
+                if (run(program) != expected(versions)) {
+                    fail(mode, nedits, "wrong output");
+                }
+                if (round >= 0) {
+                    printf("%-8s %8d %12.3f %8llu %12llu\n", mode, nedits, elapsed * 1000, compiler->nreused,
+                           compiler->nrecompiled);
+                }
+            }
+            fclose(dump);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+// list.sort() on lists of random ints, floats and strings, and of presorted
+// ints, checked against std::stable_sort of the same values.
+// usage: bench_sort [number of items]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <algorithm>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "objects/VSFloatObject.hpp"
+#include "objects/VSFunctionObject.hpp"
+#include "objects/VSIntObject.hpp"
+#include "objects/VSListObject.hpp"
+#include "objects/VSStringObject.hpp"
+#include "objects/VSTupleObject.hpp"
+
+#define DEFAULT_NITEMS 1000000
+
+NEW_IDENTIFIER(sort);
+NEW_IDENTIFIER(key);
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// key function of the keyed case, the identity.
+static VSObject *identity(VSObject *, VSObject *const *args, vs_size_t) {
+    INCREF_RET(args[0]);
+}
+
+// sort list with args, and check that it holds expected, in order.
+template <typename T, typename Value>
+static void bench(const char *name, VSListObject *list, VSTupleObject *args, std::vector<T> expected, Value value) {
+    double start = now();
+    VSObject *res = CALL_ATTR(list, ID_sort, args);
+    double elapsed = now() - start;
+    DECREF(res);
+
+    start = now();
+    std::stable_sort(expected.begin(), expected.end());
+    double native = now() - start;
+
+    for (vs_size_t i = 0; i < expected.size(); i++) {
+        if (!(value(LIST_GET(list, i)) == expected[i])) {
+            fprintf(stderr, "%s: wrong item at %llu\n", name, i);
+            exit(-1);
+        }
+    }
+    printf("%-14s %8.3f s, std::stable_sort of the values: %.3f s\n", name, elapsed, native);
+    DECREF(list);
+}
+
+int main(int argc, char **argv) {
+    vs_size_t nitems = argc > 1 ? atol(argv[1]) : DEFAULT_NITEMS;
+    std::mt19937_64 random(42);
+
+    std::vector<cint_t> ints(nitems);
+    std::vector<cfloat_t> floats(nitems);
+    std::vector<std::string> strs(nitems);
+    for (vs_size_t i = 0; i < nitems; i++) {
+        ints[i] = random() % (nitems * 4);
+        floats[i] = (cfloat_t)random() / random.max();
+        strs[i] = "item " + std::to_string(random() % (nitems * 4));
+    }
+
+    auto int_list = [&](std::vector<cint_t> &values) {
+        VSListObject *list = new VSListObject(0);
+        for (auto value : values) {
+            LIST_APPEND(list, C_INT_TO_INT(value));
+        }
+        INCREF(list);
+        return list;
+    };
+    auto int_value = [](VSObject *obj) { return INT_TO_C_INT(obj); };
+
+    printf("items: %llu\n", nitems);
+
+    bench("random ints", int_list(ints), EMPTY_TUPLE(), ints, int_value);
+
+    std::vector<cint_t> sorted = ints;
+    std::sort(sorted.begin(), sorted.end());
+    bench("sorted ints", int_list(sorted), EMPTY_TUPLE(), sorted, int_value);
+
+    std::vector<cint_t> reversed(sorted.rbegin(), sorted.rend());
+    bench("reversed ints", int_list(reversed), EMPTY_TUPLE(), reversed, int_value);
+
+    VSObject *key = new VSNativeFunctionObject(NULL, C_STRING_TO_STRING(ID_key), identity);
+    INCREF(key);
+    bench("keyed ints", int_list(ints), vs_tuple_pack(1, key), ints, int_value);
+
+    VSListObject *float_list = new VSListObject(0);
+    for (auto value : floats) {
+        LIST_APPEND(float_list, C_FLOAT_TO_FLOAT(value));
+    }
+    INCREF(float_list);
+    bench("random floats", float_list, EMPTY_TUPLE(), floats, [](VSObject *obj) { return FLOAT_TO_C_FLOAT(obj); });
+
+    VSListObject *str_list = new VSListObject(0);
+    for (auto &value : strs) {
+        LIST_APPEND(str_list, C_STRING_TO_STRING(value));
+    }
+    INCREF(str_list);
+    bench("random strs", str_list, EMPTY_TUPLE(), strs, [](VSObject *obj) { return STRING_TO_C_STRING(obj); });
+
+    return 0;
+}
@@ -0,0 +1,135 @@
+// substring search of the str methods on a log of several megabytes, each
+// search against std::string_view::find, and str.split() and str.remove() on
+// the whole log.
+// usage: bench_str [megabytes of log]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include <random>
+#include <string>
+
+#include "objects/VSCharObject.hpp"
+#include "objects/VSFunctionObject.hpp"
+#include "objects/VSIntObject.hpp"
+#include "objects/VSListObject.hpp"
+#include "objects/VSStringObject.hpp"
+#include "objects/VSStringSearch.hpp"
+#include "objects/VSTupleObject.hpp"
+
+#define DEFAULT_MEGABYTES 16
+#define NROUNDS 5
+
+NEW_IDENTIFIER(locate);
+NEW_IDENTIFIER(split);
+NEW_IDENTIFIER(remove);
+
+// none of them are in the log, so each search scans all of it.
+static const char *needles[] = {
+    "#",
+    "id=x",
+    "ERROR in worker",
+    "request id=1234 took 5ms status=200 re",
+    "2024-01-01 12:00:00 INFO worker-3 handled request id=12345 in 17ms with status 200 "
+    "and a response of 4096 bytes from the upstream cache, no retry"};
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+// best seconds of bench over NROUNDS.
+template <typename Bench>
+static double best_of(Bench bench) {
+    double best = 0;
+    for (int round = 0; round < NROUNDS; round++) {
+        double start = now();
+        bench();
+        double elapsed = now() - start;
+        best = round == 0 || elapsed < best ? elapsed : best;
+    }
+    return best;
+}
+
+int main(int argc, char **argv) {
+    vs_size_t size = (argc > 1 ? atol(argv[1]) : DEFAULT_MEGABYTES) << 20;
+    std::mt19937_64 random(42);
+
+    std::string log;
+    const char *levels[] = {"INFO", "WARN", "DEBUG"};
+    while (log.length() < size) {
+        log += "2024-01-01 12:" + std::to_string(10 + random() % 50) + ":00 " + levels[random() % 3] + " worker-" +
+               std::to_string(random() % 16) + " handled request id=" + std::to_string(random() % 100000) + " in " +
+               std::to_string(random() % 100) + "ms\n";
+    }
+    printf("log: %.1f MB\n", log.length() / 1048576.0);
+
+    printf("%-8s %14s %14s %14s %14s\n", "needle", "find (ms)", "filter (ms)", "horspool (ms)", "locate (ms)");
+    VSStringObject *str = NEW_REF(VSStringObject *, new VSStringObject(log));
+    for (auto needle : needles) {
+        std::string_view view = needle;
+        volatile std::size_t sink = 0;
+        double find = best_of([&]() { sink = std::string_view(log).find(view); });
+        double filter = view.length() < 2 ? 0 : best_of([&]() {
+            sink = vs_str_find_filter(log.data(), log.length(), view.data(), view.length());
+        });
+        double horspool = view.length() < 2 ? 0 : best_of([&]() {
+            sink = vs_str_find_horspool(log.data(), log.length(), view.data(), view.length());
+        });
+        VSObject *needle_str = NEW_REF(VSObject *, new VSStringObject(needle));
+        double locate = best_of([&]() {
+            VSObject *res = CALL_ATTR(str, ID_locate, vs_tuple_pack(1, needle_str));
+            if (INT_TO_C_INT(res) != -1) {
+                fprintf(stderr, "found %s\n", needle);
+                exit(-1);
+            }
+            DECREF(res);
+        });
+        (void)sink;
+        DECREF(needle_str);
+        printf("%-8zu %14.3f %14.3f %14.3f %14.3f\n", view.length(), find * 1000, filter * 1000, horspool * 1000,
+               locate * 1000);
+    }
+
+    // the lines, as str.split() found them with std::string_view::find
+    VSObject *sep = NEW_REF(VSObject *, new VSStringObject("\n"));
+    double split_find = best_of([&]() {
+        VSListObject *lines = new VSListObject(0);
+        std::string_view view = log;
+        std::size_t start = 0, end = view.find('\n');
+        while (end != view.npos) {
+            LIST_APPEND(lines, C_STRING_TO_STRING(std::string(view.substr(start, end - start))));
+            start = end + 1;
+            end = view.find('\n', start);
+        }
+        INCREF(lines);
+        DECREF(lines);
+    });
+    double split = best_of([&]() {
+        VSObject *lines = CALL_ATTR(str, ID_split, vs_tuple_pack(1, sep));
+        DECREF(lines);
+    });
+    printf("\nsplit into lines: %.3f ms, with std::string_view::find: %.3f ms\n", split * 1000, split_find * 1000);
+
+    // removing the chars one at a time takes quadratic time, only on a slice
+    vs_size_t erase_size = 1 << 18;
+    double erase = best_of([&]() {
+        std::string value = log.substr(0, erase_size);
+        std::size_t idx = value.find('9');
+        while (idx != value.npos) {
+            value.erase(idx, 1);
+            idx = value.find('9', idx);
+        }
+    });
+    VSObject *nine = NEW_REF(VSObject *, C_CHAR_TO_CHAR('9'));
+    double remove = best_of([&]() {
+        VSObject *copy = NEW_REF(VSObject *, new VSStringObject(log));
+        DECREF(CALL_ATTR(copy, ID_remove, vs_tuple_pack(1, nine)));
+        DECREF(copy);
+    });
+    printf("remove '9': %.3f ms, erasing each of them in the first %llu KB: %.3f ms\n", remove * 1000,
+           erase_size >> 10, erase * 1000);
+    return 0;
+}
@@ -0,0 +1,80 @@
+// tokenizer throughput on a generated VScript source of several megabytes.
+// usage: bench_tokenizer [size in MB]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "compiler/VSTokenizer.hpp"
+
+#define DEFAULT_SIZE_MB 8
+#define NROUNDS 5
+
+static std::string gen_source(size_t size) {
+    std::string source;
+    int i = 0;
+    while (source.length() < size) {
+        std::string n = std::to_string(i++);
+        source += "// generated function number " + n + ", with a comment line\n";
+        source += "func generated_function_" + n + "(first_argument, second_argument) {\n";
+        source += "    var accumulated_value = first_argument * " + n + " + 3.1415926;\n";
+        source += "    var message = \"string literal with \\\"escapes\\\" and spaces " + n + "\";\n";
+        source += "    for (var index = 0; index < second_argument; index += 1) {\n";
+        source += "        accumulated_value += index % 7;\n";
+        source += "    }\n";
+        source += "    return [accumulated_value, message, 'c'];\n";
+        source += "}\n\n";
+    }
+    return source;
+}
+
+static double now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char **argv) {
+    size_t size_mb = argc > 1 ? atoi(argv[1]) : DEFAULT_SIZE_MB;
+    std::string source = gen_source(size_mb << 20);
+
+    FILE *file = tmpfile();
+    if (file == NULL || fwrite(source.data(), 1, source.length(), file) != source.length()) {
+        perror("bench_tokenizer");
+        return -1;
+    }
+    fflush(file);
+
+    double best = 0;
+    long ntokens = 0;
+    for (int round = 0; round < NROUNDS; round++) {
+        // the tokenizer closes the file it reads, so map a fresh handle.
+        rewind(file);
+        FILE *handle = fdopen(dup(fileno(file)), "r");
+
+        double start = now();
+        VSTokenizer *tokenizer = new VSTokenizer(handle);
+        ntokens = 0;
+        while (tokenizer->hastoken()) {
+            VSToken *token = tokenizer->gettoken();
+            if (token == NULL) {
+                break;
+            }
+            DECREF(token);
+            ntokens++;
+        }
+        double elapsed = now() - start;
+        DECREF(tokenizer);
+
+        double mbps = source.length() / elapsed / (1 << 20);
+        best = mbps > best ? mbps : best;
+    }
+
+    printf("source: %.1f MB, tokens: %ld, best of %d: %.1f MB/s\n",
+           source.length() / (double)(1 << 20), ntokens, NROUNDS, best);
+    fclose(file);
+    return 0;
+}
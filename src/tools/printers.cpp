@@ -1,4 +1,5 @@
 #include "printers.hpp"
+#include "objects/VSFunctionObject.hpp"
 #include "objects/VSListObject.hpp"
 #include "objects/VSStringObject.hpp"
 
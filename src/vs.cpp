@@ -1,38 +1,76 @@
 #include "vs.hpp"
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 
 #include <stack>
+#include <thread>
 
 #include "compiler/VSCompiler.hpp"
+#include "compiler/VSEmitter.hpp"
 #include "objects/VSFrameObject.hpp"
 #include "objects/VSTupleObject.hpp"
 #include "printers.hpp"
 #include "runtime/builtins.hpp"
 #include "runtime/VSInterpreter.hpp"
+#include "runtime/VSJit.hpp"
 
 int main(int argc, char **argv) {
     if (argc < 2) {
-        printf("Usage: %s [-s] <file>\n", *argv);
+        printf("Usage: %s [-s] [-i] [-l] [-O<level>] [-j<threads>] [--emit-c] [--no-jit] [--perf-map] <file>\n", *argv);
         return -1;
     }
 
     argc--; argv++;
     int show_gen = 0;
-    if (**argv == '-' && (*argv)[1] == 's') {
-        show_gen = 1;
+    int show_ir = 0;
+    bool lazy = false;
+    bool emit_c = false;
+    int opt_level = VS_OPT_AST;
+    int nthreads = std::thread::hardware_concurrency();
+    while (argc > 1 && **argv == '-') {
+        if (strcmp(*argv, "--emit-c") == 0) {
+            emit_c = true;
+        } else if (strcmp(*argv, "--no-jit") == 0) {
+            vs_jit_enabled = false;
+        } else if (strcmp(*argv, "--perf-map") == 0) {
+            vs_jit_perf_map(true);
+        } else if ((*argv)[1] == 's') {
+            show_gen = 1;
+        } else if ((*argv)[1] == 'i') {
+            show_ir = 1;
+        } else if ((*argv)[1] == 'l') {
+            lazy = true;
+        } else if ((*argv)[1] == 'O') {
+            opt_level = atoi(*argv + 2);
+        } else if ((*argv)[1] == 'j') {
+            nthreads = atoi(*argv + 2);
+        } else {
+            printf("Unknown option: %s\n", *argv);
+            return -1;
+        }
         argc--;
         argv++;
     }
 
     init_printer();
-    VSCompiler *compiler = new VSCompiler(builtin_addrs);
+    FILE *ir_file = show_ir ? fopen("ir.txt", "w") : NULL;
+    VSCompiler *compiler = new VSCompiler(builtin_addrs, opt_level, ir_file, nthreads, lazy);
     VSCodeObject *program = compiler->compile(*argv);
+    if (ir_file != NULL) {
+        fclose(ir_file);
+    }
     if (show_gen) {
         FILE *f = fopen("instructions.txt", "w");
         fprint_code(f, program);
         fclose(f);
     }
+    if (emit_c) {
+        // print the program as c++ instead of running it.
+        emit_native(stdout, program);
+        return 0;
+    }
     VSFrameObject *frame = new VSFrameObject(program, NULL, new VSTupleObject(program->ncellvars), NULL, NULL);
     auto stack = std::stack<VSObject *>();
     INTERPRETER.eval(stack, frame);